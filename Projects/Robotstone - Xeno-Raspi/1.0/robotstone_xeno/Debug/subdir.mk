@@ -11,30 +11,50 @@ CPP_SRCS += \
 ../RobotSlave.cpp \
 ../RobotTask.cpp \
 ../Robotstone.cpp \
+../breakdown.cpp \
+../calibration.cpp \
+../commbench.cpp \
 ../communic.cpp \
+../histogram.cpp \
 ../main.cpp \
+../network.cpp \
 ../realtime.cpp \
 ../rtheap.cpp \
+../rtqueue.cpp \
+../rtring.cpp \
+../rtpool.cpp \
 ../rtsignal.cpp \
 ../stdout.cpp \
 ../task.cpp \
 ../test_led.cpp \
-../timer.cpp 
+../timer.cpp \
+../trace.cpp \
+../workload.cpp 
 
 OBJS += \
 ./RobotMaster.o \
 ./RobotSlave.o \
 ./RobotTask.o \
 ./Robotstone.o \
+./breakdown.o \
+./calibration.o \
+./commbench.o \
 ./communic.o \
+./histogram.o \
 ./main.o \
+./network.o \
 ./realtime.o \
 ./rtheap.o \
+./rtqueue.o \
+./rtring.o \
+./rtpool.o \
 ./rtsignal.o \
 ./stdout.o \
 ./task.o \
 ./test_led.o \
 ./timer.o \
+./trace.o \
+./workload.o \
 ./whetstone.o 
 
 C_DEPS += \
@@ -45,15 +65,25 @@ CPP_DEPS += \
 ./RobotSlave.d \
 ./RobotTask.d \
 ./Robotstone.d \
+./breakdown.d \
+./calibration.d \
+./commbench.d \
 ./communic.d \
+./histogram.d \
 ./main.d \
+./network.d \
 ./realtime.d \
 ./rtheap.d \
+./rtqueue.d \
+./rtring.d \
+./rtpool.d \
 ./rtsignal.d \
 ./stdout.d \
 ./task.d \
 ./test_led.d \
-./timer.d 
+./timer.d \
+./trace.d \
+./workload.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -26,12 +26,11 @@
 #include "RobotTask.hpp"
 #include <iostream>
 
-#include <alchemy/timer.h>
-#include <alchemy/heap.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <sched.h>
+#include <math.h>
 
 /*FUNCTIONS PROTOTYPES*/
 /*=======================================================================================*/
@@ -45,6 +44,14 @@
  */
 void ManageMasterTask(void *args);
 
+/**
+ * @brief Get the name of a node in the reports.
+ *
+ * @param node - The node number, Robotstone::masterNode or a Slave.
+ *
+ */
+static const char* NodeName(uint32_t node);
+
 
 /*CLASS METHODS*/
 /*=======================================================================================*/
@@ -54,11 +61,17 @@ void ManageMasterTask(void *args);
  *
  */
 RobotMaster::RobotMaster(void):
+				Robotstone(Robotstone::masterNode),
 				actualSlaveDeadlines(0),
 				receiverDeadlineMiss(0),
 				manTaskSuspendStatus(false),
 				expSignal("exp_sig"),
-				manTask(ManageMasterTask, RobotMaster::manTaskPriority, RobotMaster::taskManStackSize, (void*)this, 0, "")
+				manTask(ManageMasterTask, RobotMaster::manTaskPriority, RobotMaster::taskManStackSize, (void*)this, 0, ""),
+				searchMode(false),
+				actualStep(0),
+				passedUtilization(0),
+				subResults(NULL),
+				slaveResults(NULL)
 {
 
 	uint64_t baselineTaskKWIPS = (this->rawSpeed * 0.15) / 5;
@@ -74,11 +87,16 @@ RobotMaster::RobotMaster(void):
 		this->distBaselineWorkload[i] = baselineTaskKWIPS / distBaselineFrequency[i];
 	}
 
+	if(robotTRACE)
+	{
+		this->tracer.Open(robotTRACE_MASTER_FILE);
+	}
 
 	// Create the first task that manages the tests
 	// The management task will always have a id = 0, for scheduler.
 	// The object pointer is passed to task for callback the appropriate
 	// method that handle the management.
+	this->manTask.SetAffinity(robotMAN_CPU);
 	this->manTask.Start();
 }
 
@@ -103,6 +121,19 @@ void RobotMaster::RequestExperiment(uint8_t experiment)
 	getchar();
 }
 
+/**
+ * @brief Set how the experiment steps are chosen. It must be called
+ * 		  before RobotMaster::RequestExperiment.
+ *
+ * @param search - true to search the breakdown step by bisection,
+ * 				   false to increase the step one by one until a deadline is missed.
+ *
+ */
+void RobotMaster::SetSearchMode(bool search)
+{
+	this->searchMode = search;
+}
+
 /**
  * @brief Initialize the experiment parameters in Master node.
  */
@@ -117,6 +148,8 @@ void RobotMaster::InitExperiment(void)
 		this->SetExperimentUniBaseline();
 	}
 
+	this->actualStep = this->GetBaselineStep();
+
 	this->StartTasks();
 }
 
@@ -126,9 +159,6 @@ void RobotMaster::InitExperiment(void)
  */
 void RobotMaster::ManTask(void){
 
-	uint16_t hsMsg;
-
-
 		// Wait for experiment sent in main function.
 		this->manTaskSuspendStatus = true;
 		this->manTask.Suspend();
@@ -136,28 +166,42 @@ void RobotMaster::ManTask(void){
 
 		this->InitExperiment();
 
-		if((this->actualExp < Robotstone::exp1) || (this->actualExp > Robotstone::exp7))
+		if(this->actualExp == Robotstone::calculateCoreSpeed)
+		{
+			this->CalculeCoreSpeeds();
+		}
+		else if((this->actualExp < Robotstone::exp1) || (this->actualExp > Robotstone::exp7))
 		{
 			CalculeRawSpeed();
-			Stdout::Print("Raw speed in Kilo-Whetstone Instructions Per Second (KWIPS): %lld\n\n", this->GetRawSpeed());
+			this->PrintRawSpeed();
 		}
 		else
 		{
 			if(this->actualExp > Robotstone::exp3)
 			{
 
-				this->pubMan = Communic::PublishingRequest(0, sizeof(uint16_t));
-				this->subMan = Communic::SubscribingRequest(1, sizeof(uint16_t));
+				this->pubMan = Communic::PublishingRequest(0, sizeof(manMessage_t));
+				this->subMan = Communic::SubscribingRequest(1, sizeof(manMessage_t));
 
-				RealTime::Stdout::Print("Master ready to begin connection with Slave!\n");
-
-				this->HandshakeReceive(&hsMsg);
-				if(hsMsg != Robotstone::isStarted)
+				// Only the last results sent by a Slave are useful.
+				subscriberQoS_t resultsQoS = {Communic::keepLast, 1, 0, 0};
+				this->subResults = Communic::SubscribingRequest(robotRESULT_TOPIC, sizeof(nodeResults_t), Task::anyCPU, &resultsQoS);
+				this->slaveResults = (nodeResults_t *)Heap::Alloc(this->GetSlaves()*sizeof(nodeResults_t));
+				if((this->subResults == NULL) || (this->slaveResults == NULL))
 				{
-					Stdout::Print("Problem in start Hartros experiment: handshake error.\n");
+					Stdout::Print("Impossible receive the results of the Slaves.\n");
 					exit(1);
 				}
-				this->HandshakeSend((uint16_t *)&this->actualExp);
+
+				RealTime::Stdout::Print("Master ready to begin connection with %d Slaves!\n", this->GetSlaves());
+
+				// The Slaves may be started any time after the Master.
+				this->WaitCommand(Robotstone::cmdConnect, timerMAX_DELAY);
+				this->SendCommand(Robotstone::cmdExperiment, this->actualExp);
+
+				// The Slaves replicate the task set in the same processors.
+				this->SendCommand(Robotstone::cmdCPUs, RealTime::GetExecCPUS());
+				this->SendCommand(Robotstone::cmdSlaves, this->GetSlaves());
 
 				this->StartDistributedExperiment();
 			}
@@ -178,7 +222,7 @@ void RobotMaster::StartTasks(void)
 {
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->Start();
 	}
 }
 
@@ -187,7 +231,6 @@ void RobotMaster::StartTasks(void)
  */
 void RobotMaster::WaitTasksFinish(void)
 {
-	RealTime::Task::Delay(RealTime::Timer::GetPeriod());
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
 		rstoneTasks.GetValue()->Join();
@@ -203,9 +246,7 @@ void RobotMaster::WaitTasksFinish(void)
  */
 void RobotMaster::SendExperimentStatus(size_t status)
 {
-	uint16_t handMsg = status;
-
-	this->HandshakeSend(&handMsg);
+	this->SendCommand(Robotstone::cmdStatus, status);
 }
 
 /**
@@ -220,18 +261,20 @@ void RobotMaster::SendExperimentStatus(size_t status)
 void RobotMaster::StartUniExperiment(void)
 {
 	size_t test = 1;
+	double step;
 	while(1)
 	{
-		Task::Delay(Timer::GetPeriod()*3); // Wait 3 second for all tasks enters in signal wait condition.
-		this->startTasksSig.SignalizeBroad(); // Signalize all tasks (sender/receivers) to start.
+		this->WaitTasksReady();
+		this->tracer.Start(test);
+		this->ReleaseTasks(); // Release all tasks (sender/receivers) to start.
 
-		*(this->initialTime) = RealTime::Timer::GetTime();
 		// The management task will wait the task set execute until reach the test period.
 		Task::Delay(RobotMaster::testPeriod);
 
 		*(this->stopCondTask) = 1;// Signalize all tasks (sender/receivers) to finish.
 
 		this->WaitTasksFinish();
+		this->tracer.Stop();
 
 		*(this->stopCondTask) = 0;
 
@@ -239,7 +282,7 @@ void RobotMaster::StartUniExperiment(void)
 
 		this->PrintReport(test);
 
-		if(this->ExperimentDeadlineMiss() || this->experimentReachLimit)
+		if(this->experimentReachLimit || !this->NextStep(test, &step))
 		{
 			Stdout::Print("Experiment finished!!!\n");
 			break;
@@ -247,7 +290,12 @@ void RobotMaster::StartUniExperiment(void)
 
 		test++;
 
-		this->UpdateExperiment(test);
+		this->UpdateExperiment(step);
+
+		if(this->experimentReachLimit)
+		{
+			break;
+		}
 	}
 }
 
@@ -263,56 +311,65 @@ void RobotMaster::StartUniExperiment(void)
 void RobotMaster::StartDistributedExperiment(void)
 {
 	size_t test = 1;
-	uint16_t handMsg;
+	double step;
 	while(1)
 	{
-		this->HandshakeReceive(&handMsg);
+		// The clock estimate is refreshed between the test steps.
+		this->SyncClock();
+
+		// In the same machine the Slaves tasks are also waited here.
+		this->WaitTasksReady();
 
-		Task::Delay(Timer::GetPeriod()*4); // Wait 4 seconds for all tasks enters in signal wait condition.
+		// All nodes start the test step together.
+		this->Barrier(Robotstone::cmdReady, 0);
 
-		*(this->initialTime) = RealTime::Timer::GetTime();
-		this->startTasksSig.SignalizeBroad(); // Signalize all tasks (sender/receivers) to start.
+		this->tracer.Start(test);
+		Network::ClearStats();
+		Communic::ClearStats();
+
+		this->ReleaseTasks(); // Release all tasks (sender/receivers) to start.
 
 
 		// The management task will wait the task set execute until reach the test period.
 		Task::Delay(RobotMaster::testPeriod);
 
-		this->HandshakeSend(&handMsg); // wakeup the slave executable for finish its tasks.
-
 		*(this->stopCondTask) = 1;// Signalize all tasks (sender/receivers) to finish.
 
+		// The stop condition is set before, because it is shared with the Slaves tasks in the same machine.
+		this->SendCommand(Robotstone::cmdStop, 0); // wakeup the slave executables for finish their tasks.
+
 		this->WaitTasksFinish();
+		this->tracer.Stop();
 
-		this->WaitDeadlinesFromSlave();
+		this->ReceiveResults(test);
 
 		*(this->stopCondTask) = 0;
 
-		this->GetWorstCase(test);
+		this->CollectResults(test);
+		for(size_t n = 0; n <= this->GetSlaves(); ++n)
+		{
+			this->GetWorstCase(this->GetNodeResults(n));
+		}
+
+		this->StartReport(test);
 
-		if(this->ExperimentDeadlineMiss())
+		if(!this->NextStep(test, &step))
 		{
-			this->StartReport(test);
 			this->SendExperimentStatus(RobotMaster::isFinished);
 			Stdout::Print("Experiment finished!!!\n");
 			Stdout::Print("Experiment deadlines: %d.\n!!!\n", this->ExperimentDeadlineMiss());
 			break;
 		}
 
-		this->StartReport(test);
 		this->SendExperimentStatus(RobotMaster::isRun);
 		test++;
 
-		this->UpdateExperiment(test);
+		this->UpdateExperiment(step);
 
 		if(this->experimentReachLimit)
 		{
 			break;
 		}
-
-		led_TurnOn(8);
-		for(int k = 0; k < 99999999; ++k);
-		led_TurnOff(8);
-		for(int k = 0; k < 99999999; ++k);
 	}
 }
 
@@ -327,30 +384,197 @@ size_t RobotMaster::ExperimentDeadlineMiss(void)
 	return this->actualDeadlineMiss + this->actualSlaveDeadlines;
 }
 
+/**
+ * @brief Choose the step of the next test from the results of the actual test.
+ *
+ * 		  In the linear mode the step is the next test number and the experiment
+ * 		  finishes in the first deadline missed. In the search mode the steps are
+ * 		  chosen by a BreakdownSearch and a deadline missed only narrows the search.
+ * 		  The steps are the same in both modes, e.g. step 2.5 in experiment 1 is
+ * 		  the baseline KWIPP multiplied by 1.25, between tests 2 and 3 of the linear mode.
+ *
+ * @param test - The actual test number.
+ * @param step - Where the next step is saved.
+ *
+ * @return - true if the experiment continues with the next step;
+ * 		   - false if the experiment finished.
+ */
+bool RobotMaster::NextStep(size_t test, double *step)
+{
+	bool missed = (this->ExperimentDeadlineMiss() != 0);
+	bool discrete = (this->actualExp == Robotstone::exp3) || (this->actualExp == Robotstone::exp7);
+
+	if(!this->searchMode)
+	{
+		*step = test + 1;
+		return !missed;
+	}
+
+	if(test == 1)
+	{
+		if(missed)
+		{
+			Stdout::Print("The baseline task set misses deadlines: there is nothing to search.\n");
+			return false;
+		}
+
+		this->search.Start(this->actualStep, 2, this->GetStepLimit(), robotSEARCH_PRECISION, discrete);
+	}
+
+	if(!missed)
+	{
+		this->passedUtilization = this->GetTotalUtilization();
+	}
+
+	if(!this->search.Next(this->actualStep, missed, step))
+	{
+		this->PrintSearchResult();
+		return false;
+	}
+
+	// The Slave receives the step rounded by the handshake message.
+	*step = Robotstone::DecodeStep(Robotstone::EncodeStep(*step));
+	return true;
+}
+
+/**
+ * @brief Get the step equivalent to the baseline task set of the actual experiment.
+ *
+ * @return The baseline step.
+ */
+double RobotMaster::GetBaselineStep(void)
+{
+	switch(this->actualExp)
+	{
+	case Robotstone::exp3:
+	case Robotstone::exp7:
+		return 1;
+	case Robotstone::exp5:
+		// The step where the message length is the baseline one.
+		return log2((double)Robotstone::baselineMessageSizeExpDist) - 1;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief Get the biggest step of the actual experiment in the search mode.
+ *
+ * @return The step limit.
+ */
+double RobotMaster::GetStepLimit(void)
+{
+	double limit;
+
+	switch(this->actualExp)
+	{
+	case Robotstone::exp3:
+		limit = (robotMAX_TASK_ID - Robotstone::baselineNumberExpUni*RealTime::GetExecCPUS())/RealTime::GetExecCPUS() + 1;
+		break;
+	case Robotstone::exp5:
+		return log2((double)RobotTask::maxMessageSize) - 1;
+	case Robotstone::exp7:
+		limit = (robotMAX_TASK_ID - Robotstone::baselineNumberExpDist*RealTime::GetExecCPUS())/RealTime::GetExecCPUS() + 1;
+		break;
+	default:
+		return Robotstone::DecodeStep(0xFFFFFFFF);
+	}
+
+	// The step must also fit in the handshake message.
+	return (limit < Robotstone::DecodeStep(0xFFFFFFFF))? limit : Robotstone::DecodeStep(0xFFFFFFFF);
+}
+
+/**
+ * @brief Get the CPU utilization of the Master tasks in the actual test.
+ *
+ * @return The average utilization of the processors in percentage value.
+ */
+double RobotMaster::GetTotalUtilization(void)
+{
+	double total = 0;
+
+	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
+	{
+		total += rstoneTasks.GetValue()->GetUtilization(this->GetRawSpeed());
+	}
+
+	return total/RealTime::GetExecCPUS();
+}
+
+/**
+ * @brief Prints the breakdown point found by the search mode.
+ */
+void RobotMaster::PrintSearchResult(void)
+{
+	Stdout::Print("========================================================================\n\n");
+	Stdout::Print("Breakdown search of experiment %d:\n\n", this->actualExp);
+	Stdout::Print("Tests executed: %d\n", this->search.GetTestsNumber());
+	Stdout::Print("Precision (steps): %f\n", this->search.GetPrecision());
+	Stdout::Print("Last step without deadlines missed: %f\n", this->search.GetLastPassed());
+	Stdout::Print("CPU utilization in this step: %f%%\n", this->passedUtilization);
+
+	if(this->search.IsBracketed())
+	{
+		Stdout::Print("First step with deadlines missed: %f\n", this->search.GetFirstMissed());
+		Stdout::Print("The linear mode would finish in test %d.\n", (size_t)ceil(this->search.GetFirstMissed()));
+	}
+	else
+	{
+		Stdout::Print("No deadline missed up to the experiment limit.\n");
+	}
+	Stdout::Print("\n========================================================================\n\n");
+}
+
+/**
+ * @brief Prints the step of the actual test in the search mode.
+ */
+void RobotMaster::PrintStep(void)
+{
+	if(this->searchMode)
+	{
+		Stdout::Print("Breakdown search step: %f\n\n", this->actualStep);
+	}
+}
+
 /**
  * @brief Set all the parameters and configurations to initialize the
  * 		  baseline tasks related to PD experiments.
  */
 void RobotMaster::SetExperimentUniBaseline()
 {
-
-	for(int i = 0; i < Robotstone::baselineNumberExpUni; i++)
+	// In partitioned multicore mode each processor runs a copy of the task set.
+	for(size_t cpu = 0; cpu < RealTime::GetExecCPUS(); cpu++)
 	{
-		void *p = Heap::Alloc(sizeof(RobotTask));
+		for(int i = 0; i < Robotstone::baselineNumberExpUni; i++)
+		{
+			void *p = Heap::Alloc(sizeof(RobotTask));
+
+			if(p == NULL)
+			{
+				Stdout::Print("Impossible create Baseline Tasks.\nExiting experiment...");
+				exit(1);
+			}
 
-		//Hartros::baselinePriorityExpUni+(Hartros::baselineNumberExpUni-(i+1)),
-		// make the actual task with high priority than next task
-		RobotTask *taskHandler = new(p) RobotTask(i+1,
-												Robotstone::baselinePriorityExpUni+(Robotstone::baselineNumberExpUni-(i+1)),
-												&this->startTasksSig,
-												this->stopCondTask,
-												this->initialTime,
-												"");
+			//Hartros::baselinePriorityExpUni+(Hartros::baselineNumberExpUni-(i+1)),
+			// make the actual task with high priority than next task
+			RobotTask *taskHandler = new(p) RobotTask(cpu*Robotstone::baselineNumberExpUni+i+1,
+													Robotstone::baselinePriorityExpUni+(Robotstone::baselineNumberExpUni-(i+1)),
+													&this->startBarrier,
+													this->stopCondTask,
+													"");
 
-		taskHandler->SetKWIPP(uniBaselineWorkload[i]);
-		taskHandler->SetFrequency(uniBaselineFrequency[i]);
+			taskHandler->SetCPU(cpu);
+			taskHandler->SetKWIPP(uniBaselineWorkload[i]);
+			taskHandler->SetFrequency(uniBaselineFrequency[i]);
 
-		this->rstoneTasks.InsertTail(taskHandler);
+			taskHandler->SetWorkload(this->CreateWorkload());
+			if(this->tracer.Register(taskHandler->GetTraceRing()) != RealTime::ok)
+			{
+				Stdout::Print("Impossible create Baseline Tasks.\nExiting experiment...");
+				exit(1);
+			}
+			this->rstoneTasks.InsertTail(taskHandler);
+		}
 	}
 
 }
@@ -362,66 +586,88 @@ void RobotMaster::SetExperimentUniBaseline()
 void RobotMaster::SetExperimentDistBaseline(){
 
 	char *taskName;
+	size_t id;
 
-	for(int i = 0; i < RobotMaster::baselineNumberExpDist; i++)
+	// In partitioned multicore mode each processor runs a copy of the task set,
+	// publishing in its own topics.
+	for(size_t cpu = 0; cpu < RealTime::GetExecCPUS(); cpu++)
 	{
-		taskName = (char*)RealTime::Heap::Alloc(sizeof("Tpxx"));
-
-		if(taskName == NULL)
+		for(int i = 0; i < RobotMaster::baselineNumberExpDist; i++)
 		{
-			exit(1);
-		}
-		sprintf(taskName, "Tp%d", i+1);
+			id = cpu*RobotMaster::baselineNumberExpDist+i+1;
 
-		void *p = Heap::Alloc(sizeof(RobotTask));
+			taskName = (char*)RealTime::Heap::Alloc(sizeof("Tpxx"));
 
-		RobotTask *taskHandler = new(p) RobotTask(i+1,
-												Robotstone::baselinePriorityExpDist+(Robotstone::baselineNumberExpDist-(i+1)),
-												&this->startTasksSig,
-												this->stopCondTask,
-												this->initialTime,
-												taskName);
+			if(taskName == NULL)
+			{
+				exit(1);
+			}
+			snprintf(taskName, sizeof("Tpxx"), "Tp%d", (int)id);
 
-		taskHandler->SetKWIPP(distBaselineWorkload[i]);
+			void *p = Heap::Alloc(sizeof(RobotTask));
 
-		taskHandler->SetFrequency(distBaselineFrequency[i]);
+			if(p == NULL)
+			{
+				Stdout::Print("Impossible create Baseline Tasks.\nExiting experiment...");
+				exit(1);
+			}
 
-		taskHandler->PublishingRequest(i+2, RobotMaster::baselineMessageSizeExpDist);
+			RobotTask *taskHandler = new(p) RobotTask(id,
+													Robotstone::baselinePriorityExpDist+(Robotstone::baselineNumberExpDist-(i+1)),
+													&this->startBarrier,
+													this->stopCondTask,
+													taskName);
 
-		this->rstoneTasks.InsertTail(taskHandler);
+			taskHandler->SetCPU(cpu);
+			taskHandler->SetKWIPP(distBaselineWorkload[i]);
+
+			taskHandler->SetFrequency(distBaselineFrequency[i]);
+
+			taskHandler->PublishingRequest(id+1, RobotMaster::baselineMessageSizeExpDist);
+
+			taskHandler->SetWorkload(this->CreateWorkload());
+			if(this->tracer.Register(taskHandler->GetTraceRing()) != RealTime::ok)
+			{
+				Stdout::Print("Impossible create Baseline Tasks.\nExiting experiment...");
+				exit(1);
+			}
+			this->rstoneTasks.InsertTail(taskHandler);
+		}
 	}
 }
 
 /**
  * @brief Update the actual experiment step test.
  *
- * @param test - test step number.
+ * @param step - experiment step, the test number in the linear mode.
  *
  */
-void RobotMaster::UpdateExperiment(size_t test)
+void RobotMaster::UpdateExperiment(double step)
 {
+	this->actualStep = step;
+
 	switch(this->actualExp)
 	{
 	case Robotstone::exp1:
-		this->UpdateExp1(test);
+		this->UpdateExp1(step);
 		break;
 	case Robotstone::exp2:
-		this->UpdateExp2(test);
+		this->UpdateExp2(step);
 		break;
 	case Robotstone::exp3:
-		this->UpdateExp3(test);
+		this->UpdateExp3(step);
 		break;
 	case Robotstone::exp4:
-		this->UpdateExp4(test);
+		this->UpdateExp4(step);
 		break;
 	case Robotstone::exp5:
-		this->UpdateExp5(test);
+		this->UpdateExp5(step);
 		break;
 	case Robotstone::exp6:
-		this->UpdateExp6(test);
+		this->UpdateExp6(step);
 		break;
 	case Robotstone::exp7:
-		this->UpdateExp7(test);
+		this->UpdateExp7(step);
 		break;
 
 	}
@@ -430,19 +676,19 @@ void RobotMaster::UpdateExperiment(size_t test)
 /**
  * @brief Update the actual Experiment 1 step test.
  *
- * @param test - test step number.
+ * @param step - experiment step.
  *
  */
-void RobotMaster::UpdateExp1(size_t test)
+void RobotMaster::UpdateExp1(double step)
 {
 	int i = 0;
 
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
-		rstoneTasks.GetValue()->SetKWIPP(this->uniBaselineWorkload[i] * (1 + ((double)test)*0.1));
+		rstoneTasks.GetValue()->SetKWIPP(this->uniBaselineWorkload[i % Robotstone::baselineNumberExpUni] * (1 + step*0.1));
 		rstoneTasks.GetValue()->ClearMeasurements();
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->Start();
 		++i;
 	}
 }
@@ -450,18 +696,18 @@ void RobotMaster::UpdateExp1(size_t test)
 /**
  * @brief Update the actual Experiment 2 step test.
  *
- * @param test - test step number.
+ * @param step - experiment step.
  *
  */
-void RobotMaster::UpdateExp2(size_t test)
+void RobotMaster::UpdateExp2(double step)
 {
 	int i = 0;
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
-		rstoneTasks.GetValue()->SetFrequency(uniBaselineFrequency[i]*(1 + ((double)test)*0.1));
+		rstoneTasks.GetValue()->SetFrequency(uniBaselineFrequency[i % Robotstone::baselineNumberExpUni]*(1 + step*0.1));
 		rstoneTasks.GetValue()->ClearMeasurements();
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->Start();
 
 		++i;
 	}
@@ -470,53 +716,96 @@ void RobotMaster::UpdateExp2(size_t test)
 /**
  * @brief Update the actual Experiment 3 step test.
  *
- * @param test - test step number.
+ * @param step - experiment step.
  *
  */
-void RobotMaster::UpdateExp3(size_t test)
+void RobotMaster::UpdateExp3(double step)
 {
-	static int i = 1;
+	static size_t taskId = Robotstone::baselineNumberExpUni*RealTime::GetExecCPUS() + 1;
+	static size_t added = 0; // Tasks added to the baseline in the list.
+	size_t target = ((size_t)step - 1)*RealTime::GetExecCPUS(); // One new task in each processor by step.
+	RobotTask *taskHandler;
+
+	// The search mode may go back to a smaller step: the tasks in excess are parked.
+	while(added > target)
+	{
+		taskHandler = this->rstoneTasks.RemoveTail();
+		taskHandler->SetActive(false);
+		this->spareTasks.InsertHead(taskHandler);
+		added--;
+	}
+
+	while(added < target)
+	{
+		if(!this->spareTasks.IsEmpty())
+		{
+			taskHandler = this->spareTasks.RemoveHead();
+			taskHandler->SetActive(true);
+		}
+		else
+		{
+			void *p = Heap::Alloc(sizeof(RobotTask));
 
-	void *p = Heap::Alloc(sizeof(RobotTask));
+			if(p == NULL)
+			{
+				break;
+			}
 
-	// make the actual task with priority equal to task 3
-	RobotTask *taskHandler = new(p) RobotTask(5+i,
+			// make the actual task with priority equal to task 3
+			taskHandler = new(p) RobotTask(taskId,
 											Robotstone::baselinePriorityExpUni+2,
-											&this->startTasksSig,
+											&this->startBarrier,
 											this->stopCondTask,
-											this->initialTime,
 											"");
-	taskHandler->SetKWIPP(uniBaselineWorkload[2]);
-	taskHandler->SetFrequency(uniBaselineFrequency[2]);
-	this->rstoneTasks.InsertTail(taskHandler);
-	++i;
+			taskHandler->SetCPU((taskId - 1) % RealTime::GetExecCPUS());
+			taskHandler->SetKWIPP(uniBaselineWorkload[2]);
+			taskHandler->SetFrequency(uniBaselineFrequency[2]);
+			taskHandler->SetWorkload(this->CreateWorkload());
+			if(this->tracer.Register(taskHandler->GetTraceRing()) != RealTime::ok)
+			{
+				taskHandler->~RobotTask();
+				Heap::Free(p);
+				break;
+			}
+			++taskId;
+		}
+		this->rstoneTasks.InsertTail(taskHandler);
+		added++;
+	}
+
+	if(added < target)
+	{
+		this->experimentReachLimit = 1;
+		Stdout::Print("\n\nExperiment reach limit: Impossible create more tasks!!!\n\n");
+		Stdout::Print("Experiment finished!!!\n");
+		return;
+	}
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
 		rstoneTasks.GetValue()->ClearMeasurements();
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->Start();
 	}
 }
 
 /**
  * @brief Update the actual Experiment 4 step test.
  *
- * @param test - test step number.
+ * @param step - experiment step.
  *
  */
-void RobotMaster::UpdateExp4(size_t test)
+void RobotMaster::UpdateExp4(double step)
 {
 	int i = 0;
-	uint16_t resMsg;
 
-	this->HandshakeReceive(&resMsg);
-	this->HandshakeSend(&resMsg);
+	this->WaitCommand(Robotstone::cmdUpdate);
+	this->SendCommand(Robotstone::cmdStep, Robotstone::EncodeStep(step));
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
-		rstoneTasks.GetValue()->SetKWIPP(this->distBaselineWorkload[i] * (1 + ((double)test)*0.1));
+		rstoneTasks.GetValue()->SetKWIPP(this->distBaselineWorkload[i % Robotstone::baselineNumberExpDist] * (1 + step*0.1));
 		rstoneTasks.GetValue()->ClearMeasurements();
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->Start();
 		++i;
 	}
 }
@@ -524,13 +813,12 @@ void RobotMaster::UpdateExp4(size_t test)
 /**
  * @brief Update the actual Experiment 5 step test.
  *
- * @param test - test step number.
+ * @param step - experiment step.
  *
  */
-void RobotMaster::UpdateExp5(size_t test)
+void RobotMaster::UpdateExp5(double step)
 {
 	size_t topic_i = 2;
-	uint16_t resMsg;
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
@@ -538,13 +826,13 @@ void RobotMaster::UpdateExp5(size_t test)
 		rstoneTasks.GetValue()->ClearMeasurements();
 	}
 
-	this->HandshakeReceive(&resMsg);
-	this->HandshakeSend(&resMsg);
+	this->WaitCommand(Robotstone::cmdUpdate);
+	this->SendCommand(Robotstone::cmdStep, Robotstone::EncodeStep(step));
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
-		rstoneTasks.GetValue()->PublishingRequest(topic_i, rstoneEXP5_UPDATE_VALUE(test));
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->PublishingRequest(topic_i, rstoneEXP5_UPDATE_VALUE(step));
+		rstoneTasks.GetValue()->Start();
 
 		topic_i++;
 	}
@@ -553,22 +841,21 @@ void RobotMaster::UpdateExp5(size_t test)
 /**
  * @brief Update the actual Experiment 6 step test.
  *
- * @param test - test step number.
+ * @param step - experiment step.
  *
  */
-void RobotMaster::UpdateExp6(size_t test)
+void RobotMaster::UpdateExp6(double step)
 {
-	uint16_t resMsg;
 	int i = 0;
 
-	this->HandshakeReceive(&resMsg);
-	this->HandshakeSend(&resMsg);
+	this->WaitCommand(Robotstone::cmdUpdate);
+	this->SendCommand(Robotstone::cmdStep, Robotstone::EncodeStep(step));
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
-		rstoneTasks.GetValue()->SetFrequency(rstoneEXP6_UPDATE_VALUE(test, i));
+		rstoneTasks.GetValue()->SetFrequency(rstoneEXP6_UPDATE_VALUE(step, i % Robotstone::baselineNumberExpDist));
 		rstoneTasks.GetValue()->ClearMeasurements();
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->Start();
 
 		++i;
 	}
@@ -577,30 +864,28 @@ void RobotMaster::UpdateExp6(size_t test)
 /**
  * @brief Update the actual Experiment 7 step test.
  *
- * @param test - test step number.
+ * @param step - experiment step.
  *
  */
-void RobotMaster::UpdateExp7(size_t test)
+void RobotMaster::UpdateExp7(double step)
 {
-	uint16_t resMsg;
+	// The Slaves add or park receivers after knowing the step.
+	this->WaitCommand(Robotstone::cmdUpdate);
+	this->SendCommand(Robotstone::cmdStep, Robotstone::EncodeStep(step));
 
-	this->HandshakeReceive(&resMsg);
-	if(resMsg == 1)
+	if(this->Barrier(Robotstone::cmdLimit, 0) == 1)
 	{
 		this->experimentReachLimit = 1;
 		Stdout::Print("\n\nExperiment reach limit: Impossible create more receivers tasks!!!\n\n");
-		this->HandshakeSend(&resMsg);
 		Stdout::Print("Experiment finished!!!\n");
 		Stdout::Print("Experiment deadlines: %d.\n!!!\n", this->ExperimentDeadlineMiss());
 		return;
 	}
 
-	this->HandshakeSend(&resMsg);
-
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
 		rstoneTasks.GetValue()->ClearMeasurements();
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->Start();
 	}
 }
 
@@ -628,23 +913,74 @@ void RobotMaster::StartReport(size_t test)
 {
 	this->CalculateDeadlineMiss();
 
-	this->WaitDeadlinesFromSlave();
-
 	this->PrintReport(test);
 }
 
 /**
- * @brief Wait from Slave a Signal with the number of deadlines missed.
+ * @brief Receive the results of the tasks of all Slaves in the test step.
+ *
+ * 		  Each Slave announces its results by a Robotstone::cmdResults with the
+ * 		  number of deadlines missed. The Slaves are asked one after the other
+ * 		  to publish them, by a Robotstone::cmdResults with 0, which is sent
+ * 		  again while the results of the test step don't arrive in
+ * 		  Robotstone::resultTimeout, up to Robotstone::commandTimeout.
+ * 		  The Slave is released by a 1.
+ *
+ * @param test - test step number.
+ *
  */
-void RobotMaster::WaitDeadlinesFromSlave(void)
+void RobotMaster::ReceiveResults(size_t test)
 {
-	uint16_t res;
+	nodeResults_t *slave;
+	timeCount_t start, first;
+	bool received;
+
+	this->actualSlaveDeadlines = 0;
 
-	HandshakeReceive(&res);
+	for(size_t i = 0; i < this->GetSlaves(); ++i)
+	{
+		slave = &this->slaveResults[i];
+		this->slaveDeadlines[i] = this->WaitCommandFrom(i, Robotstone::cmdResults);
+		this->actualSlaveDeadlines += this->slaveDeadlines[i];
+
+		first = Timer::GetTime();
+		do
+		{
+			// The Slave may acknowledge the requests while its results never arrive intact.
+			if(Timer::GetTime() - first >= Robotstone::commandTimeout)
+			{
+				Stdout::Print("Management protocol error: command %d not received from node %d.\n",
+							  Robotstone::cmdResults, this->GetPeerNode(i));
+				exit(1);
+			}
 
-	HandshakeReceive(&res);
+			this->SendCommandTo(i, Robotstone::cmdResults, 0);
 
-	this->actualSlaveDeadlines =  res;
+			received = false;
+			start = Timer::GetTime();
+			while(!received && (Timer::GetTime() - start < Robotstone::resultTimeout))
+			{
+				// A copy of the results of a previous test step may be read before.
+				received = (this->subResults->Receive(slave, Robotstone::resultTimeout - (Timer::GetTime() - start)) != 0) &&
+						   (slave->test == test) && (slave->node == this->GetPeerNode(i));
+			}
+		}
+		while(!received);
+
+		this->SendCommandTo(i, Robotstone::cmdResults, 1);
+	}
+}
+
+/**
+ * @brief Get the results of the tasks of a node in the last test step.
+ *
+ * @param node - The node number, Robotstone::masterNode or a Slave.
+ *
+ * @return The node results.
+ */
+const nodeResults_t* RobotMaster::GetNodeResults(size_t node)
+{
+	return (node == Robotstone::masterNode)? this->results : &this->slaveResults[node - 1];
 }
 
 /**
@@ -662,12 +998,14 @@ void RobotMaster::PrintExpUniReport(size_t test)
 
 	Stdout::Print("========================================================================\n\n");
 	Stdout::Print("Underlay Software Architecture:\n" robotRT_NAME "\n");
-	Stdout::Print("Raw speed in Kilo-Whetstone Instructions Per Second (KWIPS): %lld\n\n", this->GetRawSpeed());
+	this->PrintRawSpeed();
+	this->PrintPartitions();
 	Stdout::Print("Executable Control: ");
 
 	Stdout::Print("Master\n\n");
 
 	Stdout::Print("Experiment: %d\n\n", this->actualExp);
+	this->PrintStep();
 	Stdout::Print("Test %d characteristics:\n\n", test);
 	Stdout::Print("Task\tFrequency(Hz)\tKWIPP\tKWIPS\t\tCPU Utilization\n");
 
@@ -744,6 +1082,9 @@ void RobotMaster::PrintExpUniReport(size_t test)
 															rstoneTasks.GetValue()->GetWCRJ());
 	}
 
+	this->PrintPercentiles();
+	this->PrintTraceStatus();
+
 	Stdout::Print("\n\n========================================================================\n\n\n\n");
 
 #ifdef	hartEXTRA_VISUALIZATION
@@ -771,41 +1112,62 @@ void RobotMaster::PrintExpUniReport(size_t test)
  */
 void RobotMaster::PrintExpDistReport(size_t test)
 {
-	float totalKWIPS = 0, totalCPU = 0;
+	const nodeResults_t *node;
+	const taskResult_t *task;
+	float totalKWIPS, totalCPU;
 
 	Stdout::Print("========================================================================\n\n");
 	Stdout::Print("Underlay Software Architecture:\n" robotRT_NAME "\n");
-	Stdout::Print("Raw speed in Kilo-Whetstone Instructions Per Second (KWIPS): %lld\n\n", this->GetRawSpeed());
+	this->PrintRawSpeed();
+	this->PrintPartitions();
+	this->PrintDelivery();
+	this->PrintClockSync();
 	Stdout::Print("Executable Control: ");
 
-	Stdout::Print("Master\n\n");
+	Stdout::Print("Master of %d Slaves\n\n", this->GetSlaves());
 
 	Stdout::Print("Experiment: %d\n\n", this->actualExp);
+	this->PrintStep();
 	Stdout::Print("Test %d characteristics:\n\n", test);
 
-	Stdout::Print("Task\tFrequency(Hz)\tKWIPP\tKWIPS\t\tCPU Utilization\n");
+	// The utilization of each node is relative to its own raw speed.
+	Stdout::Print("Node\tTask\tFrequency(Hz)\tKWIPP\tKWIPS\t\tCPU Utilization\n");
 
-	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
+	for(size_t n = 0; n <= this->GetSlaves(); ++n)
 	{
-		Stdout::Print("%d\t%f\t%d\t%f\t%f%\n", rstoneTasks.GetValue()->GetID(),
-														 rstoneTasks.GetValue()->GetFrequency(),
-														 rstoneTasks.GetValue()->GetKWIPP(),
-														 rstoneTasks.GetValue()->GetKWIPS(),
-														 rstoneTasks.GetValue()->GetUtilization(this->GetRawSpeed()));
-		totalKWIPS += rstoneTasks.GetValue()->GetKWIPS();
-		totalCPU += rstoneTasks.GetValue()->GetUtilization(this->GetRawSpeed());
-	}
+		node = this->GetNodeResults(n);
+		totalKWIPS = 0;
+		totalCPU = 0;
+		for(uint32_t i = 0; i < node->number; ++i)
+		{
+			task = &node->tasks[i];
+			Stdout::Print("%s\t%d\t%f\t%d\t%f\t%f%\n", NodeName(node->node),
+															 task->taskID,
+															 task->frequency,
+															 task->kwipp,
+															 task->kwips,
+															 task->utilization);
+			totalKWIPS += task->kwips;
+			totalCPU += task->utilization;
+		}
 
-	Stdout::Print("\t\t\t\t-------\t\t-------\n");
-	Stdout::Print("\t\t\t\t%f\t%f%\n\n", totalKWIPS, totalCPU);
+		Stdout::Print("\t\t\t\t\t-------\t\t-------\n");
+		Stdout::Print("\t\t\t\t\t%f\t%f%\n\n", totalKWIPS, totalCPU);
+	}
 
-	Stdout::Print("Task\tMessage Length (B)\tTopic\n");
+	Stdout::Print("Node\tTask\tMessage Length (B)\tTopic\n");
 
-	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
+	for(size_t n = 0; n <= this->GetSlaves(); ++n)
 	{
-		Stdout::Print("%d\t%d\t\t\t%d\n", rstoneTasks.GetValue()->GetID(),
-														 rstoneTasks.GetValue()->GetPubMessageSize(),
-														 rstoneTasks.GetValue()->GetPubTopic());
+		node = this->GetNodeResults(n);
+		for(uint32_t i = 0; i < node->number; ++i)
+		{
+			task = &node->tasks[i];
+			Stdout::Print("%s\t%d\t%d\t\t\t%d\n", NodeName(node->node),
+															 task->taskID,
+															 task->messageSize,
+															 task->topic);
+		}
 	}
 
 
@@ -836,7 +1198,8 @@ void RobotMaster::PrintExpDistReport(size_t test)
 		break;
 	case Robotstone::exp7:
 		Stdout::Print("Experiment step: Increase one task with the same\n");
-		Stdout::Print("\t\t\tparameters of medium priority subscriber task on Slave.\n");
+		Stdout::Print("\t\t\tparameters of medium priority subscriber task,\n");
+		Stdout::Print("\t\t\tin the Slaves in turn.\n");
 		break;
 	}
 
@@ -845,32 +1208,16 @@ void RobotMaster::PrintExpDistReport(size_t test)
 	Stdout::Print("Test %d results:\n\n", test);
 	Stdout::Print("Test duration (seconds): %lld\n\n", this->testPeriod/Timer::GetPeriod());
 
-	Stdout::Print("Task\tPeriod(s)\tMet\t\tMissed\t\tSkipped\t\n");
-	Stdout::Print("    \t         \tdeadlines\tdeadlines\tdeadlines\n");
+	this->PrintTaskResults();
+	Communic::PrintStats();
+	this->PrintTraceStatus();
+	Network::PrintReport();
 
-	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
-	{
-		Stdout::Print("%d\t%f\t%d\t\t%d\t\t%d\n", rstoneTasks.GetValue()->GetID(),
-															  rstoneTasks.GetValue()->GetPeriodSec(),
-															  rstoneTasks.GetValue()->GetDeadlineMet(),
-															  rstoneTasks.GetValue()->GetDeadlineMiss(),
-															  rstoneTasks.GetValue()->GetDeadlineSkip());
-	}
-
-	Stdout::Print("\nTask\tAverage (s)\tWCRT (s)\tAverage (s)\tWCRJ (s)\n");
-	Stdout::Print("    \tResp. Time\t    \t\tResp. Jitter\n");
-
-	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
-	{
-		Stdout::Print("%d\t%f\t%f\t%f\t%f\n", rstoneTasks.GetValue()->GetID(),
-															rstoneTasks.GetValue()->GetResponseTime(),
-															rstoneTasks.GetValue()->GetWCRT(),
-															rstoneTasks.GetValue()->GetResponseJitter(),
-															rstoneTasks.GetValue()->GetWCRJ());
-	}
+	this->PrintWorstCaseAnalysis();
 
 	Stdout::Print("\nScenario with worst WCRT in relation with average:\n");
 	Stdout::Print("- Test: %d\n", worstScenario.test);
+	Stdout::Print("- Node: %s\n", NodeName(worstScenario.node));
 	Stdout::Print("- Task: %d\n", worstScenario.taskID);
 	Stdout::Print("- WCRT: %f seconds\n", worstScenario.wcrt);
 	Stdout::Print("- Aver. Response: %f seconds\n", worstScenario.averageResp);
@@ -878,6 +1225,27 @@ void RobotMaster::PrintExpDistReport(size_t test)
 	Stdout::Print("\nTotal of Deadlines Misses by Receivers: %d", this->actualSlaveDeadlines);
 	Stdout::Print("\n\n========================================================================\n\n");
 
+#ifdef	robotEXTRA_VISUALIZATION
+	for(size_t n = 1; n <= this->GetSlaves(); ++n)
+	{
+		node = this->GetNodeResults(n);
+		for(uint32_t i = 0; i < node->number; ++i)
+		{
+			task = &node->tasks[i];
+			Stdout::Print("\t\t\t\t\t\t\t\t\t\t%d %d %f %d %d %d %f %f %f %f\n", node->node,
+																		   task->taskID,
+																		   task->period,
+																		   task->deadlineMet,
+																		   task->deadlineMiss,
+																		   task->deadlineSkip,
+																		   task->responseTime,
+																		   task->wcrt,
+																		   task->responseJitter,
+																		   task->wcrt - task->bcrt);
+		}
+	}
+#endif
+
 #ifdef	hartEXTRA_VISUALIZATION
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
@@ -896,6 +1264,179 @@ void RobotMaster::PrintExpDistReport(size_t test)
 
 }
 
+/**
+ * @brief Prints the deadlines, response times and percentiles of the
+ * 		  tasks of all nodes in the test step.
+ *
+ */
+void RobotMaster::PrintTaskResults(void)
+{
+	const nodeResults_t *node;
+	const taskResult_t *task;
+
+	Stdout::Print("Node\tTask\tPeriod(s)\tMet\t\tMissed\t\tSkipped\t\n");
+	Stdout::Print("    \t    \t         \tdeadlines\tdeadlines\tdeadlines\n");
+
+	for(size_t n = 0; n <= this->GetSlaves(); ++n)
+	{
+		node = this->GetNodeResults(n);
+		for(uint32_t i = 0; i < node->number; ++i)
+		{
+			task = &node->tasks[i];
+			Stdout::Print("%s\t%d\t%f\t%d\t\t%d\t\t%d\n", NodeName(node->node),
+																  task->taskID,
+																  task->period,
+																  task->deadlineMet,
+																  task->deadlineMiss,
+																  task->deadlineSkip);
+		}
+	}
+
+	Stdout::Print("\nNode\tTask\tAverage (s)\tWCRT (s)\tBCRT (s)\tAverage (s)\tWCRJ (s)\n");
+	Stdout::Print("    \t    \tResp. Time\t    \t\t    \t\tResp. Jitter\n");
+
+	for(size_t n = 0; n <= this->GetSlaves(); ++n)
+	{
+		node = this->GetNodeResults(n);
+		for(uint32_t i = 0; i < node->number; ++i)
+		{
+			task = &node->tasks[i];
+			Stdout::Print("%s\t%d\t%f\t%f\t%f\t%f\t%f\n", NodeName(node->node),
+																task->taskID,
+																task->responseTime,
+																task->wcrt,
+																task->bcrt,
+																task->responseJitter,
+																task->wcrt - task->bcrt);
+		}
+	}
+
+	Stdout::Print("\nNode\tTask\tResp. Time (s)\n");
+	Stdout::Print("    \t    \tp50\t\tp90\t\tp99\t\tp99.9\t\tp99.99\n");
+
+	for(size_t n = 0; n <= this->GetSlaves(); ++n)
+	{
+		node = this->GetNodeResults(n);
+		for(uint32_t i = 0; i < node->number; ++i)
+		{
+			task = &node->tasks[i];
+			Stdout::Print("%s\t%d", NodeName(node->node), task->taskID);
+			for(size_t p = 0; p < sizeof(reportPercentiles)/sizeof(reportPercentiles[0]); ++p)
+			{
+				Stdout::Print("\t%f", this->GetResultPercentile(&task->responseTimeHist, reportPercentiles[p]));
+			}
+			Stdout::Print("\n");
+		}
+	}
+
+	Stdout::Print("\nNode\tTask\tResp. Jitter (s)\n");
+	Stdout::Print("    \t    \tp50\t\tp90\t\tp99\t\tp99.9\t\tp99.99\n");
+
+	for(size_t n = 0; n <= this->GetSlaves(); ++n)
+	{
+		node = this->GetNodeResults(n);
+		for(uint32_t i = 0; i < node->number; ++i)
+		{
+			task = &node->tasks[i];
+			Stdout::Print("%s\t%d", NodeName(node->node), task->taskID);
+			for(size_t p = 0; p < sizeof(reportPercentiles)/sizeof(reportPercentiles[0]); ++p)
+			{
+				Stdout::Print("\t%f", this->GetResultPercentile(&task->responseJitterHist, reportPercentiles[p]));
+			}
+			Stdout::Print("\n");
+		}
+	}
+
+	for(size_t n = 1; n <= this->GetSlaves(); ++n)
+	{
+		node = this->GetNodeResults(n);
+		if(node->total > node->number)
+		{
+			Stdout::Print("\n%d tasks of the %s are not in the results (maximum of %d).\n",
+						  node->total - node->number, NodeName(node->node), robotRESULT_MAX_TASKS);
+		}
+	}
+}
+
+/**
+ * @brief Prints the worst cases of the test step among the tasks of all nodes:
+ * 		  the highest response time, the smallest slack to the deadline and
+ * 		  the highest response time in relation with the average.
+ *
+ */
+void RobotMaster::PrintWorstCaseAnalysis(void)
+{
+	const nodeResults_t *node;
+	const taskResult_t *task;
+	const taskResult_t *worst[3] = {NULL, NULL, NULL};
+	uint32_t worstNode[3] = {0, 0, 0};
+	double value[3];
+	double worstValue[3] = {0, 0, 0};
+	const char *criteria[3] = {"Highest WCRT", "Highest WCRT/Period", "Highest WCRT/Average"};
+
+	for(size_t n = 0; n <= this->GetSlaves(); ++n)
+	{
+		node = this->GetNodeResults(n);
+		for(uint32_t i = 0; i < node->number; ++i)
+		{
+			task = &node->tasks[i];
+			value[0] = task->wcrt;
+			value[1] = (task->period > 0)? task->wcrt/task->period : 0;
+			value[2] = (task->responseTime > 0)? task->wcrt/task->responseTime : 0;
+
+			for(size_t c = 0; c < 3; ++c)
+			{
+				if((worst[c] == NULL) || (value[c] > worstValue[c]))
+				{
+					worst[c] = task;
+					worstNode[c] = node->node;
+					worstValue[c] = value[c];
+				}
+			}
+		}
+	}
+
+	Stdout::Print("\nWorst case of the test step in all nodes:\n");
+	Stdout::Print("Criterion\t\tNode\tTask\tWCRT (s)\tWCRT/Period\tWCRT/Average\tp99.99 (s)\n");
+
+	for(size_t c = 0; c < 3; ++c)
+	{
+		if(worst[c] == NULL)
+		{
+			continue;
+		}
+		Stdout::Print("%s%s\t%s\t%d\t%f\t%f\t%f\t%f\n", criteria[c], (c == 0)? "\t" : "",
+																		NodeName(worstNode[c]),
+																		worst[c]->taskID,
+																		worst[c]->wcrt,
+																		(worst[c]->period > 0)? worst[c]->wcrt/worst[c]->period : 0,
+																		(worst[c]->responseTime > 0)? worst[c]->wcrt/worst[c]->responseTime : 0,
+																		this->GetResultPercentile(&worst[c]->responseTimeHist, 99.99));
+	}
+
+	Stdout::Print("\nDeadlines missed: %d in the Master", this->actualDeadlineMiss);
+	for(size_t i = 0; i < this->GetSlaves(); ++i)
+	{
+		Stdout::Print(", %d in the %s", this->slaveDeadlines[i], NodeName(this->GetPeerNode(i)));
+	}
+	Stdout::Print(".\n");
+}
+
+/**
+ * @brief Get a percentile of a task result histogram in seconds.
+ *
+ * @param hist - The response time or response jitter histogram of the task.
+ * @param percentile - The percentage, from 0 to 100 (e.g. 99.9).
+ *
+ * @return The percentile in seconds.
+ */
+double RobotMaster::GetResultPercentile(const compactHistogram_t *hist, double percentile)
+{
+	this->resultHist.Import(hist);
+
+	return ((double)this->resultHist.GetPercentile(percentile))/((double)Timer::GetPeriod());
+}
+
 /**
  * @brief Prints the report of the test step results.
  *
@@ -929,6 +1470,26 @@ taskFUNCTION(ManageMasterTask, args)
 	bench->ManTask();
 }
 
+/**
+ * @brief Get the name of a node in the reports.
+ *
+ * 		  The name is kept until the next call.
+ *
+ * @param node - The node number, Robotstone::masterNode or a Slave.
+ *
+ */
+static const char* NodeName(uint32_t node)
+{
+	static char name[sizeof("Slave 4294967295")];
+
+	if(node == Robotstone::masterNode)
+	{
+		return "Master";
+	}
+	snprintf(name, sizeof(name), "Slave %d", node);
+	return name;
+}
+
 /***************************************************************************************
  * END: Module - hartstone.cpp
  ***************************************************************************************/
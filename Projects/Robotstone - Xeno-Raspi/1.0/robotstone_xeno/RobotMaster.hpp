@@ -52,6 +52,14 @@ private:
 	Task manTask; /**< The first task that manages the tests */
 	size_t uniBaselineWorkload[5];
 	size_t distBaselineWorkload[3];
+	bool searchMode; /**< Search the breakdown step instead of increasing the step one by one. */
+	double actualStep; /**< The experiment step of the actual test. */
+	double passedUtilization; /**< CPU utilization of the last step without deadlines missed. */
+	BreakdownSearch search;
+	Subscriber *subResults; /**< Receives the results of each test step from the Slaves. */
+	nodeResults_t *slaveResults; /**< The results of the tasks of each Slave in the last test step. */
+	size_t slaveDeadlines[robotMAX_SLAVES]; /**< The deadlines missed by each Slave in the last test step. */
+	Histogram resultHist; /**< Reads the percentiles of a task result. */
 public:
 
 	RobotMaster(void);
@@ -62,6 +70,8 @@ public:
 
 	void RequestExperiment(uint8_t experiment);
 
+	void SetSearchMode(bool search);
+
 	void InitExperiment(void);
 
 	void StartDistributedExperiment(void);
@@ -70,21 +80,21 @@ public:
 
 	size_t ExperimentDeadlineMiss(void);
 
-	void UpdateExperiment(size_t test);
+	void UpdateExperiment(double step);
 
-	void UpdateExp1(size_t test);
+	void UpdateExp1(double step);
 
-	void UpdateExp2(size_t test);
+	void UpdateExp2(double step);
 
-	void UpdateExp3(size_t test);
+	void UpdateExp3(double step);
 
-	void UpdateExp4(size_t test);
+	void UpdateExp4(double step);
 
-	void UpdateExp5(size_t test);
+	void UpdateExp5(double step);
 
-	void UpdateExp6(size_t test);
+	void UpdateExp6(double step);
 
-	void UpdateExp7(size_t test);
+	void UpdateExp7(double step);
 
 	void CalculateDeadlineMiss(void);
 
@@ -100,7 +110,9 @@ public:
 
 	void ManTask(void);
 
-	void WaitDeadlinesFromSlave(void);
+	void ReceiveResults(size_t test);
+
+	const nodeResults_t* GetNodeResults(size_t node);
 
 	void PrintReport(size_t test);
 
@@ -108,8 +120,26 @@ public:
 
 	void PrintExpDistReport(size_t test);
 
+	void PrintTaskResults(void);
+
+	void PrintWorstCaseAnalysis(void);
+
+	double GetResultPercentile(const compactHistogram_t *hist, double percentile);
+
 	uint32_t TotalDeadlineMiss(void);
 
+	bool NextStep(size_t test, double *step);
+
+	double GetBaselineStep(void);
+
+	double GetStepLimit(void);
+
+	double GetTotalUtilization(void);
+
+	void PrintSearchResult(void);
+
+	void PrintStep(void);
+
 	friend void ManageMasterTask(void *args);
 }; 
 
@@ -27,8 +27,6 @@
 #include "RobotTask.hpp"
 #include <iostream>
 
-#include <alchemy/timer.h>
-#include <alchemy/heap.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -55,9 +53,13 @@ void ManageSlaveTask(void *args);
 /**
  * @brief RobotSlave class constructor.
  *
+ * @param node - The number of the Slave, from 1 to robotMAX_SLAVES.
+ *
  */
-RobotSlave::RobotSlave(void):
-		manTask(ManageSlaveTask, RobotSlave::manTaskPriority, RobotSlave::taskManStackSize, (void*)this, 0, "")
+RobotSlave::RobotSlave(uint32_t node):
+		Robotstone(node),
+		manTask(ManageSlaveTask, RobotSlave::manTaskPriority, RobotSlave::taskManStackSize, (void*)this, 0, ""),
+		pubResults(NULL)
 
 {
 	uint64_t baselineTaskKWIPS = (this->rawSpeed * 0.15) / 3;
@@ -66,6 +68,13 @@ RobotSlave::RobotSlave(void):
 	{
 		this->distBaselineWorkload[i] = baselineTaskKWIPS / distBaselineFrequency[i];
 	}
+
+	// Each Slave in the same machine has its own trace.
+	snprintf(this->traceName, sizeof(this->traceName), robotTRACE_SLAVE_FILE, node);
+	if(robotTRACE)
+	{
+		this->tracer.Open(this->traceName);
+	}
 }
 
 
@@ -79,6 +88,7 @@ void RobotSlave::Start(void)
 	// The management task will always have a id = 0, for scheduler.
 	// The object pointer is passed to task for callback the appropriate
 	// method that handle the management.
+	this->manTask.SetAffinity(robotMAN_CPU);
 	this->manTask.Start();
 
 	getchar();
@@ -100,21 +110,25 @@ void RobotSlave::InitExperiment(void)
  */
 void RobotSlave::ManTask(void){
 
-	uint16_t hsMsg = Robotstone::isStarted;
+	uint32_t cpus;
 
-	cpu_set_t cpus;
+	// The Slave may be started before the Master, and the experiment is sent only
+	// when all the Slaves are connected, so it waits for the Master as long as needed.
+	this->TrySendCommand(Robotstone::cmdConnect, 0, timerMAX_DELAY);
+	this->actualExp = this->WaitCommand(Robotstone::cmdExperiment, timerMAX_DELAY);
 
-	CPU_ZERO(&cpus);
-	CPU_SET(1, &cpus);
+	// The task set is replicated in the same processors of the Master.
+	cpus = this->WaitCommand(Robotstone::cmdCPUs);
+	if(RealTime::SetExecCPUS(cpus) != RealTime::ok)
+	{
+		Stdout::Print("The Master runs in %d processors, more than the Slave has.\n", cpus);
+		exit(1);
+	}
 
-	//sched_setaffinity(0, sizeof(cpu_set_t), &cpus);
+	// The receivers of the experiment 7 are spread among the Slaves.
+	this->SetSlaves(this->WaitCommand(Robotstone::cmdSlaves));
 
-#ifndef RAW_SPEED
-	this->CalculeRawSpeed();
-#endif
-	this->HandshakeSend(&hsMsg);
-	this->HandshakeReceive((uint16_t *)&this->actualExp);
-	RealTime::Stdout::Print("Connection established with Master!\n");
+	RealTime::Stdout::Print("Connection established with Master as Slave %d of %d!\n", this->localNode, this->GetSlaves());
 	RealTime::Stdout::Print("Experiment %d will be performed...\n", this->actualExp);
 	this->InitExperiment();
 	this->StartExperiment();
@@ -128,7 +142,7 @@ void RobotSlave::StartTasks(void)
 {
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->Start();
 	}
 }
 
@@ -137,12 +151,15 @@ void RobotSlave::StartTasks(void)
  */
 void RobotSlave::WaitTasksFinish(void)
 {
-	Task::Delay(Timer::GetPeriod());
-
+	// A task may be blocked waiting for a message that the stopped Master tasks
+	// will never send. It is unblocked again until it parks, since it may have
+	// been between the stop condition test and the message wait.
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
-		rstoneTasks.GetValue()->Unblock();
-		rstoneTasks.GetValue()->Join();
+		while(rstoneTasks.GetValue()->Join(RobotSlave::unblockPeriod) != RealTime::ok)
+		{
+			rstoneTasks.GetValue()->Unblock();
+		}
 	}
 }
 
@@ -154,15 +171,7 @@ void RobotSlave::WaitTasksFinish(void)
  */
 bool RobotSlave::IsFinishedByMaster(void)
 {
-	uint16_t res;
-
-	HandshakeReceive(&res);
-
-	if(res == RobotSlave::isFinished)
-	{
-		return true;
-	}
-	return false;
+	return (this->WaitCommand(Robotstone::cmdStatus) == RobotSlave::isFinished);
 }
 
 /**
@@ -174,19 +183,44 @@ bool RobotSlave::IsFinishedByMaster(void)
 void RobotSlave::StartExperiment(void)
 {
 	size_t test = 1;
-	uint16_t handMsg = RobotSlave::isStarted;
 
 	while(1)
 	{
-		this->HandshakeSend(&handMsg);
+		// The clock estimate is refreshed between the test steps.
+		this->SyncClock();
+
+		this->tracer.Start(test);
+		Network::ClearStats();
+		Communic::ClearStats();
+
+		this->WaitTasksReady();
 
-		this->HandshakeReceive(&handMsg);
+		// Both nodes start the test step together.
+		this->Barrier(Robotstone::cmdReady, 0);
+
+		// In another node, the release and the stop condition of the
+		// tasks are not shared with the Master.
+		if(Network::IsEnabled())
+		{
+			this->ReleaseTasks();
+		}
+
+		this->WaitCommand(Robotstone::cmdStop);
+
+		if(Network::IsEnabled())
+		{
+			*(this->stopCondTask) = 1;
+		}
 
 		this->WaitTasksFinish();
+		this->tracer.Stop();
 
-		this->SignalDeadlineToMaster();
+		if(Network::IsEnabled())
+		{
+			*(this->stopCondTask) = 0;
+		}
 
-		this->GetWorstCase(test);
+		this->SendResults(test);
 
 		this->StartReport(test);
 
@@ -197,7 +231,7 @@ void RobotSlave::StartExperiment(void)
 		}
 
 		test++;
-		this->UpdateExperiment(test);
+		this->UpdateExperiment();
 
 		if(this->experimentReachLimit)
 		{
@@ -225,91 +259,101 @@ size_t RobotSlave::ExperimentDeadlineMiss(void)
 void RobotSlave::SetExperimentBaseline()
 {
 
-	for(int i = 0; i < RobotSlave::baselineNumberExpDist; i++)
-	{
-		void *p = Heap::Alloc(sizeof(RobotTask));
+	size_t id;
 
-		if(p == NULL)
+	// In partitioned multicore mode each processor runs a copy of the task set,
+	// subscribing in the topics of the same processor in the Master.
+	for(size_t cpu = 0; cpu < RealTime::GetExecCPUS(); cpu++)
+	{
+		for(int i = 0; i < RobotSlave::baselineNumberExpDist; i++)
 		{
-			Stdout::Print("Impossible create Baseline Tasks.\nExiting experiment...");
-			exit(1);
+			void *p = Heap::Alloc(sizeof(RobotTask));
+
+			if(p == NULL)
+			{
+				Stdout::Print("Impossible create Baseline Tasks.\nExiting experiment...");
+				exit(1);
+			}
+
+			id = cpu*RobotSlave::baselineNumberExpDist+i+1;
+
+			// make the actual task with high priority than next task
+			RobotTask *taskHandler = new(p) RobotTask(id,
+													Robotstone::baselinePriorityExpDist+(Robotstone::baselineNumberExpDist-(i+1)),
+													&this->startBarrier,
+													this->stopCondTask,
+													"");
+
+			taskHandler->SetCPU(cpu);
+			taskHandler->SetKWIPP(this->distBaselineWorkload[i]);
+			taskHandler->SetFrequency(distBaselineFrequency[i]);
+
+			taskHandler->SubscribingRequest(id+1, RobotSlave::baselineMessageSizeExpDist);
+
+			taskHandler->SetWorkload(this->CreateWorkload());
+			if(this->tracer.Register(taskHandler->GetTraceRing()) != RealTime::ok)
+			{
+				Stdout::Print("Impossible create Baseline Tasks.\nExiting experiment...");
+				exit(1);
+			}
+			this->rstoneTasks.InsertTail(taskHandler);
 		}
-
-		// make the actual task with high priority than next task
-		RobotTask *taskHandler = new(p) RobotTask(i+1,
-												Robotstone::baselinePriorityExpDist+(Robotstone::baselineNumberExpDist-(i+1)),
-												&this->startTasksSig,
-												this->stopCondTask,
-												this->initialTime,
-												"");
-
-		taskHandler->SetKWIPP(this->distBaselineWorkload[i]);
-		taskHandler->SetFrequency(distBaselineFrequency[i]);
-
-		taskHandler->SubscribingRequest(i+2, RobotSlave::baselineMessageSizeExpDist);
-
-		this->rstoneTasks.InsertTail(taskHandler);
 	}
 }
 
 /**
  * @brief Update the actual experiment step test.
  *
- * @param test - test step number.
+ * 		  The experiment step is chosen by the Master and
+ * 		  received in the handshake of each experiment update.
  *
  */
-void RobotSlave::UpdateExperiment(size_t test)
+void RobotSlave::UpdateExperiment(void)
 {
 	switch(this->actualExp)
 	{
 	case RobotSlave::exp4:
-		this->UpdateExp4(test);
+		this->UpdateExp4();
 		break;
 	case RobotSlave::exp5:
-		this->UpdateExp5(test);
+		this->UpdateExp5();
 		break;
 	case RobotSlave::exp6:
-		this->UpdateExp6(test);
+		this->UpdateExp6();
 		break;
 	case RobotSlave::exp7:
-		this->UpdateExp7(test);
+		this->UpdateExp7();
 		break;
 	}
 }
 
 /**
  * @brief Update the actual Experiment 4 step test.
- *
- * @param test - test step number.
- *
  */
-void RobotSlave::UpdateExp4(size_t test)
+void RobotSlave::UpdateExp4(void)
 {
 	int i = 0;
-	uint16_t resMsg;
+	double step;
 
-	this->HandshakeSend(&resMsg);
-	this->HandshakeReceive(&resMsg);
+	this->SendCommand(Robotstone::cmdUpdate, 0);
+	step = Robotstone::DecodeStep(this->WaitCommand(Robotstone::cmdStep));
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
-		rstoneTasks.GetValue()->SetKWIPP(this->distBaselineWorkload[i] * (1 + ((double)test)*0.1));
+		rstoneTasks.GetValue()->SetKWIPP(this->distBaselineWorkload[i % Robotstone::baselineNumberExpDist] * (1 + step*0.1));
 		rstoneTasks.GetValue()->ClearMeasurements();
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->Start();
 		++i;
 	}
 }
 
 /**
  * @brief Update the actual Experiment 5 step test.
- *
- * @param test - test step number.
- *
  */
-void RobotSlave::UpdateExp5(size_t test)
+void RobotSlave::UpdateExp5(void)
 {
 	size_t topic_i = 2;
-	uint16_t resMsg = 0;
+	double step;
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
@@ -318,14 +362,13 @@ void RobotSlave::UpdateExp5(size_t test)
 		rstoneTasks.GetValue()->ClearMeasurements();
 	}
 
-	this->HandshakeSend(&resMsg);
-	this->HandshakeReceive(&resMsg);
-
+	this->SendCommand(Robotstone::cmdUpdate, 0);
+	step = Robotstone::DecodeStep(this->WaitCommand(Robotstone::cmdStep));
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
-		rstoneTasks.GetValue()->SubscribingRequest(topic_i, rstoneEXP5_UPDATE_VALUE(test));
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->SubscribingRequest(topic_i, rstoneEXP5_UPDATE_VALUE(step));
+		rstoneTasks.GetValue()->Start();
 
 		topic_i++;
 	}
@@ -333,23 +376,20 @@ void RobotSlave::UpdateExp5(size_t test)
 
 /**
  * @brief Update the actual Experiment 6 step test.
- *
- * @param test - test step number.
- *
  */
-void RobotSlave::UpdateExp6(size_t test)
+void RobotSlave::UpdateExp6(void)
 {
-	uint16_t resMsg;
 	int i = 0;
+	double step;
 
-	this->HandshakeSend(&resMsg);
-	this->HandshakeReceive(&resMsg);
+	this->SendCommand(Robotstone::cmdUpdate, 0);
+	step = Robotstone::DecodeStep(this->WaitCommand(Robotstone::cmdStep));
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
-		rstoneTasks.GetValue()->SetFrequency(rstoneEXP6_UPDATE_VALUE(test, i));
+		rstoneTasks.GetValue()->SetFrequency(rstoneEXP6_UPDATE_VALUE(step, i % Robotstone::baselineNumberExpDist));
 		rstoneTasks.GetValue()->ClearMeasurements();
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->Start();
 
 		++i;
 	}
@@ -357,55 +397,94 @@ void RobotSlave::UpdateExp6(size_t test)
 
 /**
  * @brief Update the actual Experiment 7 step test.
- *
- * @param test - test step number.
- *
  */
-void RobotSlave::UpdateExp7(size_t test)
+void RobotSlave::UpdateExp7(void)
 {
-	static size_t taskId = 4;
-	uint16_t resMsg = 0;
-
-	void *p = Heap::Alloc(sizeof(RobotTask));
-
-	if(p == NULL)
+	static size_t taskId = Robotstone::baselineNumberExpDist*RealTime::GetExecCPUS() + 1;
+	static size_t added = 0; // Receivers added to the baseline in the list.
+	uint32_t limit = 0;
+	size_t target;
+	RobotTask *taskHandler;
+
+	this->SendCommand(Robotstone::cmdUpdate, 0);
+
+	// One new receiver in each processor by step, given to the Slaves in turn,
+	// so the Slave n takes the receivers n - 1, n - 1 + Slaves, ...
+	target = ((size_t)Robotstone::DecodeStep(this->WaitCommand(Robotstone::cmdStep)) - 1)*RealTime::GetExecCPUS();
+	target = (target + this->GetSlaves() - this->localNode)/this->GetSlaves();
+
+	// The search mode may go back to a smaller step: the receivers in excess
+	// leave the topic and are parked.
+	while(added > target)
 	{
-		resMsg = 1;
-		this->experimentReachLimit = 1;
-		Stdout::Print("\n\nExperiment reach limit: Impossible create more tasks!!!\n\n");
-		this->HandshakeSend(&resMsg);
-		this->HandshakeReceive(&resMsg);
-		Stdout::Print("Experiment finished!!!\n");
-		return;
+		taskHandler = this->rstoneTasks.RemoveTail();
+		taskHandler->LeaveSubTopic();
+		taskHandler->SetActive(false);
+		this->spareTasks.InsertHead(taskHandler);
+		added--;
 	}
 
-	// make the actual task with priority equal to Task 2
-	RobotTask *taskHandler = new(p) RobotTask(taskId,
+	while(added < target)
+	{
+		if(!this->spareTasks.IsEmpty())
+		{
+			taskHandler = this->spareTasks.RemoveHead();
+			taskHandler->SetActive(true);
+		}
+		else
+		{
+			void *p = Heap::Alloc(sizeof(RobotTask));
+
+			if(p == NULL)
+			{
+				limit = 1;
+				break;
+			}
+
+			// make the actual task with priority equal to Task 2
+			taskHandler = new(p) RobotTask(taskId,
 											Robotstone::baselinePriorityExpDist+1,
-											&this->startTasksSig,
+											&this->startBarrier,
 											this->stopCondTask,
-											this->initialTime,
 											"");
 
-	taskHandler->SetKWIPP(this->distBaselineWorkload[1]);
-	taskHandler->SetFrequency(distBaselineFrequency[1]);
+			// No receiver is parked, so this is the receiver number added of this Slave. The CPU
+			// comes from its number among the receivers of all the Slaves, as with one Slave.
+			taskHandler->SetCPU((this->localNode - 1 + added*this->GetSlaves()) % RealTime::GetExecCPUS());
+			taskHandler->SetKWIPP(this->distBaselineWorkload[1]);
+			taskHandler->SetFrequency(distBaselineFrequency[1]);
+			taskHandler->SetWorkload(this->CreateWorkload());
+			if(this->tracer.Register(taskHandler->GetTraceRing()) != RealTime::ok)
+			{
+				taskHandler->~RobotTask();
+				Heap::Free(p);
+				limit = 1;
+				break;
+			}
+			++taskId;
+		}
 
-	// Subscribing in Task 2 topic (Topic 3)
-	taskHandler->SubscribingRequest(3, Robotstone::baselineMessageSizeExpDist);
+		// Subscribing in Task 2 topic of the processor (Topic 3 in the first one)
+		taskHandler->SubscribingRequest(taskHandler->GetCPU()*Robotstone::baselineNumberExpDist+3, Robotstone::baselineMessageSizeExpDist);
 
-	this->rstoneTasks.InsertTail(taskHandler);
+		this->rstoneTasks.InsertTail(taskHandler);
+		added++;
+	}
 
-	++taskId;
+	// The experiment finishes in all the nodes when a Slave reaches the limit.
+	if(this->Barrier(Robotstone::cmdLimit, limit) == 1)
+	{
+		this->experimentReachLimit = 1;
+		Stdout::Print("\n\nExperiment reach limit: Impossible create more tasks!!!\n\n");
+		Stdout::Print("Experiment finished!!!\n");
+		return;
+	}
 
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
 		rstoneTasks.GetValue()->ClearMeasurements();
-		rstoneTasks.GetValue()->Start(RealTime::GetExecCPUS());
+		rstoneTasks.GetValue()->Start();
 	}
-
-
-	this->HandshakeSend(&resMsg);
-	this->HandshakeReceive(&resMsg);
 }
 
 /**
@@ -433,157 +512,64 @@ void RobotSlave::StartReport(size_t test)
 {
 	this->CalculateDeadlineMiss();
 
-	this->SignalDeadlineToMaster();
-
 	this->PrintReport(test);
 }
 
 /**
- * @brief Signal to Master the number of deadlines missed in Slave.
+ * @brief Send the results of the Slave tasks in the test step to the Master.
+ *
+ * 		  The results are announced by a Robotstone::cmdResults with the number
+ * 		  of deadlines missed, and published in the topic robotRESULT_TOPIC each
+ * 		  time the Master answers 0, since a fragment of the message may be lost
+ * 		  in the network. The Master asks the Slaves one after the other, so the
+ * 		  big messages of different Slaves are not mixed.
+ *
+ * @param test - test step number.
+ *
  */
-void RobotSlave::SignalDeadlineToMaster()
+void RobotSlave::SendResults(size_t test)
 {
-	uint16_t deadlineSig = RobotSlave::deadlineHandshake;
-
-	HandshakeSend(&deadlineSig);
-
 	this->CalculateDeadlineMiss();
-	deadlineSig = (uint16_t)this->actualDeadlineMiss;
+	this->CollectResults(test);
 
-	HandshakeSend(&deadlineSig);
+	this->SendCommand(Robotstone::cmdResults, this->actualDeadlineMiss);
+	while(this->WaitCommand(Robotstone::cmdResults) == 0)
+	{
+		this->pubResults->Send(this->results);
+	}
 }
 
 /**
- * @brief Prints the report of the test step results.
+ * @brief Prints the report of the Slave node in the test step.
+ *
+ * 		  The results of the tasks are sent to the Master, which reports them
+ * 		  merged with its own ones. Only the transport of the messages in the
+ * 		  Slave is reported here.
  *
  * @param test - test step number.
  *
  */
 void RobotSlave::PrintReport(size_t test)
 {
-	float totalKWIPS = 0, totalCPU = 0;
-
 	Stdout::Print("========================================================================\n\n");
 	Stdout::Print("Underlay Software Architecture:\n" robotRT_NAME "\n");
-	Stdout::Print("Raw speed in Kilo-Whetstone Instructions Per Second (KWIPS): %lld\n\n", this->GetRawSpeed());
+	this->PrintRawSpeed();
+	this->PrintDelivery();
+	this->PrintClockSync();
 	Stdout::Print("Executable Control: ");
 
-	Stdout::Print("Slave\n\n");
+	Stdout::Print("Slave %d of %d\n\n", this->localNode, this->GetSlaves());
 
 	Stdout::Print("Experiment: %d\n\n", this->actualExp);
-	Stdout::Print("Test %d characteristics:\n\n", test);
 
-	Stdout::Print("Task\tFrequency(Hz)\tKWIPP\tKWIPS\t\tCPU Utilization\n");
+	Stdout::Print("Test %d: %d tasks, %d deadlines missed.\n", test, this->results->total, this->actualDeadlineMiss);
+	Stdout::Print("The results of the tasks are reported by the Master.\n");
 
-	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
-	{
-		Stdout::Print("%d\t%f\t%d\t%f\t%f%\n", rstoneTasks.GetValue()->GetID(),
-														 rstoneTasks.GetValue()->GetFrequency(),
-														 rstoneTasks.GetValue()->GetKWIPP(),
-														 rstoneTasks.GetValue()->GetKWIPS(),
-														 rstoneTasks.GetValue()->GetUtilization(this->GetRawSpeed()));
-		totalKWIPS += rstoneTasks.GetValue()->GetKWIPS();
-		totalCPU += rstoneTasks.GetValue()->GetUtilization(this->GetRawSpeed());
-	}
-
-	Stdout::Print("\t\t\t\t-------\t\t-------\n");
-	Stdout::Print("\t\t\t\t%f\t%f%\n\n", totalKWIPS, totalCPU);
-
-
-	Stdout::Print("Task\tMessage Length(B)\tFrequency(Hz)\tTopic\n");
-
-	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
-	{
-		Stdout::Print("%d\t%d\t\t\t%f\t%d\n", rstoneTasks.GetValue()->GetID(),
-														 rstoneTasks.GetValue()->GetSubMessageSize(),
-														 rstoneTasks.GetValue()->GetFrequency(),
-														 rstoneTasks.GetValue()->GetSubTopic());
-	}
+	Communic::PrintStats();
+	this->PrintTraceStatus();
+	Network::PrintReport();
 
-	Stdout::Print("\n");
-	Stdout::Print("Initial condition: - all tasks workload set by \n\t\t\t{%d, %d, %d} KWIPP.\n", distBaselineWorkload[0],
-																									  distBaselineWorkload[1],
-																									  distBaselineWorkload[2]);
-
-	Stdout::Print("                   - all tasks frequency set by {"tCFormat", "tCFormat", "tCFormat"} Hertz.\n",
-																												distBaselineFrequency[0],
-																												distBaselineFrequency[1],
-																												distBaselineFrequency[2]);
-	Stdout::Print("                   - Message length set by %d bytes.\n", Robotstone::baselineMessageSizeExpDist);
-
-
-	switch(this->actualExp)
-	{
-	case Robotstone::exp4:
-		Stdout::Print("Experiment step: Increase all tasks workloads by\n");
-		Stdout::Print("\t\t\t10%% of its baseline value.\n");
-		break;
-	case Robotstone::exp5:
-		Stdout::Print("Experiment step: scale message length by \n");
-		Stdout::Print("\t\t\t the baseline length power to test step number.\n");
-		break;
-	case Robotstone::exp6:
-		Stdout::Print("Experiment step: Increase the frequency of all tasks by \n");
-		Stdout::Print("\t\t\t10%% of its baseline frequency.\n");
-		break;
-	case Robotstone::exp7:
-		Stdout::Print("Experiment step: Increase one task with the same\n");
-		Stdout::Print("\t\t\tparameters of medium priority subscriber task on Slave.\n");
-		break;
-	}
-
-	Stdout::Print("------------------------------------------------------------------------\n\n");
-
-	Stdout::Print("Test %d results:\n\n", test);
-	Stdout::Print("Test duration (seconds): %lld\n\n", this->testPeriod/Timer::GetPeriod());
-
-	Stdout::Print("Task\tPeriod(s)\tMet\t\tMissed\t\tSkipped\t\n");
-		Stdout::Print("    \t         \tdeadlines\tdeadlines\tdeadlines\n");
-
-	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
-	{
-		Stdout::Print("%d\t%f\t%d\t\t%d\t\t%d\n", rstoneTasks.GetValue()->GetID(),
-															  rstoneTasks.GetValue()->GetPeriodSec(),
-															  rstoneTasks.GetValue()->GetDeadlineMet(),
-															  rstoneTasks.GetValue()->GetDeadlineMiss(),
-															  rstoneTasks.GetValue()->GetDeadlineSkip());
-	}
-
-	Stdout::Print("\nTask\tAverage (s)\tWCRT (s)\tAverage (s)\tWCRJ (s)\n");
-	Stdout::Print("    \tResp. Time\t    \t\tResp. Jitter\n");
-
-	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
-	{
-		Stdout::Print("%d\t%f\t%f\t%f\t%f\n", rstoneTasks.GetValue()->GetID(),
-															rstoneTasks.GetValue()->GetResponseTime(),
-															rstoneTasks.GetValue()->GetWCRT(),
-															rstoneTasks.GetValue()->GetResponseJitter(),
-															rstoneTasks.GetValue()->GetWCRJ());
-	}
-
-	Stdout::Print("\nScenario with worst WCRT in relation with average:\n");
-	Stdout::Print("- Test: %d\n", worstScenario.test);
-	Stdout::Print("- Task: %d\n", worstScenario.taskID);
-	Stdout::Print("- WCRT: %f seconds\n", worstScenario.wcrt);
-	Stdout::Print("- Aver. Response: %f seconds\n", worstScenario.averageResp);
 	Stdout::Print("\n\n========================================================================\n\n");
-
-#ifdef	robotEXTRA_VISUALIZATION
-	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
-	{
-		Stdout::Print("\t\t\t\t\t\t\t\t\t\t%d %f %d %d %d %f %f %f %f\n", rstoneTasks.GetValue()->GetID(),
-															  	   rstoneTasks.GetValue()->GetPeriodSec(),
-																   rstoneTasks.GetValue()->GetDeadlineMet(),
-																   rstoneTasks.GetValue()->GetDeadlineMiss(),
-																   rstoneTasks.GetValue()->GetDeadlineSkip(),
-																   rstoneTasks.GetValue()->GetResponseTime(),
-																   rstoneTasks.GetValue()->GetWCRT(),
-																   rstoneTasks.GetValue()->GetResponseJitter(),
-																   rstoneTasks.GetValue()->GetWCRJ());
-	}
-#endif
-
-
 }
 
 /**
@@ -596,8 +582,9 @@ void RobotSlave::PrintReport(size_t test)
 void ManageSlaveTask(void *args){
 	RobotSlave* bench = (RobotSlave*) args;
 
-	bench->pubMan = Communic::PublishingRequest(1, sizeof(uint16_t));
-	bench->subMan = Communic::SubscribingRequest(0, sizeof(uint16_t));
+	bench->pubMan = Communic::PublishingRequest(1, sizeof(manMessage_t));
+	bench->subMan = Communic::SubscribingRequest(0, sizeof(manMessage_t));
+	bench->pubResults = Communic::PublishingRequest(robotRESULT_TOPIC, sizeof(nodeResults_t));
 	bench->ManTask();
 }
 
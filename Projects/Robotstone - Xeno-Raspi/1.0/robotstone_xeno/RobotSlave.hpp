@@ -44,9 +44,12 @@ class RobotSlave : public Robotstone
 {
 private:
 	Task manTask; /**< The first task that manages the tests */
+	Publisher *pubResults; /**< Sends the results of each test step to the Master. */
+	char traceName[sizeof(robotTRACE_SLAVE_FILE) + 8]; /**< The trace file of this Slave. */
 public:
+	static const timeCount_t unblockPeriod = 1000000; /**< Wait for a task to park before unblocking it again. (in ns. 1 ms.) */
 
-	RobotSlave(void);
+	RobotSlave(uint32_t node);
 
 	void Start(void);
 
@@ -60,15 +63,15 @@ public:
 
 	size_t ExperimentDeadlineMiss(void);
 
-	void UpdateExperiment(size_t test);
+	void UpdateExperiment(void);
 
-	void UpdateExp4(size_t test);
+	void UpdateExp4(void);
 
-	void UpdateExp5(size_t test);
+	void UpdateExp5(void);
 
-	void UpdateExp6(size_t test);
+	void UpdateExp6(void);
 
-	void UpdateExp7(size_t test);
+	void UpdateExp7(void);
 
 	void CalculateDeadlineMiss(void);
 
@@ -80,7 +83,7 @@ public:
 
 	void SetExperimentBaseline();
 
-	void SignalDeadlineToMaster();
+	void SendResults(size_t test);
 
 	void InitTest(uint8_t exp, uint8_t test);
 
@@ -26,6 +26,7 @@
 #include "rtheap.hpp"
 #include <iostream> //for use of new(pointer)
 #include <sched.h>
+#include <string.h>
 
 #define Abs( x ) (((x) > 0) ? x : -(x))
 
@@ -46,11 +47,13 @@ taskFUNCTION(TaskCode, arg);
  */
 #define CEILING(x,y) ((x == 0)? 1 : (1 + ((x - 1) / y)))
 
+RealTime::subscriberQoS_t RobotTask::subscriberQoS = {RealTime::Communic::dropNewest, 30, 0, 0};
+
 /**
  * @brief RobotTask class constructor.
  *
  */
-RobotTask::RobotTask(size_t id, size_t priority, RealTime::Signal* signal, uint8_t *stopCondition, RealTime::timeCount_t *initTime, const char *name):
+RobotTask::RobotTask(size_t id, size_t priority, RealTime::ReleaseBarrier* barrier, uint8_t *stopCondition, const char *name):
 		period(0),
 		responseTime(0),
 		avgResponseJitter(0),
@@ -58,16 +61,18 @@ RobotTask::RobotTask(size_t id, size_t priority, RealTime::Signal* signal, uint8
 		bcrt(RealTime::Timer::GetPeriod()*100),
 		deadlineMiss(0), deadlineMet(0), deadlineSkip(0),
 		workload(0),
-		messageSize(0),
+		engine(Workload::Create(Workload::whetstone, 0)),
 		stackSize(RobotTask::defaultStackSize),
+		cpu(RealTime::Task::anyCPU),
 		stopCondition(stopCondition),
-		initTime(initTime),
 		priority(priority),
 		id(id),
 		frequency(0),
 		periodSec(0),
 		pub(NULL), sub(NULL),
-		signal(signal),
+		barrier(barrier),
+		isStarted(false),
+		isActive(true),
 		name(name)
 {
 	void *p = RealTime::Heap::Alloc(sizeof(RealTime::Task));
@@ -81,6 +86,7 @@ RobotTask::RobotTask(size_t id, size_t priority, RealTime::Signal* signal, uint8
  */
 RobotTask::~RobotTask(void)
 {
+
 }
 
 /**
@@ -120,6 +126,35 @@ void RobotTask::SetKWIPP(size_t kwipp)
 	this->workload = kwipp;
 }
 
+/**
+ * @brief Set the kind of workload executed by the task. The workload
+ * 		  given by RobotTask::SetKWIPP is in units of this kind.
+ *
+ * @param engine - The workload instance, created by Workload::Create.
+ *
+ */
+void RobotTask::SetWorkload(Workload *engine)
+{
+	this->engine = engine;
+}
+
+/**
+ * @brief Set the quality of service of the next subscriptions of all tasks.
+ *
+ * 		  A message is counted as late if it is read after the task period.
+ *
+ * @param overflow - Communic::keepLast, Communic::dropNewest or Communic::blocking.
+ * @param depth - The number of messages kept for each subscriber.
+ * @param timeout - The maximum wait for room in Communic::blocking.
+ *
+ */
+void RobotTask::SetSubscriberQoS(int overflow, uint32_t depth, RealTime::timeCount_t timeout)
+{
+	RobotTask::subscriberQoS.overflow = overflow;
+	RobotTask::subscriberQoS.depth = depth;
+	RobotTask::subscriberQoS.timeout = timeout;
+}
+
 /**
  * @brief Request to be a publisher in a specific topic using the
  * 		  publisher/subscriber mechanism.
@@ -132,7 +167,12 @@ void RobotTask::SetKWIPP(size_t kwipp)
  */
 size_t RobotTask::PublishingRequest(size_t topic, size_t msgSize)
 {
-	this->pub = RealTime::Communic::PublishingRequest(topic, msgSize);
+	if(this->CheckMessageSize(msgSize))
+	{
+		return 1;
+	}
+
+	this->pub = RealTime::Communic::PublishingRequest(topic, msgSize, this->cpu);
 
 	if(pub == NULL)
 	{
@@ -155,7 +195,15 @@ size_t RobotTask::PublishingRequest(size_t topic, size_t msgSize)
  */
 size_t RobotTask::SubscribingRequest(size_t topic, size_t msgSize)
 {
-	this->sub = RealTime::Communic::SubscribingRequest(topic, msgSize);
+	RealTime::subscriberQoS_t qos = RobotTask::subscriberQoS;
+
+	if(this->CheckMessageSize(msgSize))
+	{
+		return 1;
+	}
+
+	qos.lifespan = this->period;
+	this->sub = RealTime::Communic::SubscribingRequest(topic, msgSize, this->cpu, &qos);
 
 	if(sub == NULL)
 	{
@@ -166,6 +214,25 @@ size_t RobotTask::SubscribingRequest(size_t topic, size_t msgSize)
 	return 0;
 }
 
+/**
+ * @brief Verify if a topic message can be exchanged by the task.
+ *
+ * @param msgSize - the message size in bytes.
+ *
+ * @return 0 if the size is valid and 1 otherwise.
+ *
+ */
+size_t RobotTask::CheckMessageSize(size_t msgSize)
+{
+	if(msgSize > RobotTask::maxMessageSize)
+	{
+		RealTime::Stdout::Print("Message of %d bytes is bigger than the maximum by hart task %d.\n", msgSize, this->id);
+		return 1;
+	}
+
+	return 0;
+}
+
 /**
  * @brief Leave a previous topic as publisher.
  *
@@ -190,24 +257,74 @@ size_t RobotTask::LeaveSubTopic(void)
 	return 0;
 }
 
+/**
+ * @brief Set the processor where the task runs. It must be called before
+ * 		  the first RobotTask::Start and the topic requests, since the topic
+ * 		  gatekeeper tasks created by the task run in the same processor.
+ *
+ * @param cpuRun - cpu number to run or RealTime::Task::anyCPU.
+ *
+ */
+void RobotTask::SetCPU(size_t cpuRun)
+{
+	this->cpu = cpuRun;
+}
+
 /**
  * @brief Start to run the task as soon as is its turn.
  *
- * @param cpuRun - cpu number to run.
+ * 		  The task is only created in the first call. After each test step
+ * 		  it stays parked waiting the next release, so the following
+ * 		  calls only need to change its parameters beforehand.
  *
  */
-void RobotTask::Start(size_t cpuRun)
+void RobotTask::Start(void)
 {
-	this->task->Start();
+	if(!this->isStarted)
+	{
+		// The task is counted in the releases before it can reach the barrier.
+		this->barrier->Register();
+		this->task->SetAffinity(this->cpu);
+		this->task->Start();
+		this->isStarted = true;
+	}
+}
+
+/**
+ * @brief Set if the task runs in the next test steps.
+ *
+ * 		  An inactive task ignores the releases and stays parked, so it
+ * 		  must be out of the list of tasks joined by the management task.
+ *
+ * @param active - false to park the task, true to run it again.
+ *
+ */
+void RobotTask::SetActive(bool active)
+{
+	this->isActive = active;
 }
 
 /**
  * @brief A call to this method will block the caller until
- * 		  the synthetic task leaves its superlooop.
+ * 		  the synthetic task leaves its superlooop and parks.
  */
 void RobotTask::Join(void)
 {
-	this->task->Join();
+	this->parked.Wait();
+}
+
+/**
+ * @brief Block the caller until the synthetic task leaves its superloop
+ * 		  and parks, for a limited time.
+ *
+ * @param timeout - The maximum wait in implementation specific units.
+ *
+ * @return - RealTime::ok if the task parked;
+ * 		   - RealTime::fail if the timeout expired.
+ */
+int RobotTask::Join(RealTime::timeCount_t timeout)
+{
+	return this->parked.Wait(timeout);
 }
 
 /**
@@ -228,6 +345,16 @@ size_t RobotTask::GetID(void)
 	return this->id;
 }
 
+/**
+ * @brief Get the processor where the task runs.
+ *
+ * @return The processor number or RealTime::Task::anyCPU.
+ */
+size_t RobotTask::GetCPU(void)
+{
+	return this->cpu;
+}
+
 /**
  * @brief Get the task activation frequency.
  *
@@ -268,6 +395,16 @@ size_t RobotTask::GetKWIPP(void)
 	return this->workload;
 }
 
+/**
+ * @brief Get the kind of workload executed by the task.
+ *
+ * @return The workload instance.
+ */
+Workload* RobotTask::GetWorkload(void)
+{
+	return this->engine;
+}
+
 /**
  * @brief Get the task utilization in KWIPS.
  *
@@ -328,7 +465,7 @@ size_t RobotTask::GetDeadlineSkip(void)
  */
 double RobotTask::GetWCRT(void)
 {
-	return (double)((this->wcrt)/(RealTime::Timer::GetPeriod()));
+	return ((double)this->wcrt)/((double)RealTime::Timer::GetPeriod());
 }
 
 /**
@@ -338,7 +475,17 @@ double RobotTask::GetWCRT(void)
  */
 double RobotTask::GetWCRJ(void)
 {
-	return (double)((this->wcrt - this->bcrt)/(RealTime::Timer::GetPeriod()));
+	return ((double)(this->wcrt - this->bcrt))/((double)RealTime::Timer::GetPeriod());
+}
+
+/**
+ * @brief Get the task best-case response time in seconds.
+ *
+ * @return The task best-case response time in seconds.
+ */
+double RobotTask::GetBCRT(void)
+{
+	return ((double)this->bcrt)/((double)RealTime::Timer::GetPeriod());
 }
 
 /**
@@ -362,41 +509,98 @@ double RobotTask::GetResponseJitter(void)
 }
 
 /**
- * @brief Blocks the synthetic task until a signal is sent from management task.
+ * @brief Get a percentile of the task response time in seconds.
+ *
+ * @param percentile - The percentage, from 0 to 100 (e.g. 99.9).
+ *
+ * @return The response time percentile in seconds.
  */
-void RobotTask::WaitSignal(void)
+double RobotTask::GetResponseTimePercentile(double percentile)
 {
-	this->signal->Wait();
+	return ((double)this->responseTimeHist.GetPercentile(percentile))/((double)RealTime::Timer::GetPeriod());
+}
+
+/**
+ * @brief Get a percentile of the task response jitter in seconds.
+ *
+ * @param percentile - The percentage, from 0 to 100 (e.g. 99.9).
+ *
+ * @return The response jitter percentile in seconds.
+ */
+double RobotTask::GetResponseJitterPercentile(double percentile)
+{
+	return ((double)this->responseJitterHist.GetPercentile(percentile))/((double)RealTime::Timer::GetPeriod());
+}
+
+/**
+ * @brief Copy the response time and response jitter histograms of the
+ * 		  test step, to be sent to another node.
+ *
+ * @param responseTime - Where the response time histogram is copied.
+ * @param responseJitter - Where the response jitter histogram is copied.
+ */
+void RobotTask::ExportHistograms(compactHistogram_t *responseTime, compactHistogram_t *responseJitter)
+{
+	this->responseTimeHist.Export(responseTime);
+	this->responseJitterHist.Export(responseJitter);
+}
+
+/**
+ * @brief Blocks the synthetic task until the management task releases
+ * 		  the test step and its release time is reached.
+ *
+ * @return The release time, the first activation of the test step.
+ */
+RealTime::timeCount_t RobotTask::WaitRelease(void)
+{
+	return this->barrier->Wait();
 }
 
 /**
  * @brief Blocks the synthetic task until a complete message is read from its topic.
  *
  * The message has no useful information and is filled with dummy bytes by publisher tasks.
+ * It is read in place, in the buffer shared with the other subscribers of the topic.
+ * In a state topic the last sample is read without blocking.
  */
 void RobotTask::ReceiveMessage(void)
 {
+	const void *msg;
+
 	if(this->sub == NULL)
 	{
 		return;
 	}
 
-	this->sub->Receive(this->message);
+	msg = this->sub->Read();
+
+	if(msg != NULL)
+	{
+		this->sub->Release(msg);
+	}
 }
 
 /**
  * @brief Blocks the synthetic task until a complete message is sent to its topic.
  *
  * The message has no useful information and is filled with dummy bytes by publisher tasks.
+ * It is built in place, in the topic queue buffer.
  */
 void RobotTask::SendMessage(void)
 {
+	void *msg;
+
 	if(this->pub == NULL)
 	{
 		return;
 	}
 
-	this->pub->Send(this->message);
+	msg = this->pub->Loan();
+
+	if(msg != NULL)
+	{
+		this->pub->Publish(msg);
+	}
 }
 
 /**
@@ -404,7 +608,7 @@ void RobotTask::SendMessage(void)
  */
 void RobotTask::ExecuteWorkload(void)
 {
-	WHETSTONE_EXECUTE(this->workload);
+	this->engine->Execute(this->workload);
 }
 
 /**
@@ -455,6 +659,27 @@ size_t RobotTask::GetSubTopic(void)
 	return this->sub->GetTopic();
 }
 
+/**
+ * @brief Get the ring where the task saves the record of each activation.
+ *
+ * @return The task trace ring.
+ */
+TraceRing* RobotTask::GetTraceRing(void)
+{
+	return &this->trace;
+}
+
+/**
+ * @brief Get the activation records discarded in the test step because the
+ * 		  trace ring was full.
+ *
+ * @return The number of dropped records.
+ */
+uint32_t RobotTask::GetTraceDropped(void)
+{
+	return this->trace.GetDropped();
+}
+
 /**
  * @brief Clear all the measurements related to the task in the test step.
  */
@@ -467,7 +692,9 @@ void RobotTask::ClearMeasurements(void)
 	this->avgResponseJitter = 0;
 	this->wcrt = 0;
 	this->bcrt = RealTime::Timer::GetPeriod()*100;
-
+	this->responseTimeHist.Clear();
+	this->responseJitterHist.Clear();
+	this->trace.ClearDropped();
 }
 
 /**
@@ -483,104 +710,140 @@ taskFUNCTION(TaskCode, arg)
 {
 	RobotTask *taskHandler = (RobotTask *)arg;
 
-	RealTime::timeCount_t activationTime, completeTime, actualResponseTime, beforeResponseTime = 0;
+	RealTime::timeCount_t activationTime, completeTime, actualResponseTime, actualResponseJitter, beforeResponseTime;
 	float ceilingPeriod;
 
-	uint32_t numberOfExecs = 0;
+	uint32_t numberOfExecs;
 
-	RealTime::timeCount_t taskPeriod = taskHandler->period;
+	RealTime::timeCount_t taskPeriod;
 
-	taskHandler->WaitSignal();
+	traceRecord_t record;
 
-	// Get the first activation time of task from baseline initial time.
-	activationTime = *(taskHandler->initTime);
+	memset(&record, 0, sizeof(record));
+	record.taskID = taskHandler->id;
 
+	// The task runs one test step in each iteration and
+	// stays parked between them.
+	while(true)
+	{
+		// All the tasks of the test step are released at the same time (the critical instant).
+		activationTime = taskHandler->WaitRelease();
 
-    while(true)
-    {
-    	numberOfExecs++;
+		if(!taskHandler->isActive)
+		{
+			continue;
+		}
 
-    	//RealTime::Stdout::Print("%s\n", taskHandler->GetName());
-    	taskHandler->ReceiveMessage();
+		// The parameters may have changed since the last test step.
+		taskPeriod = taskHandler->period;
+		record.pubMessageSize = (taskHandler->pub != NULL)? taskHandler->pub->GetMessageSize() : 0;
+		record.subMessageSize = (taskHandler->sub != NULL)? taskHandler->sub->GetMessageSize() : 0;
+		numberOfExecs = 0;
+		beforeResponseTime = 0;
 
-    	// Execute the task workload if it has.
-    	if(taskHandler->workload)
-    	{
-    		WHETSTONE_EXECUTE(taskHandler->workload);
-    	}
+		while(true)
+		{
+			numberOfExecs++;
 
-    	taskHandler->SendMessage();
+			record.startTime = RealTime::Timer::GetTime();
 
+			//RealTime::Stdout::Print("%s\n", taskHandler->GetName());
+			taskHandler->ReceiveMessage();
 
-		// If in this point, the hartros management execute, so it interfere on scheduling to stop
-		// the experiment. So the before calculus no make sense anymore and task will out
-		// of its superloop.
-		if(taskHandler->IsTaskStopped())
-		{
-			taskHandler->responseTime /= numberOfExecs-1;
-			taskHandler->avgResponseJitter /= numberOfExecs-1;
-			break;
-		}
+			// Execute the task workload if it has.
+			if(taskHandler->workload)
+			{
+				taskHandler->engine->Execute(taskHandler->workload);
+			}
 
-    	completeTime = RealTime::Timer::GetTime();
+			taskHandler->SendMessage();
 
-    	//actualResponseTime = completeTime - activationTime;
 
-		/* Test to does not overflow*/
+			// If in this point, the hartros management execute, so it interfere on scheduling to stop
+			// the experiment. So the before calculus no make sense anymore and task will out
+			// of its superloop.
+			if(taskHandler->IsTaskStopped())
+			{
+				if(numberOfExecs > 1)
+				{
+					taskHandler->responseTime /= numberOfExecs-1;
+					taskHandler->avgResponseJitter /= numberOfExecs-1;
+				}
+				break;
+			}
 
-		if(completeTime >= activationTime)
-		{
-			actualResponseTime = completeTime - activationTime;
-		}
-		else
-		{
-			actualResponseTime = timerMAX_DELAY - completeTime + activationTime;
-		}
+			completeTime = RealTime::Timer::GetTime();
 
-		taskHandler->responseTime += actualResponseTime;
+			//actualResponseTime = completeTime - activationTime;
 
-		if(numberOfExecs != 1)
-		{
-			if(actualResponseTime > beforeResponseTime) /* Test to not overflow*/
+			/* Test to does not overflow*/
+
+			if(completeTime >= activationTime)
 			{
-				taskHandler->avgResponseJitter = taskHandler->avgResponseJitter + actualResponseTime - beforeResponseTime;
+				actualResponseTime = completeTime - activationTime;
 			}
 			else
 			{
-				taskHandler->avgResponseJitter = taskHandler->avgResponseJitter + beforeResponseTime - actualResponseTime;
+				actualResponseTime = timerMAX_DELAY - completeTime + activationTime;
 			}
-		}
 
-		beforeResponseTime = actualResponseTime;
+			taskHandler->responseTime += actualResponseTime;
+			taskHandler->responseTimeHist.Record(actualResponseTime);
 
-		if(actualResponseTime > taskHandler->wcrt)
-		{
-			taskHandler->wcrt = actualResponseTime;
-		}
-		if(actualResponseTime < taskHandler->bcrt)
-		{
-			taskHandler->bcrt = actualResponseTime;
-		}
+			if(numberOfExecs != 1)
+			{
+				if(actualResponseTime > beforeResponseTime) /* Test to not overflow*/
+				{
+					actualResponseJitter = actualResponseTime - beforeResponseTime;
+				}
+				else
+				{
+					actualResponseJitter = beforeResponseTime - actualResponseTime;
+				}
+				taskHandler->avgResponseJitter += actualResponseJitter;
+				taskHandler->responseJitterHist.Record(actualResponseJitter);
+			}
+
+			beforeResponseTime = actualResponseTime;
 
-		// If the task complete its execution before the deadline (inside its period), so
-		// the ceilingPeriod = 1. If miss the deadline, the value will be bigger than 1,
-		// resulting in a activation time corresponding to the number of periods lost.
-		ceilingPeriod = CEILING(actualResponseTime, taskPeriod);
-		activationTime = activationTime + ceilingPeriod * taskPeriod;
+			if(actualResponseTime > taskHandler->wcrt)
+			{
+				taskHandler->wcrt = actualResponseTime;
+			}
+			if(actualResponseTime < taskHandler->bcrt)
+			{
+				taskHandler->bcrt = actualResponseTime;
+			}
 
+			// If the task complete its execution before the deadline (inside its period), so
+			// the ceilingPeriod = 1. If miss the deadline, the value will be bigger than 1,
+			// resulting in a activation time corresponding to the number of periods lost.
+			ceilingPeriod = CEILING(actualResponseTime, taskPeriod);
 
-		if(ceilingPeriod == 1)
-		{
-			taskHandler->deadlineMet++;
-		}
-		else
-		{
-			taskHandler->deadlineMiss++;
-			taskHandler->deadlineSkip += ceilingPeriod;
+			record.activationTime = activationTime;
+			record.completeTime = completeTime;
+			record.ceilingPeriod = ceilingPeriod;
+			taskHandler->trace.Push(record);
+
+			activationTime = activationTime + ceilingPeriod * taskPeriod;
+
+
+			if(ceilingPeriod == 1)
+			{
+				taskHandler->deadlineMet++;
+			}
+			else
+			{
+				taskHandler->deadlineMiss++;
+				taskHandler->deadlineSkip += ceilingPeriod;
+			}
+
+			RealTime::Task::DelayUntil(activationTime);
 		}
 
-		RealTime::Task::DelayUntil(activationTime);
-    }
+		// Warn the management task that the test step results are ready.
+		taskHandler->parked.Post();
+	}
 }
 
 /***************************************************************************************
@@ -29,8 +29,10 @@
 #include "list.hpp"
 #include "communic.hpp"
 #include "stdout.hpp"
-#include "whetstone.h"
+#include "workload.hpp"
 #include "rtsignal.hpp"
+#include "histogram.hpp"
+#include "trace.hpp"
 
 /**
  * @brief This class encapsulates the synthetic tasks functionalities.
@@ -39,53 +41,66 @@
 class RobotTask
 {
 public:
-	static const size_t maxMessageSize = 4194304; /**< The maximum messages size. Each synthetic task will always occupy this memory */
+	static const size_t maxMessageSize = 4194304; /**< The maximum messages size. */
 	static const size_t defaultStackSize = 500;
 private:
+	static RealTime::subscriberQoS_t subscriberQoS; /**< The quality of service of the subscriptions of all tasks. */
 	RealTime::timeCount_t period;
 	RealTime::timeCount_t responseTime;
 	RealTime::timeCount_t avgResponseJitter;
 	RealTime::timeCount_t wcrt;
 	RealTime::timeCount_t bcrt;
+	Histogram responseTimeHist; /**< Response time of each activation in the test step. */
+	Histogram responseJitterHist; /**< Response jitter of each activation in the test step. */
+	TraceRing trace; /**< The record of each activation, drained by a Tracer. */
 	uint32_t deadlineMiss; /**< Number of Missed Deadlines ordered by task index. */
 	uint32_t deadlineMet; /**< Number of Met Deadlines ordered by task index. */
 	uint32_t deadlineSkip; /**< Number of Skipped Deadlines ordered by task index. */
 	uint32_t workload; /**< Tasks Loads ordered by task_index. */
-	uint32_t messageSize; /**< Tasks messages size ordered by task_index. */
+	Workload *engine; /**< Executes the task workload. */
 	size_t stackSize;
+	size_t cpu; /**< The processor where the task runs. */
 	uint8_t *stopCondition; /**< A shared variable between synthetic and management tasks to signal the end of a test step */
-	RealTime::timeCount_t *initTime; /**< A shared variable between synthetic and management tasks with the initial time from test step. */
 	uint16_t priority; /**< Tasks Priorities ordered by task_index */
-	uint8_t message[maxMessageSize]; /**< The message buffer */
-	uint8_t id; /**< The task identification. */
+	uint16_t id; /**< The task identification. */
 	double frequency; /**< Tasks Frequencies ordered by task_index. */
 	double periodSec; /**< Tasks Periods ordered by task_index. */
 	RealTime::Publisher* pub; /**< If task is publisher this will point to a valid instance. Otherwise is null. */
 	RealTime::Subscriber* sub; /**< If task is subscriber this will point to a valid instance. Otherwise is null. */
 	RealTime::Task* task;
-	RealTime::Signal* signal; /**< A instance shared between synthetic and management tasks to signal the start of a test step */
+	RealTime::ReleaseBarrier* barrier; /**< A instance shared between synthetic and management tasks to release the start of a test step */
+	RealTime::Semaphore parked; /**< Posted by the synthetic task when it finishes a test step. */
+	bool isStarted; /**< Indicates that the task was already created. */
+	bool isActive; /**< If false, the task stays parked in the test steps. */
 	const char* name;
 
 public:
-	RobotTask(size_t id, size_t priority, RealTime::Signal* signal, uint8_t *stopCondition, RealTime::timeCount_t *initTime, const char *name);
+	RobotTask(size_t id, size_t priority, RealTime::ReleaseBarrier* barrier, uint8_t *stopCondition, const char *name);
 	~RobotTask(void);
 	void SetFrequency(double frequency);
 	void SetPeriod(RealTime::timeCount_t period);
 	void SetKWIPP(size_t kwipp);
+	void SetWorkload(Workload *engine);
+	static void SetSubscriberQoS(int overflow, uint32_t depth, RealTime::timeCount_t timeout);
 	size_t PublishingRequest(size_t topic, size_t msgSize);
 	size_t SubscribingRequest(size_t topic, size_t msgSize);
 	size_t LeavePubTopic(void);
 	size_t LeaveSubTopic(void);
-	void Start(size_t cpuRun);
+	void SetCPU(size_t cpuRun);
+	void Start(void);
+	void SetActive(bool active);
 	void Join(void);
+	int Join(RealTime::timeCount_t timeout);
 	void Unblock(void);
 	size_t GetID(void);
+	size_t GetCPU(void);
 	double GetFrequency(void);
 	RealTime::timeCount_t GetPeriod(void);
 	double GetPeriodSec(void);
 	//List& GetPublishTopics(void);
 	//List& GetSubscribeTopics(void);
 	size_t GetKWIPP(void);
+	Workload* GetWorkload(void);
 	double GetKWIPS(void);
 	double GetUtilization(uint64_t rawSpeed);
 	size_t GetDeadlineMiss(void);
@@ -95,15 +110,21 @@ public:
 	double GetResponseJitter(void);
 	double GetWCRT(void);
 	double GetWCRJ(void);
+	double GetBCRT(void);
+	double GetResponseTimePercentile(double percentile);
+	double GetResponseJitterPercentile(double percentile);
+	void ExportHistograms(compactHistogram_t *responseTime, compactHistogram_t *responseJitter);
 	void ClearWCRT(void);
 	void ClearWCRJ(void);
-	void WaitSignal(void);
+	RealTime::timeCount_t WaitRelease(void);
 	bool IsTaskStopped(void);
 	uint32_t GetPubMessageSize(void);
 	uint32_t GetSubMessageSize(void);
 	size_t GetPubTopic(void);
 	size_t GetSubTopic(void);
 	void ClearMeasurements(void);
+	TraceRing* GetTraceRing(void);
+	uint32_t GetTraceDropped(void);
 	bool operator == (const RobotTask& task) const { return this->id == task.id; }
 	bool operator == (const size_t id) const { return this->id == id; }
 
@@ -112,6 +133,7 @@ private:
 	void ReceiveMessage(void);
 	void SendMessage(void);
 	void ExecuteWorkload();
+	size_t CheckMessageSize(size_t msgSize);
 };
 
 
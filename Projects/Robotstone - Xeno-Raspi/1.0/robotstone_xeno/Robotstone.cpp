@@ -23,6 +23,8 @@
  */
 
 #include "Robotstone.hpp"
+#include <iostream> //for use of new(pointer)
+#include <string.h>
 
 // Calculates the power of 2 from the value.
 size_t pow2(size_t value)
@@ -39,23 +41,36 @@ size_t pow2(size_t value)
 /**
  * @brief Robotstone high level class constructor.
  *
+ * @param node - The number of this node, Robotstone::masterNode or
+ * 				 a Slave from 1 to robotMAX_SLAVES.
+ *
  */
-Robotstone::Robotstone(void):
-	experimentReachLimit(0),
+Robotstone::Robotstone(uint32_t node):
 	rstoneHeap("hart_heap", 2),
-	initTimeHeap("initT_heap", sizeof(RealTime::timeCount_t)),
 	actualDeadlineMiss(0),
 	subMan(NULL), pubMan(NULL),
-	rawSpeed(RAW_SPEED),
+	localNode(node),
+	peersNumber(1),
+	slavesNumber(1),
+	pingNumber(0),
+	pingPeer(0),
+	pingTime(0),
+	hasPong(false),
 	rstoneTasks(),
+	spareTasks(),
+	rawSpeed(0),
 	rawInterval(0),
-	startTasksSig("start_sig"),
-	actualExp()
+	startBarrier("start_sig"),
+	actualExp(),
+	experimentReachLimit(0)
 {
 	worstScenario.averageResp = 0;
 	worstScenario.test = 0;
 	worstScenario.wcrt = 0;
 	worstScenario.taskID = 0;
+	worstScenario.node = Robotstone::masterNode;
+
+	memset(this->peers, 0, sizeof(this->peers));
 
 	// The raw_interval is a time period used to calculate the raw speed of machine.
 	// E.g.: if raw_single_load=10 and timerPeriod=1000, then raw_interval=10000.
@@ -66,112 +81,572 @@ Robotstone::Robotstone(void):
 	this->stopCondTask = (uint8_t *)this->rstoneHeap.Alloc();
 	*(this->stopCondTask) = 0;
 
-	this->initialTime = (RealTime::timeCount_t *)this->initTimeHeap.Alloc();
-	*(this->initialTime) = 0;
+	this->rawWorkload = this->CreateWorkload();
+
+	this->results = (nodeResults_t *)Heap::Alloc(sizeof(nodeResults_t));
+	if(this->results == NULL)
+	{
+		Stdout::Print("Impossible allocate the test step results.\n");
+		exit(1);
+	}
+
+	Communic::SetDelivery(Communic::allTopics, robotTOPIC_DELIVERY);
+
+	// The handshake of the Master and the Slaves in the topics 0 and 1 can't lose messages,
+	// neither the results of the Slaves.
+	if(robotTOPIC_DELIVERY == Communic::state)
+	{
+		Communic::SetDelivery(0, Communic::gatekeeper);
+		Communic::SetDelivery(1, Communic::gatekeeper);
+		Communic::SetDelivery(robotRESULT_TOPIC, Communic::gatekeeper);
+	}
+	Communic::SetMessageHeader(robotMESSAGE_HEADER);
+	RobotTask::SetSubscriberQoS(robotSUB_OVERFLOW, robotSUB_DEPTH, robotSUB_TIMEOUT);
+
+#ifdef RAW_SPEED
+	// The RAW_SPEED value is only valid for the Whetstone workload.
+	if(this->rawWorkload->GetKind() == Workload::whetstone)
+	{
+		this->rawSpeed = RAW_SPEED;
+	}
+	else
+#endif
+	{
+		this->LoadRawSpeed();
+	}
 }
 
 /**
- * @brief Send a message to the receiver, by means of a handshake.
- * 		  The sender will firstly send a handshake message to initiate
- * 		  the transaction.
+ * @brief Set the number of Slaves coordinated by the Master. It must be
+ * 		  called before the first command, and only in the Master.
  *
- * @param message - Pointer to the buffer message that will be sent.
+ * @param slaves - The number of Slaves, from 1 to robotMAX_SLAVES.
  *
  */
-void Robotstone::HandshakeSend(uint16_t *message)
+void Robotstone::SetSlaves(size_t slaves)
 {
-	uint16_t resMsg = Robotstone::handshakeMsgStep1;
+	this->slavesNumber = slaves;
+	if(this->localNode == Robotstone::masterNode)
+	{
+		this->peersNumber = slaves;
+	}
+}
 
-	// The topic 0 is always used by management tasks communication.
-    // The topic transmit a 2 bytes message. That way, the same memory
-    // buffer is used to transmit expMsg and resMsg.
-	RealTime::Task::Delay(Timer::GetPeriod()/5);
-	this->pubMan->Send(&resMsg);
-	resMsg = 0;
-	// The task will be suspended until message arrives.
-	this->subMan->Receive(&resMsg);
-	if(resMsg != Robotstone::handshakeMsgStep1)
+/**
+ * @brief Get the number of Slaves in the experiment.
+ *
+ * @return The number of Slaves.
+ */
+size_t Robotstone::GetSlaves(void)
+{
+	return this->slavesNumber;
+}
+
+/**
+ * @brief Send a command to all the other nodes and wait for their acknowledgements.
+ * 		  The experiment is finished if a node doesn't answer.
+ *
+ * @param command - The command code.
+ * @param argument - The command value.
+ *
+ */
+void Robotstone::SendCommand(uint16_t command, uint32_t argument)
+{
+	if(this->SendToPeers(0, this->peersNumber, command, argument, Robotstone::commandTimeout) != RealTime::ok)
 	{
-		Stdout::Print("Handshake Send Error: invalid response message in step 1.\n");
+		Stdout::Print("Management protocol error: command %d not acknowledged.\n", command);
 		exit(1);
 	}
-	RealTime::Task::Delay(Timer::GetPeriod()/5);
-    this->pubMan->Send(message);
+}
 
-	// The task will be suspended until message arrives.
-	this->subMan->Receive(&resMsg);
-    if(resMsg != Robotstone::handshakeMsgStep2)
-    {
-		Stdout::Print("Handshake Send Error: invalid response message in step 2.\n");
+/**
+ * @brief Send a command to one of the other nodes and wait for its acknowledgement.
+ * 		  The experiment is finished if the node doesn't answer.
+ *
+ * @param peer - The node index, from 0 to the number of Slaves - 1 in the Master.
+ * @param command - The command code.
+ * @param argument - The command value.
+ *
+ */
+void Robotstone::SendCommandTo(size_t peer, uint16_t command, uint32_t argument)
+{
+	if(this->SendToPeers(peer, peer + 1, command, argument, Robotstone::commandTimeout) != RealTime::ok)
+	{
+		Stdout::Print("Management protocol error: command %d not acknowledged by node %d.\n",
+					  command, this->GetPeerNode(peer));
 		exit(1);
-    }
-    // Delay for the side on sender finish the transaction
-   	// besides this is not a guarantee that other side will
-   	// finish, that is a temporary solution for broadcast
-   	// problem.
-   	RealTime::Task::Delay(RealTime::Timer::GetPeriod());
+	}
+}
+
+/**
+ * @brief Send a command to all the other nodes and wait for their acknowledgements.
+ *
+ * @param command - The command code.
+ * @param argument - The command value.
+ * @param timeout - The maximum time sending the command again, in implementation
+ * 					specific units, or timerMAX_DELAY to try forever.
+ *
+ * @return - RealTime::ok if the command was acknowledged by all nodes;
+ * 		   - RealTime::fail if the timeout expired.
+ */
+int Robotstone::TrySendCommand(uint16_t command, uint32_t argument, timeCount_t timeout)
+{
+	return this->SendToPeers(0, this->peersNumber, command, argument, timeout);
 }
 
 /**
- * @brief Receive a message from the sender, by means of a handshake.
- * 		  The receiver will wait for a handshake message by the sender
- * 		  to initiate the transaction.
+ * @brief Send a command to a range of the other nodes and wait for their acknowledgements.
  *
- * @param message - Pointer to the buffer message that will be sent.
+ * 		  The command is sent to all nodes at once, and sent again each
+ * 		  Robotstone::ackTimeout to the ones that didn't acknowledge it, since
+ * 		  the message or its acknowledgement may be lost in the network, or the
+ * 		  other node may not be subscribed in the topic yet. The receiver
+ * 		  discards the copies by the command sequence.
  *
+ * @param first - The index of the first node.
+ * @param last - The index after the last node.
+ * @param command - The command code.
+ * @param argument - The command value.
+ * @param timeout - The maximum time sending the command again, in implementation
+ * 					specific units, or timerMAX_DELAY to try forever.
+ *
+ * @return - RealTime::ok if the command was acknowledged by all the nodes;
+ * 		   - RealTime::fail if the timeout expired.
  */
-void Robotstone::HandshakeReceive(uint16_t *message)
+int Robotstone::SendToPeers(size_t first, size_t last, uint16_t command, uint32_t argument, timeCount_t timeout)
 {
-	uint16_t resMsg = 0;
+	manMessage_t msg;
+	timeCount_t start = Timer::GetTime();
+	timeCount_t sent;
+	bool isDone;
+
+	for(size_t i = first; i < last; ++i)
+	{
+		this->peers[i].sendSequence++;
+		this->peers[i].isAcknowledged = false;
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.command = command;
+	msg.argument = argument;
+
+	while(true)
+	{
+		for(size_t i = first; i < last; ++i)
+		{
+			if(!this->peers[i].isAcknowledged)
+			{
+				msg.sequence = this->peers[i].sendSequence;
+				msg.node = (this->localNode == Robotstone::masterNode)? this->GetPeerNode(i) : this->localNode;
+				this->pubMan->Send(&msg);
+			}
+		}
+		sent = Timer::GetTime();
+
+		while(Timer::GetTime() - sent < Robotstone::ackTimeout)
+		{
+			this->ReceiveCommand(Robotstone::ackTimeout - (Timer::GetTime() - sent));
+
+			isDone = true;
+			for(size_t i = first; i < last; ++i)
+			{
+				isDone = isDone && this->peers[i].isAcknowledged;
+			}
+			if(isDone)
+			{
+				return RealTime::ok;
+			}
+		}
+
+		if((timeout != timerMAX_DELAY) && (Timer::GetTime() - start >= timeout))
+		{
+			return RealTime::fail;
+		}
+	}
+}
+
+/**
+ * @brief Wait for a command from all the other nodes.
+ *
+ * @param command - The command code expected. The experiment is
+ * 					finished if another command arrives.
+ * @param timeout - The maximum wait for each node in implementation specific
+ * 					units, or timerMAX_DELAY to wait forever. The experiment
+ * 					is finished if it expires.
+ *
+ * @return The biggest command value among the nodes.
+ */
+uint32_t Robotstone::WaitCommand(uint16_t command, timeCount_t timeout)
+{
+	uint32_t value = 0;
+	uint32_t argument;
+
+	for(size_t i = 0; i < this->peersNumber; ++i)
+	{
+		argument = this->WaitCommandFrom(i, command, timeout);
+		value = (argument > value)? argument : value;
+	}
+	return value;
+}
+
+/**
+ * @brief Wait for a command from one of the other nodes. The commands
+ * 		  of the other nodes are kept meanwhile.
+ *
+ * @param peer - The node index, from 0 to the number of Slaves - 1 in the Master.
+ * @param command - The command code expected. The experiment is
+ * 					finished if another command arrives.
+ * @param timeout - The maximum wait in implementation specific units, or
+ * 					timerMAX_DELAY to wait forever. The experiment is
+ * 					finished if it expires.
+ *
+ * @return The command value.
+ */
+uint32_t Robotstone::WaitCommandFrom(size_t peer, uint16_t command, timeCount_t timeout)
+{
+	manPeer_t *state = &this->peers[peer];
+	timeCount_t start = Timer::GetTime();
+
+	while(!state->hasPending)
+	{
+		if((timeout != timerMAX_DELAY) && (Timer::GetTime() - start >= timeout))
+		{
+			Stdout::Print("Management protocol error: command %d not received from node %d.\n",
+						  command, this->GetPeerNode(peer));
+			exit(1);
+		}
+		this->ReceiveCommand(Robotstone::ackTimeout);
+	}
+	state->hasPending = false;
 
-	// The task will be suspended until message arrives.
-	this->subMan->Receive(&resMsg);
-	if(resMsg != Robotstone::handshakeMsgStep1)
+	if(state->pendingCmd.command != command)
 	{
-		Stdout::Print("Handshake Receive Error: invalid response message in step 1.\n");
+		Stdout::Print("Management protocol error: command %d received from node %d while %d was expected.\n",
+					  state->pendingCmd.command, this->GetPeerNode(peer), command);
 		exit(1);
 	}
+	return state->pendingCmd.argument;
+}
 
-	RealTime::Task::Delay(Timer::GetPeriod()/5);
-	this->pubMan->Send(&resMsg);
+/**
+ * @brief Wait until all nodes reach the same point, exchanging a value.
+ *
+ * 		  Each Slave sends the command to the Master and waits for its answer,
+ * 		  which is sent only after all the Slaves arrived, so no node leaves
+ * 		  the barrier before the others arrive. The messages grow linearly
+ * 		  with the number of Slaves, instead of with its square.
+ *
+ * @param command - The command code of the barrier.
+ * @param argument - The value given to the other nodes.
+ *
+ * @return The biggest value given by the nodes, including this one in the Master.
+ */
+uint32_t Robotstone::Barrier(uint16_t command, uint32_t argument)
+{
+	uint32_t value;
 
-	// The task will be suspended until message arrives.
-	this->subMan->Receive(message);
+	if(this->localNode == Robotstone::masterNode)
+	{
+		value = this->WaitCommand(command);
+		value = (argument > value)? argument : value;
+		this->SendCommand(command, value);
+		return value;
+	}
 
-	RealTime::Task::Delay(Timer::GetPeriod()/5);
-	resMsg = Robotstone::handshakeMsgStep2;
-	this->pubMan->Send(&resMsg);
+	this->SendCommand(command, argument);
+	return this->WaitCommand(command);
+}
+
+/**
+ * @brief Estimate the clocks of the other nodes, which must do the same at the same time.
+ *
+ * 		  The Master and each Slave send in turn Robotstone::syncExchanges pings
+ * 		  to each other, answered with the receive and send times of the node.
+ * 		  The exchanges are given to Timer::AddPeerSample, and the round is closed
+ * 		  by Timer::UpdatePeerClock, which refreshes the offset and the drift used
+ * 		  to correct the times of the messages that come from the node. The
+ * 		  Slaves are synchronized one after the other, so the pings of a round
+ * 		  don't wait for the ones of another Slave.
+ */
+void Robotstone::SyncClock(void)
+{
+	if(this->localNode == Robotstone::masterNode)
+	{
+		for(size_t i = 0; i < this->peersNumber; ++i)
+		{
+			// The Slave answers the pings from its arrival.
+			this->WaitCommandFrom(i, Robotstone::cmdSync);
+			this->PingPeer(i);
+
+			// The pings of the Slave are answered until it finishes.
+			this->SendCommandTo(i, Robotstone::cmdSync, 0);
+			this->WaitCommandFrom(i, Robotstone::cmdSync);
+		}
+		return;
+	}
+
+	this->SendCommand(Robotstone::cmdSync, 0);
+	this->WaitCommand(Robotstone::cmdSync);
+	this->PingPeer(0);
+	this->SendCommand(Robotstone::cmdSync, 0);
+}
+
+/**
+ * @brief Make a clock synchronization round with another node.
+ *
+ * 		  A ping not answered in Robotstone::ackTimeout is not used.
+ *
+ * @param peer - The node index, from 0 to the number of Slaves - 1 in the Master.
+ *
+ */
+void Robotstone::PingPeer(size_t peer)
+{
+	manMessage_t ping;
+
+	memset(&ping, 0, sizeof(ping));
+	ping.command = Robotstone::cmdPing;
+	ping.node = (this->localNode == Robotstone::masterNode)? this->GetPeerNode(peer) : this->localNode;
+	this->pingPeer = peer;
+
+	for(uint32_t i = 0; i < Robotstone::syncExchanges; ++i)
+	{
+		ping.argument = ++this->pingNumber;
+		this->hasPong = false;
+		this->pingTime = Timer::GetTime();
+		this->pubMan->Send(&ping);
+
+		while(!this->hasPong && (Timer::GetTime() - this->pingTime < Robotstone::ackTimeout))
+		{
+			this->ReceiveCommand(Robotstone::ackTimeout - (Timer::GetTime() - this->pingTime));
+		}
+	}
+
+	Timer::UpdatePeerClock(this->GetPeerNode(peer));
+}
+
+/**
+ * @brief Wait until all the synthetic tasks are waiting for the release
+ * 		  of the test step. The experiment is finished if a task doesn't arrive.
+ */
+void Robotstone::WaitTasksReady(void)
+{
+	if(this->startBarrier.WaitArrivals(Robotstone::arrivalTimeout) != RealTime::ok)
+	{
+		Stdout::Print("Only %d of %d tasks are ready to start the test step.\n",
+					  this->startBarrier.GetArrived(), this->startBarrier.GetRegistered());
+		exit(1);
+	}
+}
 
-	// Delay for the side on sender finish the transaction
-	// besides this is not a guarantee that other side will
-	// finish, that is a temporary solution for broadcast
-	// problem.
-	//RealTime::Task::Delay(RealTime::Timer::GetPeriod());
+/**
+ * @brief Release all the synthetic tasks at the same time instant,
+ * 		  which is the first activation of the test step.
+ */
+void Robotstone::ReleaseTasks(void)
+{
+	this->startBarrier.Release(Timer::GetTime() + Robotstone::releaseDelay);
 }
 
 /**
- * @brief Calculate the the processor raw speed in KWIPS and saves in
- *        internal Robotstone attributes.
+ * @brief Receive one message of the management protocol, if it arrives in the timeout.
+ *
+ * 		  An acknowledgement of the last command sent to the node is recorded.
+ * 		  A new command is acknowledged and kept until it is taken by
+ * 		  Robotstone::WaitCommandFrom. While a command of a node is kept the
+ * 		  next one is not acknowledged, so the node repeats it. The copies of
+ * 		  a command already kept are acknowledged again, because the first
+ * 		  acknowledgement may have been lost. The messages of the Master to
+ * 		  other Slaves are ignored.
+ *
+ * @param timeout - The maximum wait in implementation specific units.
+ *
+ */
+void Robotstone::ReceiveCommand(timeCount_t timeout)
+{
+	manMessage_t msg;
+	manMessage_t ack;
+	timeCount_t received;
+	manPeer_t *state;
+	size_t peer;
+
+	if(this->subMan->Receive(&msg, timeout) == 0)
+	{
+		return;
+	}
+	received = Timer::GetTime();
+
+	peer = this->GetPeer(&msg);
+	if(peer >= this->peersNumber)
+	{
+		return;
+	}
+	state = &this->peers[peer];
+
+	memset(&ack, 0, sizeof(ack));
+	ack.node = msg.node;
+
+	// The clock exchanges are out of the commands sequence.
+	if(msg.command == Robotstone::cmdPing)
+	{
+		ack.command = Robotstone::cmdPong;
+		ack.argument = msg.argument;
+		ack.times[0] = received;
+		ack.times[1] = Timer::GetTime();
+		this->pubMan->Send(&ack);
+		return;
+	}
+
+	if(msg.command == Robotstone::cmdPong)
+	{
+		if((peer == this->pingPeer) && (msg.argument == this->pingNumber))
+		{
+			Timer::AddPeerSample(this->pingTime, msg.times[0], msg.times[1], received, this->GetPeerNode(peer));
+			this->hasPong = true;
+		}
+		return;
+	}
+
+	if(msg.command == Robotstone::cmdAck)
+	{
+		if(msg.sequence == state->sendSequence)
+		{
+			state->isAcknowledged = true;
+		}
+		return;
+	}
+
+	// The sequences are compared in modulo arithmetic, so they may wrap around.
+	if((int16_t)(msg.sequence - state->recvSequence) > 0)
+	{
+		if(state->hasPending)
+		{
+			return;
+		}
+		state->pendingCmd = msg;
+		state->hasPending = true;
+		state->recvSequence = msg.sequence;
+	}
+
+	ack.command = Robotstone::cmdAck;
+	ack.sequence = msg.sequence;
+	this->pubMan->Send(&ack);
+}
+
+/**
+ * @brief Get the node that exchanges a management message with this one.
+ *
+ * @param msg - The message received.
+ *
+ * @return The node index, or a value not smaller than the number of
+ * 		   nodes if the message is not for this node.
+ */
+size_t Robotstone::GetPeer(const manMessage_t *msg)
+{
+	if(this->localNode == Robotstone::masterNode)
+	{
+		return (msg->node == Robotstone::masterNode)? this->peersNumber : msg->node - 1;
+	}
+	return (msg->node == this->localNode)? 0 : this->peersNumber;
+}
+
+/**
+ * @brief Get the number of one of the other nodes.
+ *
+ * @param peer - The node index, from 0 to the number of Slaves - 1 in the Master.
+ *
+ * @return The node number: the Slave peer + 1 in the Master, or Robotstone::masterNode in a Slave.
+ */
+uint32_t Robotstone::GetPeerNode(size_t peer)
+{
+	return (this->localNode == Robotstone::masterNode)? peer + 1 : Robotstone::masterNode;
+}
+
+/**
+ * @brief Calculate the the processor raw speed in units of the task workload
+ * 		  per second (KWIPS for Whetstone) and saves in internal Robotstone attributes.
  *
  */
 void Robotstone::CalculeRawSpeed(void)
 {
-	timeCount_t startTime, periodReached = 0, executionTime;
-	this->rawSpeed = 0;
+	char key[CalibrationCache::maxKeySize];
+	CalibrationCache cache(robotCALIB_FILE);
 
-	// If the loop reach interval time, return the KWIPS stored in raw_speed.
-	while( periodReached < this->rawInterval ){
+	// Execute batches of raw_single_load units until the raw_interval is reached.
+	this->rawSpeed = this->rawWorkload->Calibrate(this->rawInterval, Robotstone::rawSingleLoad);
 
-		startTime = RealTime::Timer::GetTime();
+	CalibrationCache::BuildKey(key, sizeof(key), this->rawWorkload, robotWORKLOAD_SET);
+	cache.Store(key, this->rawSpeed);
+}
 
-		WHETSTONE_EXECUTE(this->rawSingleLoad);
+/**
+ * @brief Take the processor raw speed from the calibration cache, measuring
+ * 		  it only when the cache has no value for the machine or when a short
+ * 		  probe shows that the value drifted.
+ *
+ */
+void Robotstone::LoadRawSpeed(void)
+{
+	char key[CalibrationCache::maxKeySize];
+	CalibrationCache cache(robotCALIB_FILE);
+	uint64_t cached, probe, difference;
+
+	CalibrationCache::BuildKey(key, sizeof(key), this->rawWorkload, robotWORKLOAD_SET);
+
+	if(cache.Find(key, &cached))
+	{
+		probe = this->rawWorkload->Calibrate((Robotstone::rawProbeTime*Timer::GetPeriod())/1000, Robotstone::rawSingleLoad);
+		difference = (probe > cached)? probe - cached : cached - probe;
+
+		if(difference*100 <= cached*Robotstone::rawTolerance)
+		{
+			this->rawSpeed = cached;
+			return;
+		}
+		Stdout::Print("Cached raw speed %lld differs from the probe %lld. Calibrating again...\n", cached, probe);
+	}
+	else
+	{
+		Stdout::Print("No raw speed calibration for this machine. Calibrating...\n");
+	}
+
+	this->CalculeRawSpeed();
+}
+
+/**
+ * @brief Calculate the raw speed of each processor, alone and with all
+ * 		  the processors busy, and print them.
+ *
+ */
+void Robotstone::CalculeCoreSpeeds(void)
+{
+	void *p = RealTime::Heap::Alloc(sizeof(CoreCalibrator));
+	CoreCalibrator *calibrator;
+	speedEstimate_t alone, busy;
+	double slowdown = 0;
 
-		executionTime = RealTime::Timer::GetTime() - startTime;
+	if(p == NULL)
+	{
+		Stdout::Print("Impossible allocate the per-core calibration.\n");
+		exit(1);
+	}
+	calibrator = new(p) CoreCalibrator(robotWORKLOAD_KIND, robotWORKLOAD_SET, Robotstone::rawSingleLoad);
 
-		this->rawSpeed++;
-		periodReached += executionTime;
+	Stdout::Print("Measuring the raw speed of %d processors...\n", calibrator->GetCoresNumber());
+	calibrator->Run();
 
+	Stdout::Print("Raw speed per processor in %s per second\n", calibrator->GetUnitName());
+	Stdout::Print("(mean +- 95%% confidence interval of %d samples after %d warm-up samples):\n\n",
+				  CoreCalibrator::samplesNumber, CoreCalibrator::warmUpSamples);
+	Stdout::Print("CPU\tAlone\t\t\tAll CPUs busy\t\tSlowdown\n");
+	for(size_t i = 0; i < calibrator->GetCoresNumber(); ++i)
+	{
+		alone = calibrator->GetAloneSpeed(i);
+		busy = calibrator->GetBusySpeed(i);
+		Stdout::Print("%d\t%.0f +- %.0f\t%.0f +- %.0f\t%f\n", i, alone.mean, alone.confidence,
+					  busy.mean, busy.confidence, calibrator->GetSlowdown(i));
+		slowdown += calibrator->GetSlowdown(i);
 	}
+	Stdout::Print("\nAverage slowdown with all CPUs busy: %f\n\n", slowdown/calibrator->GetCoresNumber());
 }
 
 /**
@@ -186,23 +661,263 @@ uint64_t Robotstone::GetRawSpeed(void)
 }
 
 /**
- * @brief Save the worst case scenario in the experiment.
+ * @brief Create a workload of the kind executed by the synthetic tasks.
+ *
+ * @return The workload instance, to be given to RobotTask::SetWorkload.
+ *
+ */
+Workload* Robotstone::CreateWorkload(void)
+{
+	return Workload::Create(robotWORKLOAD_KIND, robotWORKLOAD_SET);
+}
+
+/**
+ * @brief Save the results of the node tasks in the test step, to be
+ * 		  sent to the Master or merged with the ones of the Slaves.
+ *
+ * 		  The tasks beyond robotRESULT_MAX_TASKS are only counted. The
+ * 		  tasks of the Master publish and the ones of the Slaves subscribe.
  *
- * @param The test step in a experiment.
+ * @param test - The test step number.
  *
  */
-void Robotstone::GetWorstCase(size_t test)
+void Robotstone::CollectResults(size_t test)
 {
+	bool isMaster = (this->localNode == Robotstone::masterNode);
+	RobotTask *task;
+	taskResult_t *record;
+
+	this->results->test = test;
+	this->results->node = this->localNode;
+	this->results->number = 0;
+	this->results->total = 0;
+
 	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
 	{
+		task = rstoneTasks.GetValue();
+		this->results->total++;
+
+		if(this->results->number == robotRESULT_MAX_TASKS)
+		{
+			continue;
+		}
+		record = &this->results->tasks[this->results->number++];
+
+		record->taskID = task->GetID();
+		record->cpu = task->GetCPU();
+		record->topic = isMaster? task->GetPubTopic() : task->GetSubTopic();
+		record->reserved = 0;
+		record->kwipp = task->GetKWIPP();
+		record->messageSize = isMaster? task->GetPubMessageSize() : task->GetSubMessageSize();
+		record->deadlineMet = task->GetDeadlineMet();
+		record->deadlineMiss = task->GetDeadlineMiss();
+		record->deadlineSkip = task->GetDeadlineSkip();
+		record->alignment = 0;
+		record->frequency = task->GetFrequency();
+		record->period = task->GetPeriodSec();
+		record->kwips = task->GetKWIPS();
+		record->utilization = task->GetUtilization(this->GetRawSpeed());
+		record->responseTime = task->GetResponseTime();
+		record->wcrt = task->GetWCRT();
+		record->bcrt = task->GetBCRT();
+		record->responseJitter = task->GetResponseJitter();
+		task->ExportHistograms(&record->responseTimeHist, &record->responseJitterHist);
+	}
+}
+
+/**
+ * @brief Print the processor raw speed in the unit of the task workload.
+ *
+ */
+void Robotstone::PrintRawSpeed(void)
+{
+	if(this->rawWorkload->GetKind() == Workload::whetstone)
+	{
+		Stdout::Print("Raw speed in Kilo-Whetstone Instructions Per Second (KWIPS): %lld\n\n", this->GetRawSpeed());
+	}
+	else
+	{
+		Stdout::Print("Workload: %s\n", this->rawWorkload->GetName());
+		Stdout::Print("Raw speed in %s Per Second: %lld\n", this->rawWorkload->GetUnitName(), this->GetRawSpeed());
+		Stdout::Print("(The KWIPP and KWIPS columns are in %s.)\n\n", this->rawWorkload->GetUnitName());
+	}
+}
+
+/**
+ * @brief Print the processor of each task, when the task set is
+ * 		  replicated in more than one processor.
+ *
+ */
+void Robotstone::PrintPartitions(void)
+{
+	if(RealTime::GetExecCPUS() == 1)
+	{
+		return;
+	}
+
+	Stdout::Print("Partitioned multicore: one task set in each CPU from 0 to %d.\n\n", RealTime::GetExecCPUS() - 1);
+	Stdout::Print("Task\tCPU\n");
+	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
+	{
+		Stdout::Print("%d\t%d\n", rstoneTasks.GetValue()->GetID(), rstoneTasks.GetValue()->GetCPU());
+	}
+	Stdout::Print("\n");
+}
+
+/**
+ * @brief Print how the topics messages are delivered to the subscribers.
+ *
+ */
+void Robotstone::PrintDelivery(void)
+{
+	Stdout::Print("Topic delivery: %s\n", (robotTOPIC_DELIVERY == Communic::direct)? "direct (publisher to subscribers)" :
+					(robotTOPIC_DELIVERY == Communic::state)? "state (last sample slot)" : "gatekeeper task");
+	Stdout::Print("Subscriber queue: %d messages, %s\n\n", robotSUB_DEPTH,
+					(robotSUB_OVERFLOW == Communic::keepLast)? "keep last" :
+					(robotSUB_OVERFLOW == Communic::blocking)? "blocking" : "drop newest");
+}
+
+/**
+ * @brief Print the estimate of the clock of each other node, used to correct
+ * 		  the latencies of the messages that come from the node.
+ */
+void Robotstone::PrintClockSync(void)
+{
+	double period = Timer::GetPeriod();
+	uint32_t node;
+	bool isSynced = false;
+
+	for(size_t i = 0; i < this->peersNumber; ++i)
+	{
+		node = this->GetPeerNode(i);
+		if(!Timer::IsPeerSynced(node))
+		{
+			continue;
+		}
+
+		if(node == Robotstone::masterNode)
+		{
+			Stdout::Print("Clock of the Master: ");
+		}
+		else
+		{
+			Stdout::Print("Clock of the Slave %d: ", node);
+		}
+		Stdout::Print("offset %f s, drift %f ppm, round trip %f s\n",
+						Timer::GetPeerOffset(node)/period, Timer::GetPeerDrift(node)*1000000.0, Timer::GetPeerRoundTrip(node)/period);
+		isSynced = true;
+	}
+
+	if(isSynced)
+	{
+		Stdout::Print("Clock correction of the other nodes latencies: %s\n\n", Network::IsEnabled()? "yes" : "no (same clock)");
+	}
+}
+
+/**
+ * @brief Save the worst case scenario in the experiment.
+ *
+ * @param nodeResults - The results of the tasks of a node in a test step.
+ *
+ */
+void Robotstone::GetWorstCase(const nodeResults_t *nodeResults)
+{
+	const taskResult_t *task;
+
+	for(uint32_t i = 0; i < nodeResults->number; ++i)
+	{
+		task = &nodeResults->tasks[i];
+
 		if((this->worstScenario.averageResp == 0) ||
-           ((rstoneTasks.GetValue()->GetWCRT()/rstoneTasks.GetValue()->GetResponseTime()) >
-								(this->worstScenario.wcrt/this->worstScenario.averageResp)))
+           ((task->wcrt/task->responseTime) > (this->worstScenario.wcrt/this->worstScenario.averageResp)))
 		{
-			this->worstScenario.wcrt = rstoneTasks.GetValue()->GetWCRT();
-			this->worstScenario.averageResp = rstoneTasks.GetValue()->GetResponseTime();
-			this->worstScenario.taskID = rstoneTasks.GetValue()->GetID();
-			this->worstScenario.test = test;
+			this->worstScenario.wcrt = task->wcrt;
+			this->worstScenario.averageResp = task->responseTime;
+			this->worstScenario.taskID = task->taskID;
+			this->worstScenario.test = nodeResults->test;
+			this->worstScenario.node = nodeResults->node;
 		}
 	}
 }
+
+/**
+ * @brief Convert an experiment step to a handshake message.
+ *
+ * @param step - The experiment step, rounded to Robotstone::stepResolution.
+ *
+ * @return The handshake message.
+ */
+uint32_t Robotstone::EncodeStep(double step)
+{
+	return (uint32_t)(step*Robotstone::stepResolution + 0.5);
+}
+
+/**
+ * @brief Convert a handshake message to an experiment step.
+ *
+ * @param message - The message made by Robotstone::EncodeStep.
+ *
+ * @return The experiment step.
+ */
+double Robotstone::DecodeStep(uint32_t message)
+{
+	return ((double)message)/Robotstone::stepResolution;
+}
+
+/**
+ * @brief Print the response time and response jitter percentiles
+ * 		  of all tasks in the test step.
+ *
+ */
+void Robotstone::PrintPercentiles(void)
+{
+	Stdout::Print("\nTask\tResp. Time (s)\n");
+	Stdout::Print("    \tp50\t\tp90\t\tp99\t\tp99.9\t\tp99.99\n");
+
+	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
+	{
+		Stdout::Print("%d", rstoneTasks.GetValue()->GetID());
+		for(size_t i = 0; i < sizeof(reportPercentiles)/sizeof(reportPercentiles[0]); ++i)
+		{
+			Stdout::Print("\t%f", rstoneTasks.GetValue()->GetResponseTimePercentile(reportPercentiles[i]));
+		}
+		Stdout::Print("\n");
+	}
+
+	Stdout::Print("\nTask\tResp. Jitter (s)\n");
+	Stdout::Print("    \tp50\t\tp90\t\tp99\t\tp99.9\t\tp99.99\n");
+
+	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
+	{
+		Stdout::Print("%d", rstoneTasks.GetValue()->GetID());
+		for(size_t i = 0; i < sizeof(reportPercentiles)/sizeof(reportPercentiles[0]); ++i)
+		{
+			Stdout::Print("\t%f", rstoneTasks.GetValue()->GetResponseJitterPercentile(reportPercentiles[i]));
+		}
+		Stdout::Print("\n");
+	}
+}
+
+/**
+ * @brief Print the number of activation records saved in the trace
+ * 		  file and the number of records dropped in the test step.
+ *
+ */
+void Robotstone::PrintTraceStatus(void)
+{
+	uint32_t dropped = 0;
+
+	if(!this->tracer.IsEnabled())
+	{
+		Stdout::Print("\nTrace file: disabled\n");
+		return;
+	}
+
+	for(rstoneTasks.InitIteration(); !rstoneTasks.IsEnd(); ++rstoneTasks)
+	{
+		dropped += rstoneTasks.GetValue()->GetTraceDropped();
+	}
+
+	Stdout::Print("\nTrace file: %s (%lld records)\n", this->tracer.GetFileName(), this->tracer.GetRecordCount());
+	Stdout::Print("Trace records dropped in the test: %d\n", dropped);
+}
@@ -19,7 +19,9 @@
  * @section DESCRIPTION
  *
  * This module contains the implementation of the Robotstone high-level class,
- * which will be inherited from more specific classes for the Master and Slave node.
+ * which will be inherited from more specific classes for the Master and Slave nodes.
+ * One Master coordinates from 1 to robotMAX_SLAVES Slaves, numbered from 1,
+ * while the Master is the node 0.
  */
 
 
@@ -30,12 +32,17 @@
 #include "task.hpp"
 #include "realtime.hpp"
 #include "communic.hpp"
+#include "network.hpp"
 #include "RobotTask.hpp"
 #include "whetstone.h"
 #include "stdout.hpp"
 #include "signal.h"
 #include "rtheap.hpp"
 #include "test_led.hpp"
+#include "trace.hpp"
+#include "workload.hpp"
+#include "calibration.hpp"
+#include "breakdown.hpp"
 
 using namespace RealTime;
 
@@ -43,23 +50,124 @@ typedef struct
 {
 	double wcrt;
 	double averageResp;
-	uint8_t taskID;
+	uint16_t taskID;
 	uint32_t test;
+	uint32_t node; /**< The node number, Robotstone::masterNode or a Slave. */
 }worstCaseScenario_t;
 
+/**
+ * @brief A message of the management protocol between the Master and a Slave,
+ * 		  sent in the topic 0 by the Master and in the topic 1 by the Slaves.
+ */
+typedef struct
+{
+	uint16_t command; /**< The command code, or Robotstone::cmdAck. */
+	uint16_t sequence; /**< The command sequence in the sender, repeated in its acknowledgement. */
+	uint32_t argument; /**< The command value. */
+	uint32_t node; /**< The number of the Slave that sends or receives the message. */
+	uint32_t reserved;
+	timeCount_t times[2]; /**< In a Robotstone::cmdPong, when the ping was received and when the pong was sent. */
+}manMessage_t;
+
+/**
+ * @brief The management protocol state of the exchanges with another node.
+ */
+typedef struct
+{
+	uint16_t sendSequence; /**< Sequence of the last command sent. */
+	uint16_t recvSequence; /**< Sequence of the last command received. */
+	manMessage_t pendingCmd; /**< A command received and not taken by Robotstone::WaitCommand yet. */
+	bool hasPending;
+	bool isAcknowledged; /**< Indicates that the last command sent was acknowledged. */
+}manPeer_t;
+
 
 /*MACROS*/
 /*=======================================================================================*/
 
+#ifdef RT_POSIX
+#define robotRT_NAME "POSIX threads (SCHED_FIFO) on Linux"
+#else
 #define robotRT_NAME "Xenomai 3.0.8 on Raspbian Linux 4.9.80 Debian 9 stretch"
+#endif
 
 #define robotEXTRA_VISUALIZATION
 
-#define RAW_SPEED 413500
+#define robotMAN_CPU 0 /**< The processor of the management task. */
+
+#define robotTRACE true /**< Save the activation record of each job of the synthetic tasks in a trace file. */
+#define robotTRACE_MASTER_FILE "robotstone_master.trace" /**< The activation trace of the Master tasks. */
+#define robotTRACE_SLAVE_FILE "robotstone_slave%d.trace" /**< The activation trace of the tasks of each Slave, by its number. */
+
+#define robotCALIB_FILE "robotstone.calib" /**< The cache of raw speed calibrations. */
+
+// Uncomment to force a Whetstone raw speed, skipping the calibration and its cache.
+//#define RAW_SPEED 413500
+
+#define robotWORKLOAD_KIND Workload::whetstone /**< The kind of workload executed by the synthetic tasks. */
+#define robotWORKLOAD_SET 1048576 /**< The working set in bytes of each task with a memory workload. */
+
+#define robotMAX_TASK_ID 0xFFFF /**< The biggest task identifier, which has 16 bits in the reports and traces. */
+
+#define robotSEARCH_PRECISION 0.1 /**< Bracket width in experiment steps where the breakdown search stops. */
+
+#define robotNET_MASTER_PORT 47000 /**< UDP port of the topic 0 in the Master node, the topic n uses the port + n. */
+#define robotNET_SLAVE_PORT 47400 /**< UDP port of the topic 0 in the Slave 1, the topic n uses the port + n. */
+#define robotNET_SLAVE_STRIDE 256 /**< Distance between the ports of consecutive Slaves, so they may run in the same machine. */
+
+#define robotMAX_SLAVES 15 /**< Maximum number of Slaves, whose clocks are estimated by Timer with the Master one. */
+
+#define robotTOPIC_DELIVERY Communic::gatekeeper /**< How the tasks topics messages reach the subscribers: Communic::gatekeeper, Communic::direct or Communic::state. Must be equal in Master and Slave. */
+#define robotSUB_OVERFLOW Communic::dropNewest /**< What a full subscriber queue does: Communic::keepLast, Communic::dropNewest or Communic::blocking. */
+#define robotSUB_DEPTH 30 /**< Number of messages kept for each subscriber task. */
+#define robotSUB_TIMEOUT 1000000 /**< Maximum wait for room in a subscriber queue in Communic::blocking, in implementation specific units (1 ms). */
+#define robotRESULT_MAX_TASKS 256 /**< Maximum number of task records in the results of a node. */
+#define robotRESULT_TOPIC 255 /**< Topic of the Slaves results, after the ones of the tasks. It must be exchanged by Network. */
+#define robotMESSAGE_HEADER true /**< Put a timestamp and a sequence in each message, to measure the topics latency. Must be equal in Master and Slave. */
 
 /*MODULE TYPES*/
 /*=======================================================================================*/
 
+/**
+ * @brief The results of a synthetic task in a test step. The times are in seconds.
+ */
+typedef struct
+{
+	uint16_t taskID;
+	uint16_t cpu;
+	uint16_t topic; /**< The topic where the task publishes or subscribes. */
+	uint16_t reserved;
+	uint32_t kwipp;
+	uint32_t messageSize;
+	uint32_t deadlineMet;
+	uint32_t deadlineMiss;
+	uint32_t deadlineSkip;
+	uint32_t alignment; /**< Keeps the times aligned to 8 bytes in both nodes. */
+	double frequency;
+	double period;
+	double kwips;
+	double utilization; /**< In percentage of the node raw speed. */
+	double responseTime; /**< The average response time. */
+	double wcrt;
+	double bcrt;
+	double responseJitter; /**< The average response jitter. */
+	compactHistogram_t responseTimeHist;
+	compactHistogram_t responseJitterHist;
+}taskResult_t;
+
+/**
+ * @brief The results of all the synthetic tasks of a node in a test step,
+ * 		  sent by each Slave to the Master in the topic robotRESULT_TOPIC.
+ */
+typedef struct
+{
+	uint32_t test; /**< The test step number. */
+	uint32_t node; /**< The node number, Robotstone::masterNode or a Slave. */
+	uint32_t number; /**< Number of records used in tasks. */
+	uint32_t total; /**< Number of tasks in the node, more than number if some didn't fit. */
+	taskResult_t tasks[robotRESULT_MAX_TASKS];
+}nodeResults_t;
+
 size_t pow2(size_t value);
 
 static const RealTime::timeCount_t uniBaselineFrequency[5] = {63, 30, 14, 10, 6};
@@ -67,6 +175,8 @@ static const RealTime::timeCount_t uniBaselineFrequency[5] = {63, 30, 14, 10, 6}
 
 static const RealTime::timeCount_t distBaselineFrequency[3] = {7, 5, 3};
 
+static const double reportPercentiles[5] = {50, 90, 99, 99.9, 99.99}; /**< Percentiles of response time and jitter shown in reports. */
+
 
 /*CLASSES*/
 /*=======================================================================================*/
@@ -74,9 +184,27 @@ static const RealTime::timeCount_t distBaselineFrequency[3] = {7, 5, 3};
 class Robotstone
 {
 public:
-	static const uint16_t handshakeMsgStep1 = 666;
-	static const uint16_t handshakeMsgStep2 = 667;
-	static const size_t deadlineHandshake = 777;
+	static const uint16_t cmdAck = 0; /**< Acknowledgement of a command. */
+	static const uint16_t cmdConnect = 1; /**< The Slave is ready to receive the experiment. */
+	static const uint16_t cmdExperiment = 2; /**< The experiment chosen in the Master. */
+	static const uint16_t cmdCPUs = 3; /**< The number of processors used by the Master. */
+	static const uint16_t cmdReady = 4; /**< Barrier: the node is ready to start the test step. */
+	static const uint16_t cmdStop = 5; /**< The Master finished the test step. */
+	static const uint16_t cmdResults = 6; /**< From a Slave, its results are ready with the deadlines missed as value. From the Master, 0 to publish them or 1 if they were received. */
+	static const uint16_t cmdStatus = 7; /**< Robotstone::isFinished or Robotstone::isRun after each test step. */
+	static const uint16_t cmdUpdate = 8; /**< The Slave is ready to update the experiment step. */
+	static const uint16_t cmdStep = 9; /**< The next experiment step, encoded by Robotstone::EncodeStep. */
+	static const uint16_t cmdLimit = 10; /**< Barrier: 1 if the Slave could not create the tasks of the step, or 0. */
+	static const uint16_t cmdSync = 11; /**< A Slave is ready for or finished its clock synchronization round. From the Master, the Slave round starts. */
+	static const uint16_t cmdPing = 12; /**< A clock synchronization exchange, answered at once without acknowledgement. */
+	static const uint16_t cmdPong = 13; /**< The answer of a Robotstone::cmdPing, with the times of the other node. */
+	static const uint16_t cmdSlaves = 14; /**< The number of Slaves coordinated by the Master. */
+	static const uint32_t syncExchanges = 16; /**< Clock exchanges in each synchronization round. */
+	static const timeCount_t ackTimeout = 100000000; /**< Wait for an acknowledgement before sending a command again. (in ns. 100 ms.) */
+	static const timeCount_t commandTimeout = 30000000000; /**< Maximum time sending a command again before giving up. (in ns. 30 seconds.) */
+	static const timeCount_t arrivalTimeout = 10000000000; /**< Maximum wait for the tasks to be ready for a test step. (in ns. 10 seconds.) */
+	static const timeCount_t releaseDelay = 10000000; /**< Time given to the tasks to wake up before the start of a test step. (in ns. 10 ms.) */
+	static const timeCount_t resultTimeout = 1000000000; /**< Wait for the results message after its Robotstone::cmdResults. (in ns. 1 second.) */
 	static const size_t calculateRawSpeed = 0;
 	static const size_t exp1 = 1;
 	static const size_t exp2 = 2;
@@ -85,13 +213,15 @@ public:
 	static const size_t exp5 = 5;
 	static const size_t exp6 = 6;
 	static const size_t exp7 = 7;
+	static const size_t calculateCoreSpeed = 8;
 	static const size_t senders = 1;
-	static const size_t isMaster = 1;
-	static const size_t isSlave = 0;
+	static const uint32_t masterNode = 0; /**< The node number of the Master. */
 	static const size_t isFinished = 1;
 	static const size_t isStarted = 0;
 	static const size_t isRun = 2;
 	static const uint32_t rawSingleLoad = 30; /**< The number of KWI executed in each raw_speed calculation iteration. */
+	static const uint32_t rawProbeTime = 500; /**< Duration in ms of the probe that validates a cached raw speed. */
+	static const uint32_t rawTolerance = 5; /**< Maximum difference in percentage between the probe and the cached raw speed. */
 	static const uint16_t baselineNumberExpUni = 5;
 	static const uint16_t baselineNumberExpDist = 3;
 	static const uint32_t baselineMessageSizeExpDist = sizeof(size_t); /**< Minimal message length. */
@@ -100,6 +230,7 @@ public:
 	static const uint8_t manTaskPriority = 50; /**< The priority of management task */
 	static const uint64_t testPeriod	= 10000000000; /**< Duration of each test. The expressed unity is implementation dependent. (in ns. 10 seconds.) */
 	static const uint32_t taskManStackSize = 1200; /**< Management Task Stack Depth. */
+	static const uint16_t stepResolution = 100; /**< The experiment steps are sent to the Slave in hundredths. */
 	worstCaseScenario_t worstScenario;
 
 #define rstoneEXP5_UPDATE_VALUE(test) pow(2,test+1)
@@ -107,33 +238,84 @@ public:
 
 protected:
 	LocalHeap rstoneHeap;
-	LocalHeap initTimeHeap;
 	size_t actualDeadlineMiss;
 	Subscriber *subMan; /**< Subscriber handler for management tasks inter-communication */
 	Publisher *pubMan;  /**< Publisher handler for management tasks inter-communication */
+	uint32_t localNode; /**< The number of this node, Robotstone::masterNode or a Slave. */
+	size_t peersNumber; /**< The Slaves in the Master, or 1 (the Master) in a Slave. */
+	size_t slavesNumber; /**< The number of Slaves in the experiment. */
+	manPeer_t peers[robotMAX_SLAVES]; /**< The protocol state with each Slave in the Master, or with the Master in a Slave. */
+	uint32_t pingNumber; /**< Number of the last Robotstone::cmdPing sent. */
+	size_t pingPeer; /**< The node where the last Robotstone::cmdPing was sent. */
+	timeCount_t pingTime; /**< When the last Robotstone::cmdPing was sent. */
+	bool hasPong; /**< Indicates that the last Robotstone::cmdPing was answered. */
 	List<RobotTask, size_t> rstoneTasks;
-	uint64_t rawSpeed;	/**< The actual processor raw speed in KWIPS */
+	List<RobotTask, size_t> spareTasks; /**< Tasks added by a previous step and parked out of the test steps. */
+	uint64_t rawSpeed;	/**< The actual processor raw speed in work units per second (KWIPS for Whetstone) */
+	Workload *rawWorkload; /**< The workload used to measure the raw speed. */
 	timeCount_t rawInterval;	/**< The measurement interval of KWI executed by processor */
-	Signal startTasksSig;
+	ReleaseBarrier startBarrier; /**< Releases the synthetic tasks in each test step. */
 	size_t actualExp;
 	size_t experimentReachLimit;
 	uint8_t *stopCondTask;
-	RealTime::timeCount_t *initialTime;
 	size_t distBaselineWorkload[3];
+	Tracer tracer; /**< Saves the activation records of the synthetic tasks. */
+	nodeResults_t *results; /**< The results of the node tasks in the last test step. */
 
 
 public:
-	Robotstone(void);
+	Robotstone(uint32_t node);
+
+	void SendCommand(uint16_t command, uint32_t argument);
+
+	void SendCommandTo(size_t peer, uint16_t command, uint32_t argument);
+
+	int TrySendCommand(uint16_t command, uint32_t argument, timeCount_t timeout);
+
+	uint32_t WaitCommand(uint16_t command, timeCount_t timeout = Robotstone::commandTimeout);
 
-	void HandshakeSend(uint16_t *message);
+	uint32_t WaitCommandFrom(size_t peer, uint16_t command, timeCount_t timeout = Robotstone::commandTimeout);
 
-	void HandshakeReceive(uint16_t *message);
+	uint32_t Barrier(uint16_t command, uint32_t argument);
+
+	void SetSlaves(size_t slaves);
+
+	size_t GetSlaves(void);
+
+	void WaitTasksReady(void);
+
+	void SyncClock(void);
+
+	void ReleaseTasks(void);
 
 	void CalculeRawSpeed(void);
 
+	void LoadRawSpeed(void);
+
+	void CalculeCoreSpeeds(void);
+
 	uint64_t GetRawSpeed(void);
 
-	void GetWorstCase(size_t test);
+	void GetWorstCase(const nodeResults_t *nodeResults);
+
+	static uint32_t EncodeStep(double step);
+
+	static double DecodeStep(uint32_t message);
+
+protected:
+	int SendToPeers(size_t first, size_t last, uint16_t command, uint32_t argument, timeCount_t timeout);
+	void ReceiveCommand(timeCount_t timeout);
+	size_t GetPeer(const manMessage_t *msg);
+	uint32_t GetPeerNode(size_t peer);
+	void PingPeer(size_t peer);
+	Workload* CreateWorkload(void);
+	void CollectResults(size_t test);
+	void PrintRawSpeed(void);
+	void PrintPartitions(void);
+	void PrintDelivery(void);
+	void PrintClockSync(void);
+	void PrintPercentiles(void);
+	void PrintTraceStatus(void);
 };
 
 
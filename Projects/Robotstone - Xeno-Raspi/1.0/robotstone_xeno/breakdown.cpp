@@ -0,0 +1,180 @@
+/**
+ * @file	breakdown.cpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the search of the breakdown point of an experiment,
+ * i.e. the smallest experiment step where the task set misses deadlines.
+ * Instead of increasing the step one by one, the search brackets the first
+ * failing step and bisects the bracket, so the breakdown point is found with
+ * a given precision in a few test steps.
+ */
+
+#include "breakdown.hpp"
+#include <math.h>
+
+/*CLASS METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief BreakdownSearch class constructor.
+ */
+BreakdownSearch::BreakdownSearch(void):
+		low(0), high(0), first(0), limit(0), precision(0),
+		discrete(false), bracketed(false), testsNumber(0)
+{
+
+}
+
+/**
+ * @brief Begin a new search. The baseline test step, which must have no
+ * 		  deadlines missed, is given to BreakdownSearch::Next like the others.
+ *
+ * @param baseline - The step equivalent to the baseline task set.
+ * @param first - The first step tested after the baseline.
+ * @param limit - The biggest step possible in the experiment.
+ * @param precision - The bracket width where the search stops.
+ * @param discrete - If true, only integer steps are tested.
+ */
+void BreakdownSearch::Start(double baseline, double first, double limit, double precision, bool discrete)
+{
+	this->low = baseline;
+	this->high = limit;
+	this->first = first;
+	this->limit = limit;
+	this->precision = (discrete && (precision < 1))? 1 : precision;
+	this->discrete = discrete;
+	this->bracketed = false;
+	this->testsNumber = 0;
+}
+
+/**
+ * @brief Update the bracket with the result of a test step and
+ * 		  choose the next step.
+ *
+ * @param step - The step tested.
+ * @param missed - Indicates that the step has deadlines missed.
+ * @param next - Where the next step is saved.
+ *
+ * @return - true if the next step must be tested;
+ * 		   - false if the search finished.
+ */
+bool BreakdownSearch::Next(double step, bool missed, double *next)
+{
+	this->testsNumber++;
+
+	if(missed)
+	{
+		this->high = step;
+		this->bracketed = true;
+	}
+	else if(step > this->low)
+	{
+		this->low = step;
+	}
+
+	if(!this->bracketed)
+	{
+		// No step has missed deadlines yet: grow geometrically.
+		if(this->low >= this->limit)
+		{
+			return false;
+		}
+
+		*next = (this->low < this->first)? this->first : this->low*2;
+
+		if(*next > this->limit)
+		{
+			*next = this->limit;
+		}
+		return true;
+	}
+
+	if((this->high - this->low) <= this->precision)
+	{
+		return false;
+	}
+
+	*next = (this->low + this->high)/2;
+
+	if(this->discrete)
+	{
+		*next = floor(*next);
+
+		if(*next <= this->low)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Indicates if the breakdown point was found, i.e. a step missed deadlines.
+ *
+ * @return true if a step missed deadlines and false otherwise.
+ */
+bool BreakdownSearch::IsBracketed(void)
+{
+	return this->bracketed;
+}
+
+/**
+ * @brief Get the biggest step tested without deadlines missed.
+ *
+ * @return The step.
+ */
+double BreakdownSearch::GetLastPassed(void)
+{
+	return this->low;
+}
+
+/**
+ * @brief Get the smallest step tested with deadlines missed.
+ *
+ * @return The step, valid only if BreakdownSearch::IsBracketed.
+ */
+double BreakdownSearch::GetFirstMissed(void)
+{
+	return this->high;
+}
+
+/**
+ * @brief Get the bracket width where the search stops.
+ *
+ * @return The precision in steps.
+ */
+double BreakdownSearch::GetPrecision(void)
+{
+	return this->precision;
+}
+
+/**
+ * @brief Get the number of test steps executed in the search, including the baseline.
+ *
+ * @return The number of test steps.
+ */
+uint32_t BreakdownSearch::GetTestsNumber(void)
+{
+	return this->testsNumber;
+}
+
+/***************************************************************************************
+ * END: Module - breakdown.cpp
+ ***************************************************************************************/
@@ -0,0 +1,72 @@
+/**
+ * @file	breakdown.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the search of the breakdown point of an experiment,
+ * i.e. the smallest experiment step where the task set misses deadlines.
+ * Instead of increasing the step one by one, the search brackets the first
+ * failing step and bisects the bracket, so the breakdown point is found with
+ * a given precision in a few test steps.
+ */
+
+#ifndef BREAKDOWN_MACRO_HPP
+#define BREAKDOWN_MACRO_HPP
+
+/*MODULE INCLUDES*/
+/*=======================================================================================*/
+#include <stdint.h>
+#include <stddef.h>
+
+/*CLASSES*/
+/*=======================================================================================*/
+
+/**
+ * @brief Chooses the next experiment step from the result of the last one.
+ *
+ * 		  The steps are doubled until one misses deadlines (the bracket),
+ * 		  then the middle of the bracket is tested until its width reaches
+ * 		  the precision. In discrete experiments (e.g. number of tasks) only
+ * 		  integer steps are tested.
+ */
+class BreakdownSearch
+{
+private:
+	double low; /**< The last step without deadlines missed. */
+	double high; /**< The first step with deadlines missed, if bracketed. */
+	double first; /**< The first step after the baseline. */
+	double limit; /**< The biggest step possible in the experiment. */
+	double precision; /**< The bracket width where the search stops. */
+	bool discrete;
+	bool bracketed; /**< Indicates that a step has missed deadlines. */
+	uint32_t testsNumber;
+public:
+	BreakdownSearch(void);
+	void Start(double baseline, double first, double limit, double precision, bool discrete);
+	bool Next(double step, bool missed, double *next);
+	bool IsBracketed(void);
+	double GetLastPassed(void);
+	double GetFirstMissed(void);
+	double GetPrecision(void);
+	uint32_t GetTestsNumber(void);
+};
+
+#endif // BREAKDOWN_MACRO_HPP
+/***************************************************************************************
+ * END: Module - breakdown.hpp
+ ***************************************************************************************/
@@ -0,0 +1,467 @@
+/**
+ * @file	calibration.cpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the cache of raw speed calibrations. The raw speed
+ * measured in a machine is saved in a text file, keyed by everything that
+ * changes it (processor, frequency governor, compiler, build flags and
+ * workload), so the next executions don't need to measure it again.
+ * It also contains the per-core calibration, that measures the raw speed
+ * of each processor alone and with all the processors busy.
+ */
+
+#include "calibration.hpp"
+#include "rtconfig.hpp"
+#include "realtime.hpp"
+#include "stdout.hpp"
+#include "rtheap.hpp"
+#include <iostream> //for use of new(pointer)
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*MACROS*/
+/*=======================================================================================*/
+
+#define calibLINE_SIZE (CalibrationCache::maxKeySize + 32)
+
+/*
+ * The flags that change the generated code. The exact command line isn't
+ * visible to the code, so it is approximated by the predefined macros.
+ * The build may give its own string by defining calibBUILD_FLAGS.
+ */
+#ifndef calibBUILD_FLAGS
+
+#if defined(__OPTIMIZE_SIZE__)
+#define calibOPTIMIZE "Os"
+#elif defined(__OPTIMIZE__)
+#define calibOPTIMIZE "O"
+#else
+#define calibOPTIMIZE "O0"
+#endif
+
+#ifdef __FAST_MATH__
+#define calibFAST_MATH " fast-math"
+#else
+#define calibFAST_MATH ""
+#endif
+
+#if defined(__ARM_NEON__)
+#define calibFPU " neon"
+#elif defined(__VFP_FP__) && !defined(__SOFTFP__)
+#define calibFPU " vfp"
+#else
+#define calibFPU ""
+#endif
+
+#ifdef RT_POSIX
+#define calibBACKEND " posix"
+#else
+#define calibBACKEND " xenomai"
+#endif
+
+#define calibBUILD_FLAGS calibOPTIMIZE calibFAST_MATH calibFPU calibBACKEND
+
+#endif
+
+/**
+ * @brief The Student's t value of the 95% confidence interval, for
+ * 		  CoreCalibrator::samplesNumber - 1 = 9 degrees of freedom.
+ */
+static const double studentT95 = 2.262;
+
+taskFUNCTION(CoreCalibCode, arg);
+
+/*CALIBRATION CACHE METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief CalibrationCache class constructor.
+ *
+ * @param fileName - The cache file path. It is created by the first
+ * 					 CalibrationCache::Store.
+ */
+CalibrationCache::CalibrationCache(const char *fileName):
+		fileName(fileName)
+{
+
+}
+
+/**
+ * @brief Search a calibration in the cache file.
+ *
+ * @param key - The key made by CalibrationCache::BuildKey.
+ * @param rawSpeed - Receives the saved raw speed.
+ *
+ * @return true - if the key was found;
+ * 		   false - otherwise.
+ */
+bool CalibrationCache::Find(const char *key, uint64_t *rawSpeed)
+{
+	char line[calibLINE_SIZE];
+	size_t keyLength = strlen(key);
+	bool found = false;
+	FILE *file = fopen(this->fileName, "r");
+
+	if(file == NULL)
+	{
+		return false;
+	}
+
+	while(fgets(line, sizeof(line), file) != NULL)
+	{
+		if((strncmp(line, key, keyLength) == 0) && (line[keyLength] == '\t'))
+		{
+			*rawSpeed = strtoull(line + keyLength + 1, NULL, 10);
+			found = (*rawSpeed != 0);
+			break;
+		}
+	}
+
+	fclose(file);
+
+	return found;
+}
+
+/**
+ * @brief Save a calibration in the cache file, replacing the one with the same key.
+ *
+ * 		  The file is rewritten in a temporary file and renamed,
+ * 		  so an interrupted execution doesn't corrupt it.
+ *
+ * @param key - The key made by CalibrationCache::BuildKey.
+ * @param rawSpeed - The measured raw speed.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int CalibrationCache::Store(const char *key, uint64_t rawSpeed)
+{
+	char line[calibLINE_SIZE];
+	char tempName[calibLINE_SIZE];
+	size_t keyLength = strlen(key);
+	size_t entries = 1;
+	FILE *file, *temp;
+
+	snprintf(tempName, sizeof(tempName), "%s.tmp", this->fileName);
+
+	temp = fopen(tempName, "w");
+	if(temp == NULL)
+	{
+		RealTime::Stdout::Print("Impossible write the calibration cache %s.\n", this->fileName);
+		return RealTime::fail;
+	}
+
+	fprintf(temp, "%s\t%llu\n", key, (unsigned long long)rawSpeed);
+
+	// Keep the other calibrations, e.g. of other workloads.
+	file = fopen(this->fileName, "r");
+	if(file != NULL)
+	{
+		while((fgets(line, sizeof(line), file) != NULL) && (entries < CalibrationCache::maxEntries))
+		{
+			if((strncmp(line, key, keyLength) == 0) && (line[keyLength] == '\t'))
+			{
+				continue;
+			}
+			if(strchr(line, '\t') != NULL)
+			{
+				fputs(line, temp);
+				entries++;
+			}
+		}
+		fclose(file);
+	}
+
+	if((fclose(temp) != 0) || (rename(tempName, this->fileName) != 0))
+	{
+		RealTime::Stdout::Print("Impossible write the calibration cache %s.\n", this->fileName);
+		remove(tempName);
+		return RealTime::fail;
+	}
+
+	return RealTime::ok;
+}
+
+/**
+ * @brief Make the key of a calibration in the running machine.
+ *
+ * @param key - Receives the key.
+ * @param size - The key buffer size.
+ * @param workload - The workload used in the calibration.
+ * @param workingSet - The workload working set in bytes.
+ */
+void CalibrationCache::BuildKey(char *key, size_t size, Workload *workload, size_t workingSet)
+{
+	char model[128], hardware[128], governor[64], maxFreq[32];
+
+	CalibrationCache::ReadField("/proc/cpuinfo", "model name", model, sizeof(model));
+	// The ARM kernels show the board in these fields.
+	if(model[0] == '\0')
+	{
+		CalibrationCache::ReadField("/proc/cpuinfo", "Model", model, sizeof(model));
+	}
+	CalibrationCache::ReadField("/proc/cpuinfo", "Hardware", hardware, sizeof(hardware));
+	CalibrationCache::ReadField("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor", NULL, governor, sizeof(governor));
+	CalibrationCache::ReadField("/sys/devices/system/cpu/cpu0/cpufreq/scaling_max_freq", NULL, maxFreq, sizeof(maxFreq));
+
+	snprintf(key, size, "cpu=%s %s;governor=%s %s;compiler=%s;flags=%s;workload=%s %lu",
+			 model, hardware, governor, maxFreq, __VERSION__, calibBUILD_FLAGS,
+			 workload->GetName(), (unsigned long)workingSet);
+
+	// The tab and the new line separate the fields of the file.
+	for(char *c = key; *c != '\0'; ++c)
+	{
+		if((*c == '\t') || (*c == '\n'))
+		{
+			*c = ' ';
+		}
+	}
+}
+
+/**
+ * @brief Read a value from a system file.
+ *
+ * @param path - The file path.
+ * @param field - The name before the ':' in the line of the value, or
+ * 				  NULL to read the first line of the file.
+ * @param value - Receives the value without the surrounding spaces,
+ * 				  or an empty string if it isn't found.
+ * @param size - The value buffer size.
+ */
+void CalibrationCache::ReadField(const char *path, const char *field, char *value, size_t size)
+{
+	char line[256];
+	char *begin, *end;
+	FILE *file = fopen(path, "r");
+
+	value[0] = '\0';
+
+	if(file == NULL)
+	{
+		return;
+	}
+
+	while(fgets(line, sizeof(line), file) != NULL)
+	{
+		begin = line;
+
+		if(field != NULL)
+		{
+			if((strncmp(line, field, strlen(field)) != 0) || ((begin = strchr(line, ':')) == NULL))
+			{
+				continue;
+			}
+			begin++;
+		}
+
+		while((*begin == ' ') || (*begin == '\t'))
+		{
+			begin++;
+		}
+		end = begin + strlen(begin);
+		while((end > begin) && ((end[-1] == '\n') || (end[-1] == ' ') || (end[-1] == '\t')))
+		{
+			end--;
+		}
+		*end = '\0';
+
+		strncpy(value, begin, size - 1);
+		value[size - 1] = '\0';
+		break;
+	}
+
+	fclose(file);
+}
+
+/*CORE CALIBRATOR METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief CoreCalibrator class constructor.
+ *
+ * 		  The tasks and workloads of all the processors are created here.
+ *
+ * @param kind - The workload kind, as in Workload::Create.
+ * @param workingSet - The working set of the memory workloads.
+ * @param batch - The number of work units executed in each measurement iteration.
+ */
+CoreCalibrator::CoreCalibrator(size_t kind, size_t workingSet, uint32_t batch):
+		batch(batch)
+{
+	void *p;
+
+	this->coresNumber = RealTime::GetCPUsNumber();
+	if(this->coresNumber > CoreCalibrator::maxCores)
+	{
+		this->coresNumber = CoreCalibrator::maxCores;
+	}
+
+	for(size_t i = 0; i < this->coresNumber; ++i)
+	{
+		this->jobs[i].calibrator = this;
+		this->jobs[i].workload = Workload::Create(kind, workingSet);
+		this->jobs[i].result = NULL;
+		this->jobs[i].cpu = i;
+
+		p = RealTime::Heap::Alloc(sizeof(RealTime::Task));
+		if(p == NULL)
+		{
+			RealTime::Stdout::Print("Impossible allocate the calibration tasks.\n");
+			exit(1);
+		}
+		this->tasks[i] = new(p) RealTime::Task(CoreCalibCode, CoreCalibrator::taskPriority, CoreCalibrator::taskStackSize, (void*)&this->jobs[i], i + 1, "");
+		this->tasks[i]->SetAffinity(i);
+	}
+}
+
+/**
+ * @brief Measure the speed of each processor alone and then
+ * 		  of all the processors running at the same time.
+ */
+void CoreCalibrator::Run(void)
+{
+	for(size_t i = 0; i < this->coresNumber; ++i)
+	{
+		this->jobs[i].result = &this->alone[i];
+		this->tasks[i]->Start();
+		this->tasks[i]->Join();
+	}
+
+	for(size_t i = 0; i < this->coresNumber; ++i)
+	{
+		this->jobs[i].result = &this->busy[i];
+		this->tasks[i]->Start();
+	}
+	for(size_t i = 0; i < this->coresNumber; ++i)
+	{
+		this->tasks[i]->Join();
+	}
+}
+
+/**
+ * @brief Get the number of measured processors.
+ *
+ * @return The number of processors.
+ */
+size_t CoreCalibrator::GetCoresNumber(void)
+{
+	return this->coresNumber;
+}
+
+/**
+ * @brief Get the speed of a processor running alone.
+ *
+ * @param cpu - The processor number.
+ *
+ * @return The speed in work units per second.
+ */
+speedEstimate_t CoreCalibrator::GetAloneSpeed(size_t cpu)
+{
+	return this->alone[cpu];
+}
+
+/**
+ * @brief Get the speed of a processor while all the processors are busy.
+ *
+ * @param cpu - The processor number.
+ *
+ * @return The speed in work units per second.
+ */
+speedEstimate_t CoreCalibrator::GetBusySpeed(size_t cpu)
+{
+	return this->busy[cpu];
+}
+
+/**
+ * @brief Get how many times a processor is slower when all the processors are busy.
+ *
+ * @param cpu - The processor number.
+ *
+ * @return The ratio between the speed alone and the speed with all processors busy.
+ */
+double CoreCalibrator::GetSlowdown(size_t cpu)
+{
+	if(this->busy[cpu].mean == 0)
+	{
+		return 0;
+	}
+	return this->alone[cpu].mean/this->busy[cpu].mean;
+}
+
+/**
+ * @brief Get the name of the work unit of the measured workload.
+ *
+ * @return The work unit name.
+ */
+const char* CoreCalibrator::GetUnitName(void)
+{
+	return this->jobs[0].workload->GetUnitName();
+}
+
+/**
+ * @brief Take the speed samples of a processor and estimate its mean.
+ *
+ * @param job - The processor job, which receives the estimate.
+ */
+void CoreCalibrator::Measure(coreJob_t *job)
+{
+	RealTime::timeCount_t interval = (CoreCalibrator::sampleTime*RealTime::Timer::GetPeriod())/1000;
+	double samples[CoreCalibrator::samplesNumber];
+	double sum = 0, squares = 0, deviation;
+
+	for(uint32_t i = 0; i < CoreCalibrator::warmUpSamples; ++i)
+	{
+		job->workload->Calibrate(interval, this->batch);
+	}
+
+	for(uint32_t i = 0; i < CoreCalibrator::samplesNumber; ++i)
+	{
+		samples[i] = (double)job->workload->Calibrate(interval, this->batch);
+		sum += samples[i];
+	}
+
+	job->result->mean = sum/CoreCalibrator::samplesNumber;
+
+	for(uint32_t i = 0; i < CoreCalibrator::samplesNumber; ++i)
+	{
+		squares += (samples[i] - job->result->mean)*(samples[i] - job->result->mean);
+	}
+	deviation = sqrt(squares/(CoreCalibrator::samplesNumber - 1));
+
+	job->result->confidence = studentT95*deviation/sqrt((double)CoreCalibrator::samplesNumber);
+}
+
+/**
+ * @brief The code executed by the calibration task of each processor.
+ *
+ * @arg - The coreJob_t of the processor.
+ *
+ */
+taskFUNCTION(CoreCalibCode, arg)
+{
+	coreJob_t *job = (coreJob_t *)arg;
+
+	job->calibrator->Measure(job);
+}
+
+/***************************************************************************************
+ * END: Module - calibration.cpp
+ ***************************************************************************************/
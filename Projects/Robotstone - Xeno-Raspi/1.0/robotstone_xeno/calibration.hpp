@@ -0,0 +1,133 @@
+/**
+ * @file	calibration.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the cache of raw speed calibrations. The raw speed
+ * measured in a machine is saved in a text file, keyed by everything that
+ * changes it (processor, frequency governor, compiler, build flags and
+ * workload), so the next executions don't need to measure it again.
+ * It also contains the per-core calibration, that measures the raw speed
+ * of each processor alone and with all the processors busy.
+ */
+
+#ifndef CALIBRATION_MACRO_HPP
+#define CALIBRATION_MACRO_HPP
+
+/*MODULE INCLUDES*/
+/*=======================================================================================*/
+#include <stdint.h>
+#include <stddef.h>
+#include "workload.hpp"
+#include "task.hpp"
+
+/*MODULE TYPES*/
+/*=======================================================================================*/
+
+/**
+ * @brief A speed measured by repeated samples.
+ */
+typedef struct
+{
+	double mean; /**< The samples average in work units per second. */
+	double confidence; /**< Half width of the 95% confidence interval of the mean. */
+}speedEstimate_t;
+
+class CoreCalibrator;
+
+/**
+ * @brief The parameters of the calibration task of a processor.
+ */
+typedef struct
+{
+	CoreCalibrator *calibrator;
+	Workload *workload; /**< Each processor has its own, because of the memory workloads. */
+	speedEstimate_t *result; /**< Where the task saves the measured speed. */
+	size_t cpu;
+}coreJob_t;
+
+/*CLASSES*/
+/*=======================================================================================*/
+
+/**
+ * @brief A text file with one "key<TAB>raw speed" line per calibration.
+ *
+ * 		  The file is read and written only out of the test steps.
+ */
+class CalibrationCache
+{
+public:
+	static const size_t maxKeySize = 512;
+	static const size_t maxEntries = 64;
+private:
+	const char *fileName;
+public:
+	CalibrationCache(const char *fileName);
+	bool Find(const char *key, uint64_t *rawSpeed);
+	int Store(const char *key, uint64_t rawSpeed);
+
+	static void BuildKey(char *key, size_t size, Workload *workload, size_t workingSet);
+
+private:
+	static void ReadField(const char *path, const char *field, char *value, size_t size);
+};
+
+/**
+ * @brief Measures the raw speed of each processor with a task pinned on it,
+ * 		  first one processor at a time and then all the processors together.
+ *
+ * 		  The first samples of each task are discarded as warm-up (caches,
+ * 		  branch predictors and frequency scaling), and the others give the
+ * 		  mean speed and its confidence interval. The ratio between the speed
+ * 		  alone and with all processors busy shows the effect of the shared
+ * 		  caches, memory bus and temperature.
+ */
+class CoreCalibrator
+{
+public:
+	static const size_t maxCores = 16;
+	static const uint32_t warmUpSamples = 2;
+	static const uint32_t samplesNumber = 10; /**< Samples kept after the warm-up. */
+	static const uint32_t sampleTime = 1000; /**< Duration of each sample in ms. */
+	static const uint8_t taskPriority = 49; /**< Below the management tasks. */
+	static const uint32_t taskStackSize = 1200;
+private:
+	RealTime::Task *tasks[maxCores];
+	coreJob_t jobs[maxCores];
+	speedEstimate_t alone[maxCores];
+	speedEstimate_t busy[maxCores];
+	size_t coresNumber;
+	uint32_t batch;
+public:
+	CoreCalibrator(size_t kind, size_t workingSet, uint32_t batch);
+	void Run(void);
+	size_t GetCoresNumber(void);
+	speedEstimate_t GetAloneSpeed(size_t cpu);
+	speedEstimate_t GetBusySpeed(size_t cpu);
+	double GetSlowdown(size_t cpu);
+	const char* GetUnitName(void);
+
+private:
+	friend taskFUNCTION(CoreCalibCode, arg);
+	void Measure(coreJob_t *job);
+};
+
+#endif // CALIBRATION_MACRO_HPP
+/***************************************************************************************
+ * END: Module - calibration.hpp
+ ***************************************************************************************/
@@ -0,0 +1,489 @@
+/**
+ * @file	commbench.cpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the micro-benchmark of the Communic subsystem alone,
+ * without the synthetic workload of the experiments. Publisher tasks send
+ * messages to subscriber tasks of one topic in the same executable, while
+ * the message size, the publishing rate and the number of publishers and
+ * subscribers are swept. Each run is written as a line of a CSV file, so
+ * the results of different builds and backends can be compared.
+ */
+
+#include "commbench.hpp"
+#include <string.h>
+#include <time.h>
+#include <new>
+
+/*MACROS*/
+/*=======================================================================================*/
+
+#ifdef RT_POSIX
+#define benchBACKEND "posix"
+#else
+#define benchBACKEND "xenomai"
+#endif
+
+#define benchTASK_ID 3000 /**< The identifier of the first benchmark task. */
+
+using namespace RealTime;
+
+taskFUNCTION(BenchPubCode, arg);
+taskFUNCTION(BenchSubCode, arg);
+
+/*FUNCTIONS*/
+/*=======================================================================================*/
+
+/**
+ * @brief Get the name of a delivery mode, as written in the results.
+ *
+ * @param delivery - Communic::gatekeeper or Communic::direct.
+ *
+ * @return The delivery name.
+ */
+static const char *GetDeliveryName(int delivery)
+{
+	return (delivery == Communic::direct)? "direct" : "gatekeeper";
+}
+
+/*CLASS METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief CommBench class constructor.
+ *
+ * 		  The message header is enabled here, before any topic
+ * 		  is created, since the latency is measured with it.
+ *
+ * @param fileName - The CSV file where the results are written.
+ */
+CommBench::CommBench(const char *fileName):
+		startTime(0), endTime(0), rate(0), stop(false),
+		nextTopic(CommBench::firstTopic), fileName(fileName), file(NULL)
+{
+	Communic::SetMessageHeader(true);
+}
+
+/**
+ * @brief Run all the sweeps in each delivery mode and write the results.
+ *
+ * 		  The messages sizes grow four times in each run, from 8 bytes to
+ * 		  4 MiB, published back to back. The rates go from 100 Hz to back
+ * 		  to back. The publishers and subscribers sweeps use the baseline
+ * 		  rate, so their latency is not hidden by full queues.
+ */
+void CommBench::Run(void)
+{
+	static const uint32_t rates[] = {100, 1000, 10000, 100000, 0};
+	static const int deliveries[] = {Communic::gatekeeper, Communic::direct};
+	benchCase_t test;
+
+	this->file = fopen(this->fileName, "w");
+	if(this->file == NULL)
+	{
+		Stdout::Print("Impossible create the results file %s.\n", this->fileName);
+		return;
+	}
+
+	fprintf(this->file, "backend,delivery,size_bytes,rate_hz,publishers,subscribers,duration_s,"
+						"published,send_failed,received,dropped,overwritten,lost,exhausted,"
+						"msgs_per_s,bytes_per_s,lat_avg_s,lat_p50_s,lat_p99_s,lat_p999_s,lat_max_s,"
+						"cpu_s_per_msg,allocs\n");
+
+	Stdout::Print("\nCommunic micro-benchmark (%s), results in %s\n", benchBACKEND, this->fileName);
+	Stdout::Print("Delivery\tSize (B)\tRate (Hz)\tPubs\tSubs\tMsgs/s\t\tp99 (s)\t\tCPU/msg (s)\tAllocs\n");
+
+	for(size_t d = 0; d < sizeof(deliveries)/sizeof(deliveries[0]); ++d)
+	{
+		test.delivery = deliveries[d];
+		test.rate = 0;
+		test.publishers = 1;
+		test.subscribers = 1;
+
+		for(test.size = CommBench::minSize; ; test.size *= 4)
+		{
+			if(test.size > CommBench::maxSize)
+			{
+				test.size = CommBench::maxSize;
+			}
+			this->RunCase(&test);
+
+			if(test.size == CommBench::maxSize)
+			{
+				break;
+			}
+		}
+
+		test.size = CommBench::baselineSize;
+		for(size_t i = 0; i < sizeof(rates)/sizeof(rates[0]); ++i)
+		{
+			test.rate = rates[i];
+			this->RunCase(&test);
+		}
+
+		test.rate = CommBench::baselineRate;
+		for(test.publishers = 1; test.publishers <= CommBench::maxPublishers; test.publishers *= 2)
+		{
+			this->RunCase(&test);
+		}
+
+		test.publishers = 1;
+		for(test.subscribers = 1; test.subscribers <= CommBench::maxSubscribers; test.subscribers *= 2)
+		{
+			this->RunCase(&test);
+		}
+	}
+
+	fclose(this->file);
+	this->file = NULL;
+	Stdout::Print("\nMicro-benchmark finished!!!\n");
+}
+
+/**
+ * @brief Execute one run and write its results.
+ *
+ * 		  The processor time and the allocations are counted from the
+ * 		  start of the tasks to the end of the subscribers, so they don't
+ * 		  include the creation and the deletion of the topic.
+ *
+ * @param test - The run parameters.
+ */
+void CommBench::RunCase(const benchCase_t *test)
+{
+	timeCount_t period = Timer::GetPeriod();
+	size_t topic = this->nextTopic++;
+	uint32_t published = 0, failed = 0, received = 0;
+	uint32_t dropped = 0, overwritten = 0, lost = 0, exhausted = 0;
+	uint32_t allocs, pending;
+	timeCount_t latencySum = 0;
+	double cpuTime, duration, average;
+	Topic *topicHandler;
+
+	if((topic >= Communic::maxTopics) || (this->Setup(test, topic) != RealTime::ok))
+	{
+		Stdout::Print("%s\t%d\t\t%d\t\t%d\t%d\tskipped: impossible create the topic\n",
+						GetDeliveryName(test->delivery), test->size, test->rate,
+						test->publishers, test->subscribers);
+		this->Teardown(test);
+		return;
+	}
+
+	this->rate = test->rate;
+	this->stop = false;
+
+	// The tasks wait the same start time, so all of them are ready.
+	this->startTime = Timer::GetTime() + period/100;
+	this->endTime = this->startTime + (CommBench::runTime*period)/1000;
+
+	allocs = Heap::GetAllocNumber();
+	cpuTime = CommBench::GetProcessTime();
+
+	for(uint32_t i = 0; i < test->subscribers; ++i)
+	{
+		this->subJobs[i].task->Start();
+	}
+	for(uint32_t i = 0; i < test->publishers; ++i)
+	{
+		this->pubJobs[i].task->Start();
+	}
+	for(uint32_t i = 0; i < test->publishers; ++i)
+	{
+		this->pubJobs[i].task->Join();
+	}
+
+	Task::Delay((CommBench::drainTime*period)/1000);
+	this->stop = true;
+
+	// A subscriber may be between two waits when it is unblocked.
+	do
+	{
+		pending = 0;
+		for(uint32_t i = 0; i < test->subscribers; ++i)
+		{
+			if(!this->subJobs[i].done)
+			{
+				this->subJobs[i].task->Unblock();
+				pending++;
+			}
+		}
+		if(pending != 0)
+		{
+			Task::Delay(period/1000);
+		}
+	}while(pending != 0);
+
+	for(uint32_t i = 0; i < test->subscribers; ++i)
+	{
+		this->subJobs[i].task->Join();
+	}
+
+	cpuTime = CommBench::GetProcessTime() - cpuTime;
+	allocs = Heap::GetAllocNumber() - allocs;
+
+	for(uint32_t i = 0; i < test->publishers; ++i)
+	{
+		published += this->pubJobs[i].count;
+		failed += this->pubJobs[i].failed;
+	}
+
+	this->latency.Clear();
+	for(uint32_t i = 0; i < test->subscribers; ++i)
+	{
+		messageStats_t *stats = this->subJobs[i].sub->GetStats();
+
+		received += this->subJobs[i].count;
+		dropped += stats->dropped;
+		overwritten += stats->overwritten;
+		lost += stats->lost;
+		latencySum += stats->latencySum;
+		this->latency.Add(stats->latency);
+	}
+
+	topicHandler = Communic::GetTopicHandler(topic);
+	if(topicHandler != NULL)
+	{
+		exhausted = topicHandler->GetExhaustedNumber();
+	}
+
+	duration = ((double)(this->endTime - this->startTime))/period;
+	average = (this->latency.GetTotalCount() == 0)? 0 : ((double)latencySum/period)/this->latency.GetTotalCount();
+
+	fprintf(this->file, "%s,%s,%u,%u,%u,%u,%f,%u,%u,%u,%u,%u,%u,%u,%f,%f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%u\n",
+			benchBACKEND, GetDeliveryName(test->delivery), test->size, test->rate,
+			test->publishers, test->subscribers, duration,
+			published, failed, received, dropped, overwritten, lost, exhausted,
+			received/duration, ((double)received*test->size)/duration,
+			average,
+			(double)this->latency.GetPercentile(50)/period,
+			(double)this->latency.GetPercentile(99)/period,
+			(double)this->latency.GetPercentile(99.9)/period,
+			(double)this->latency.GetPercentile(100)/period,
+			(received == 0)? 0 : cpuTime/received,
+			allocs);
+	fflush(this->file);
+
+	Stdout::Print("%s\t%d\t\t%d\t\t%d\t%d\t%f\t%f\t%f\t%d\n",
+					GetDeliveryName(test->delivery), test->size, test->rate,
+					test->publishers, test->subscribers, received/duration,
+					(double)this->latency.GetPercentile(99)/period,
+					(received == 0)? 0 : cpuTime/received, allocs);
+
+	this->Teardown(test);
+}
+
+/**
+ * @brief Create the tasks, the links to the topic and the messages of a run.
+ *
+ * 		  The subscribers are created before the publishers,
+ * 		  so they receive the first message.
+ *
+ * @param test - The run parameters.
+ * @param topic - The topic of the run.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise, with the created objects
+ * 		     to be deleted by CommBench::Teardown.
+ */
+int CommBench::Setup(const benchCase_t *test, size_t topic)
+{
+	void *p;
+
+	memset(this->subJobs, 0, test->subscribers*sizeof(benchJob_t));
+	memset(this->pubJobs, 0, test->publishers*sizeof(benchJob_t));
+
+	if(Communic::SetDelivery(topic, test->delivery) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+
+	for(uint32_t i = 0; i < test->subscribers; ++i)
+	{
+		benchJob_t *job = &this->subJobs[i];
+
+		job->bench = this;
+		job->sub = Communic::SubscribingRequest(topic, test->size);
+		job->buffer = (uint8_t *)Heap::Alloc(test->size);
+		p = Heap::Alloc(sizeof(Task));
+
+		if((job->sub == NULL) || (job->buffer == NULL) || (p == NULL))
+		{
+			Heap::Free(p);
+			return RealTime::fail;
+		}
+		job->task = new(p) Task(BenchSubCode, CommBench::subscriberPriority, CommBench::taskStackSize,
+								job, benchTASK_ID + i, "");
+	}
+
+	for(uint32_t i = 0; i < test->publishers; ++i)
+	{
+		benchJob_t *job = &this->pubJobs[i];
+
+		job->bench = this;
+		job->pub = Communic::PublishingRequest(topic, test->size);
+		job->buffer = (uint8_t *)Heap::Alloc(test->size);
+		p = Heap::Alloc(sizeof(Task));
+
+		if((job->pub == NULL) || (job->buffer == NULL) || (p == NULL))
+		{
+			Heap::Free(p);
+			return RealTime::fail;
+		}
+		memset(job->buffer, (int)i + 1, test->size);
+		job->task = new(p) Task(BenchPubCode, CommBench::publisherPriority, CommBench::taskStackSize,
+								job, benchTASK_ID + CommBench::maxSubscribers + i, "");
+	}
+
+	return RealTime::ok;
+}
+
+/**
+ * @brief Delete the tasks, the links to the topic and the messages of a run.
+ *
+ * 		  The topic is deleted with its last link.
+ *
+ * @param test - The run parameters.
+ */
+void CommBench::Teardown(const benchCase_t *test)
+{
+	for(uint32_t i = 0; i < test->publishers; ++i)
+	{
+		benchJob_t *job = &this->pubJobs[i];
+
+		if(job->task != NULL)
+		{
+			job->task->~Task();
+			Heap::Free(job->task);
+		}
+		if(job->pub != NULL)
+		{
+			Communic::LeaveTopic(job->pub);
+		}
+		Heap::Free(job->buffer);
+	}
+
+	for(uint32_t i = 0; i < test->subscribers; ++i)
+	{
+		benchJob_t *job = &this->subJobs[i];
+
+		if(job->task != NULL)
+		{
+			job->task->~Task();
+			Heap::Free(job->task);
+		}
+		if(job->sub != NULL)
+		{
+			Communic::LeaveTopic(job->sub);
+		}
+		Heap::Free(job->buffer);
+	}
+}
+
+/**
+ * @brief Send messages to the topic until the end of the run,
+ * 		  at the run rate or back to back.
+ *
+ * @param job - The publisher task state.
+ */
+void CommBench::Publish(benchJob_t *job)
+{
+	timeCount_t interval = (this->rate == 0)? 0 : Timer::GetPeriod()/this->rate;
+	timeCount_t next = this->startTime;
+
+	Task::DelayUntil(this->startTime);
+
+	while(Timer::GetTime() < this->endTime)
+	{
+		if(interval != 0)
+		{
+			Task::DelayUntil(next);
+			next += interval;
+		}
+
+		if(job->pub->Send(job->buffer))
+		{
+			job->count++;
+		}
+		else
+		{
+			job->failed++;
+		}
+	}
+	job->done = true;
+}
+
+/**
+ * @brief Receive messages from the topic until the run finishes.
+ *
+ * @param job - The subscriber task state.
+ */
+void CommBench::Receive(benchJob_t *job)
+{
+	while(!this->stop)
+	{
+		if(job->sub->Receive(job->buffer))
+		{
+			job->count++;
+		}
+	}
+	job->done = true;
+}
+
+/**
+ * @brief Get the processor time used by all the threads of the executable.
+ *
+ * 		  In Xenomai, the time of the tasks in the primary mode
+ * 		  may not be counted by Linux.
+ *
+ * @return The processor time in seconds.
+ */
+double CommBench::GetProcessTime(void)
+{
+	struct timespec time;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+	return time.tv_sec + time.tv_nsec/1e9;
+}
+
+/**
+ * @brief The code executed by each publisher task of a run.
+ *
+ * @arg - The benchJob_t of the task.
+ */
+taskFUNCTION(BenchPubCode, arg)
+{
+	benchJob_t *job = (benchJob_t *)arg;
+
+	job->bench->Publish(job);
+}
+
+/**
+ * @brief The code executed by each subscriber task of a run.
+ *
+ * @arg - The benchJob_t of the task.
+ */
+taskFUNCTION(BenchSubCode, arg)
+{
+	benchJob_t *job = (benchJob_t *)arg;
+
+	job->bench->Receive(job);
+}
+
+/***************************************************************************************
+ * END: Module - commbench.cpp
+ ***************************************************************************************/
@@ -0,0 +1,134 @@
+/**
+ * @file	commbench.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the micro-benchmark of the Communic subsystem alone,
+ * without the synthetic workload of the experiments. Publisher tasks send
+ * messages to subscriber tasks of one topic in the same executable, while
+ * the message size, the publishing rate and the number of publishers and
+ * subscribers are swept. Each run is written as a line of a CSV file, so
+ * the results of different builds and backends can be compared.
+ */
+
+#ifndef COMMBENCH_MACRO_HPP
+#define COMMBENCH_MACRO_HPP
+
+/*MODULE INCLUDES*/
+/*=======================================================================================*/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "realtime.hpp"
+#include "task.hpp"
+#include "histogram.hpp"
+
+/*MACROS*/
+/*=======================================================================================*/
+
+#define benchRESULT_FILE "robotstone_commbench.csv" /**< The results of the micro-benchmark runs. */
+
+/*MODULE TYPES*/
+/*=======================================================================================*/
+
+class CommBench;
+
+/**
+ * @brief The parameters of a benchmark run.
+ */
+typedef struct
+{
+	int delivery; /**< Communic::gatekeeper or Communic::direct. */
+	uint32_t size; /**< The message size in bytes. */
+	uint32_t rate; /**< Messages per second of each publisher, or 0 to publish back to back. */
+	uint32_t publishers;
+	uint32_t subscribers;
+}benchCase_t;
+
+/**
+ * @brief The state of a publisher or subscriber task in a run.
+ */
+typedef struct
+{
+	CommBench *bench;
+	RealTime::Task *task;
+	RealTime::Publisher *pub; /**< The publishing link, or NULL in a subscriber task. */
+	RealTime::Subscriber *sub; /**< The subscribing link, or NULL in a publisher task. */
+	uint8_t *buffer; /**< The message sent or received. */
+	uint32_t count; /**< Messages published or received. */
+	uint32_t failed; /**< Messages that Publisher::Send could not publish. */
+	volatile bool done; /**< Indicates that the task left its loop. */
+}benchJob_t;
+
+/*CLASSES*/
+/*=======================================================================================*/
+
+/**
+ * @brief Measures the throughput, latency, processor time and allocations
+ * 		  of Publisher::Send, Topic::SendMessages and Subscriber::Receive.
+ *
+ * 		  The sweeps vary one parameter at a time from a baseline run of
+ * 		  one publisher and one subscriber of small messages, in each
+ * 		  delivery mode. Each run uses a new topic, so no run sees the
+ * 		  messages or the statistics of another one.
+ */
+class CommBench
+{
+public:
+	static const uint32_t maxPublishers = 8;
+	static const uint32_t maxSubscribers = 256;
+	static const uint32_t minSize = 8;
+	static const uint32_t maxSize = 4194304;
+	static const uint32_t baselineSize = 64;
+	static const uint32_t baselineRate = 1000; /**< Messages per second of each publisher in the publishers and subscribers sweeps. */
+	static const uint32_t runTime = 1000; /**< Publishing time of each run in ms. */
+	static const uint32_t drainTime = 100; /**< Time in ms for the subscribers to read the last messages. */
+	static const uint8_t subscriberPriority = 80; /**< Below the topics gatekeeper tasks. */
+	static const uint8_t publisherPriority = 70;
+	static const uint32_t taskStackSize = 100000;
+	static const size_t firstTopic = 100; /**< The topic of the first run. */
+private:
+	benchJob_t pubJobs[maxPublishers];
+	benchJob_t subJobs[maxSubscribers];
+	Histogram latency; /**< Of all the subscribers of a run. */
+	RealTime::timeCount_t startTime;
+	RealTime::timeCount_t endTime; /**< When the publishers stop. */
+	uint32_t rate; /**< Messages per second of each publisher in the run, or 0. */
+	volatile bool stop; /**< Indicates to the subscribers that the run finished. */
+	size_t nextTopic;
+	const char *fileName;
+	FILE *file;
+public:
+	CommBench(const char *fileName);
+	void Run(void);
+
+private:
+	friend taskFUNCTION(BenchPubCode, arg);
+	friend taskFUNCTION(BenchSubCode, arg);
+	void RunCase(const benchCase_t *test);
+	int Setup(const benchCase_t *test, size_t topic);
+	void Teardown(const benchCase_t *test);
+	void Publish(benchJob_t *job);
+	void Receive(benchJob_t *job);
+	static double GetProcessTime(void);
+};
+
+#endif // COMMBENCH_MACRO_HPP
+/***************************************************************************************
+ * END: Module - commbench.hpp
+ ***************************************************************************************/
@@ -24,11 +24,17 @@
 #include "communic.hpp"
 #include <sys/types.h>
 #include <unistd.h>
+#include <string.h>
 #include <iostream>
 #include "test_led.hpp"
+#include "network.hpp"
 
 #define SUB_BUFFER_SIZE 30
+#define TOPIC_BUFFER_SIZE 16 /**< Messages of the gatekeeper topic queue, more than the publishers sending at the same time. */
+#define TOPIC_BUFFER_BYTES 16777216 /**< Limit of the gatekeeper topic queue memory for big messages. */
 #define TOPIC_TASK_PRIORITY 90
+#define TOPIC_BIND_TIMEOUT 1000000000
+#define STATE_READ_RETRIES 4
 
 using namespace std;
 
@@ -37,6 +43,8 @@ namespace RealTime
 
 #define comSTART_TASKS_ID 1000
 
+static uint32_t processTag = 0; /**< The process in the high bits of the messageHeader_t publisherID, since the publishers identifiers are given by each process. */
+
 
 /*PRIVATE FUNCTIONS*/
 /*=======================================================================================*/
@@ -72,9 +80,41 @@ taskFUNCTION(TopicTaskFunc, args)
  * @param id - A subscriber unique identifier (it is attributed automatically by Communic system).
  * @param topic - The topic identifier.
  * @param topic - The size of the messages in the requested topic.
+ * @param topicHandler - The topic instance.
+ * @param qos - The quality of service of the subscription, or NULL for the default one.
  */
-Subscriber::Subscriber(size_t id, size_t topic, size_t msgSize)
+Subscriber::Subscriber(size_t id, size_t topic, size_t msgSize, void *topicHandler, const subscriberQoS_t *qos):
+		delivery(((Topic*)topicHandler)->GetDelivery()),
+		state(((Topic*)topicHandler)->GetState()),
+		pool(((Topic*)topicHandler)->GetPool()),
+		current(0),
+		stateSequence(0),
+		pending(0),
+		putSlots(NULL),
+		putNumber(0),
+		headerSize(Communic::GetHeaderSize()),
+		lostBase(0)
 {
+	if(qos != NULL)
+	{
+		this->qos = *qos;
+	}
+	else
+	{
+		this->qos.overflow = Communic::dropNewest;
+		this->qos.depth = SUB_BUFFER_SIZE;
+		this->qos.timeout = 0;
+		this->qos.lifespan = 0;
+	}
+
+	if(this->qos.depth == 0)
+	{
+		this->qos.depth = 1;
+	}
+
+	this->stats.sourcesNumber = 0;
+	this->stats.sourcesNext = 0;
+	this->ClearStats();
 
 	this->id = id;
 	this->topic = topic;
@@ -89,18 +129,58 @@ Subscriber::Subscriber(size_t id, size_t topic, size_t msgSize)
  */
 int Subscriber::Init(void)
 {
-	char subName[15];
-	size_t queueSize = (this->messageSize)*SUB_BUFFER_SIZE;
+	char subName[LocalHeap::maxNameLength];
 	int createReturn;
 
-	sprintf(subName, "sub_%d_%d_%d", getpid(), topic, id);
-	createReturn = rt_queue_create(&(this->queue), subName, queueSize, Q_UNLIMITED, Q_PRIO);
+	if(this->delivery == Communic::state)
+	{
+		// The task reads a copy of the sample, so a publisher never changes it while read.
+		this->samples[0] = (uint8_t *)Heap::Alloc(this->state->capacity);
+		this->samples[1] = (uint8_t *)Heap::Alloc(this->state->capacity);
+		if((this->samples[0] == NULL) || (this->samples[1] == NULL))
+		{
+			return RealTime::fail;
+		}
+		return RealTime::ok;
+	}
+
+	if(this->delivery == Communic::direct)
+	{
+		// Each subscriber has its own read sequence in the topic queue.
+		snprintf(subName, sizeof(subName), comTOPIC_NAME, (int)this->topic);
+		if(this->queue.Bind(subName, TOPIC_BIND_TIMEOUT))
+		{
+			return RealTime::fail;
+		}
+		return RealTime::ok;
+	}
+
+	snprintf(subName, sizeof(subName), "sub_%d_%d_%d", getpid(), (int)topic, (int)id);
+
+	createReturn = this->queue.Create(subName, sizeof(sharedMessage_t *), this->GetCapacity());
 	if(createReturn)
 	{
 		// Problem to create subscriber for topic: impossible create queue for subscriber handler
 		return RealTime::fail;
 	}
 
+	if(this->qos.overflow == Communic::keepLast)
+	{
+		this->putSlots = (sharedMessage_t ***)Heap::Alloc(this->qos.depth*sizeof(sharedMessage_t **));
+		if(this->putSlots == NULL)
+		{
+			return RealTime::fail;
+		}
+	}
+
+	if(this->qos.overflow == Communic::blocking)
+	{
+		for(uint32_t i = 0; i < this->qos.depth; ++i)
+		{
+			this->room.Post();
+		}
+	}
+
 	return RealTime::ok;
 }
 
@@ -109,7 +189,34 @@ int Subscriber::Init(void)
  */
 Subscriber::~Subscriber(void)
 {
-	rt_queue_delete(&(this->queue));
+	const void *msg;
+
+	if(this->delivery == Communic::state)
+	{
+		Heap::Free(this->samples[0]);
+		Heap::Free(this->samples[1]);
+		return;
+	}
+
+	if(this->delivery == Communic::direct)
+	{
+		this->queue.Unbind();
+		return;
+	}
+
+	// The messages not read yet are released, so their buffers go back to the heap.
+	while(this->pending > 0)
+	{
+		msg = this->Read();
+		if(msg == NULL)
+		{
+			break;
+		}
+		this->Release(msg);
+	}
+
+	this->queue.Delete();
+	Heap::Free(this->putSlots);
 }
 
 /**
@@ -157,55 +264,439 @@ size_t Subscriber::GetMessageSize(void)
  */
 size_t Subscriber::Receive(void *msg)
 {
-	void *queueMsg = NULL;
+	return this->Receive(msg, timerMAX_DELAY);
+}
 
-	// Take the queue buffer space with the length of message and copy the message content to message pointer parameter
-	if(rt_queue_receive(&(this->queue),
-			  	  	  (void **)&queueMsg,
-			  	  	  TM_INFINITE) < 0)
+/**
+ * @brief Wait to receive a message in the subscribed topic, for a limited time.
+ *
+ * @param msg - A pointer to a valid buffer at least the size
+ * 				of the message.
+ * @param timeout - The maximum wait in implementation specific units,
+ * 					or timerMAX_DELAY to wait forever.
+ *
+ * @return 1 - if success;
+ * 		   0 - if no message arrived in the timeout or otherwise;
+ */
+size_t Subscriber::Receive(void *msg, timeCount_t timeout)
+{
+	const void *sharedMsg = this->Read(timeout);
+	size_t length = this->messageSize;
+
+	if(sharedMsg == NULL)
 	{
 		return 0;
 	}
 
-	if(queueMsg == NULL)
+	if(this->delivery == Communic::gatekeeper)
 	{
-		rt_printf("Problem to get message: queue null for subscriber %d_%d_%d\n", this->id, this->topic, this->id);
-		//return 0;
-		exit(1);
-	}
+		const sharedMessage_t *header = (const sharedMessage_t *)((const uint8_t *)sharedMsg - this->headerSize) - 1;
 
-	memcpy(msg, queueMsg, this->messageSize);
+		if((header->length - this->headerSize) < length)
+		{
+			length = header->length - this->headerSize;
+		}
+	}
+	else if((this->delivery == Communic::state) && ((this->state->capacity - this->headerSize) < length))
+	{
+		length = this->state->capacity - this->headerSize;
+	}
+	memcpy(msg, sharedMsg, length);
 
-	// The buffer space taken from pointer of "rt_queue_receive" to warning Xenomai that message was read by the task.
-	rt_queue_free(&(this->queue), (void*)queueMsg);
+	this->Release(sharedMsg);
 	return 1;
 }
 
+/**
+ * @brief Get the number of messages that the subscriber queue holds.
+ *
+ * @return The queue capacity in messages.
+ */
+uint32_t Subscriber::GetCapacity(void)
+{
+	return this->qos.depth;
+}
+
+/**
+ * @brief Wait to receive a message in the subscribed topic, without copying it.
+ *
+ * 		  The message is shared with the other subscribers of the topic, so
+ * 		  it must not be changed, and it must be given back by Subscriber::Release.
+ * 		  In the direct delivery the message is in the topic queue, where it stays
+ * 		  valid until the publishers send as many messages as the queue depth.
+ * 		  If the messages have a header, its statistics are recorded here.
+ *
+ * 		  In Communic::keepLast, the messages discarded by newer ones in
+ * 		  Subscriber::PutMessage are skipped here.
+ *
+ * 		  In the state delivery it never waits: the last sample of the topic
+ * 		  is returned, even if it was already read.
+ *
+ * @return - A pointer to the message if success;
+ * 		   - NULL otherwise, or if no sample was published in the state delivery.
+ */
+const void* Subscriber::Read(void)
+{
+	return this->Read(timerMAX_DELAY);
+}
+
+/**
+ * @brief Wait to receive a message in the subscribed topic, without copying
+ * 		  it, for a limited time. See Subscriber::Read.
+ *
+ * @param timeout - The maximum wait in implementation specific units,
+ * 					or timerMAX_DELAY to wait forever. It is not used in
+ * 					the state delivery, which never waits.
+ *
+ * @return - A pointer to the message if success;
+ * 		   - NULL if no message arrived in the timeout or otherwise.
+ */
+const void* Subscriber::Read(timeCount_t timeout)
+{
+	sharedMessage_t **queueMsg = NULL;
+	sharedMessage_t *sharedMsg = NULL;
+	const uint8_t *msg;
+	uint32_t remaining;
+
+	if(this->delivery == Communic::state)
+	{
+		remaining = this->ReadState();
+		if(remaining == 0)
+		{
+			return NULL;
+		}
+
+		msg = this->samples[this->current];
+		if(remaining == this->stateSequence)
+		{
+			return (const void *)(msg + this->headerSize);
+		}
+
+		// Each sample written increments the sequence twice.
+		if(this->stateSequence != 0)
+		{
+			this->stats.overwritten += (remaining - this->stateSequence)/2 - 1;
+		}
+		this->stateSequence = remaining;
+	}
+	else if(this->delivery == Communic::direct)
+	{
+		if(this->queue.Receive((void **)&queueMsg, timeout) < 0)
+		{
+			return NULL;
+		}
+		msg = (const uint8_t *)queueMsg;
+	}
+	else
+	{
+		while(sharedMsg == NULL)
+		{
+			if(this->queue.Receive((void **)&queueMsg, timeout) < 0)
+			{
+				return NULL;
+			}
+
+			if(queueMsg == NULL)
+			{
+				Stdout::Print("Problem to get message: queue null for subscriber %d_%d_%d\n", this->id, this->topic, this->id);
+				//return 0;
+				exit(1);
+			}
+
+			// In Communic::keepLast the gatekeeper task may take the message back at the same time.
+			if(this->qos.overflow == Communic::keepLast)
+			{
+				sharedMsg = __sync_lock_test_and_set(queueMsg, (sharedMessage_t *)NULL);
+			}
+			else
+			{
+				sharedMsg = *queueMsg;
+			}
+
+			// The buffer space taken from Queue::Receive is given back to warn the queue that message was read by the task.
+			this->queue.Free((void*)queueMsg);
+
+			if(sharedMsg == NULL)
+			{
+				continue; // Already discarded by a newer message.
+			}
+			__sync_sub_and_fetch(&this->pending, 1);
+
+			if(this->qos.overflow == Communic::blocking)
+			{
+				this->room.Post();
+			}
+		}
+
+		msg = (const uint8_t *)(sharedMsg + 1);
+	}
+
+	this->stats.received++;
+
+	if(this->headerSize != 0)
+	{
+		this->RecordHeader((const messageHeader_t *)msg);
+	}
+
+	return (const void *)(msg + this->headerSize);
+}
+
+/**
+ * @brief Give back a message taken by Subscriber::Read.
+ *
+ * 		  The message buffer goes back to the heap when
+ * 		  all the subscribers of the topic released it.
+ *
+ * @param msg - The pointer returned by Subscriber::Read.
+ */
+void Subscriber::Release(const void *msg)
+{
+	uint8_t *queueMsg = (uint8_t *)msg - this->headerSize;
+
+	if(this->delivery == Communic::state)
+	{
+		return;
+	}
+
+	if(this->delivery == Communic::direct)
+	{
+		this->queue.Free(queueMsg);
+		return;
+	}
+
+	this->ReleaseShared(((sharedMessage_t *)queueMsg) - 1);
+}
+
+/**
+ * @brief Give back the reference of the subscriber to a shared message.
+ *
+ * @param sharedMsg - The shared message.
+ */
+void Subscriber::ReleaseShared(sharedMessage_t *sharedMsg)
+{
+	if(__sync_sub_and_fetch(&sharedMsg->references, 1) == 0)
+	{
+		this->pool->Free(sharedMsg);
+	}
+}
+
+/**
+ * @brief Copy the last sample of the topic slot, without locking.
+ *
+ * 		  If a publisher writes the slot during the copy, the copy is
+ * 		  retried a few times and then the last sample read is kept, so
+ * 		  a preempted publisher never holds the subscriber.
+ *
+ * @return The slot sequence of the sample in samples[current], or 0 if none.
+ */
+uint32_t Subscriber::ReadState(void)
+{
+	uint32_t sequence;
+	uint32_t length;
+	uint8_t next = this->current ^ 1;
+
+	for(int i = 0; i < STATE_READ_RETRIES; ++i)
+	{
+		sequence = this->state->sequence;
+		if(sequence == 0)
+		{
+			return 0;
+		}
+		if(sequence & 1)
+		{
+			continue;
+		}
+		__sync_synchronize();
+
+		length = this->state->length;
+		if(length > this->state->capacity)
+		{
+			continue;
+		}
+		memcpy(this->samples[next], (const void *)(this->state + 1), length);
+		__sync_synchronize();
+
+		if(this->state->sequence == sequence)
+		{
+			this->current = next;
+			return sequence;
+		}
+	}
+
+	return this->stateSequence;
+}
+
+/**
+ * @brief Record the latency and the sequence of a message received.
+ *
+ * @param header - The header of the message.
+ */
+void Subscriber::RecordHeader(const messageHeader_t *header)
+{
+	timeCount_t latency = Timer::GetTime();
+	messageSource_t *source = NULL;
+	int32_t distance;
+
+	latency = (latency > header->publishTime)? latency - header->publishTime : 0;
+	this->stats.latencySum += latency;
+	this->stats.latency.Record(latency);
+
+	if((this->qos.lifespan != 0) && (latency > this->qos.lifespan))
+	{
+		this->stats.late++;
+	}
+
+	for(uint32_t i = 0; i < this->stats.sourcesNumber; ++i)
+	{
+		if(this->stats.sources[i].publisherID == header->publisherID)
+		{
+			source = &this->stats.sources[i];
+			break;
+		}
+	}
+
+	if(source == NULL)
+	{
+		// A new publisher replaces the one added first if there are too many.
+		if(this->stats.sourcesNumber < comMAX_SOURCES)
+		{
+			source = &this->stats.sources[this->stats.sourcesNumber++];
+		}
+		else
+		{
+			source = &this->stats.sources[this->stats.sourcesNext];
+			this->stats.sourcesNext = (this->stats.sourcesNext + 1) % comMAX_SOURCES;
+		}
+		source->publisherID = header->publisherID;
+		source->expected = header->sequence;
+	}
+
+	distance = (int32_t)(header->sequence - source->expected);
+	if(distance >= 0)
+	{
+		// The samples skipped in a state topic are counted as overwritten in Subscriber::Read.
+		if(this->delivery != Communic::state)
+		{
+			this->stats.lost += distance;
+		}
+		source->expected = header->sequence + 1;
+	}
+	else
+	{
+		this->stats.reordered++;
+	}
+}
+
+/**
+ * @brief Get the statistics of the messages received.
+ *
+ * 		  The latency, late, lost and reordered messages are valid only if
+ * 		  Communic::SetMessageHeader enabled the headers.
+ *
+ * @return The statistics.
+ */
+messageStats_t* Subscriber::GetStats(void)
+{
+	// In the direct delivery the topic queue overwrites the oldest messages.
+	if(this->delivery == Communic::direct)
+	{
+		this->stats.overwritten = this->queue.GetLostNumber() - this->lostBase;
+	}
+	return &this->stats;
+}
+
+/**
+ * @brief Clear the statistics of the messages received, keeping the publishers sequences.
+ */
+void Subscriber::ClearStats(void)
+{
+	this->lostBase = this->queue.GetLostNumber();
+	this->stats.received = 0;
+	this->stats.dropped = 0;
+	this->stats.overwritten = 0;
+	this->stats.late = 0;
+	this->stats.lost = 0;
+	this->stats.reordered = 0;
+	this->stats.latencySum = 0;
+	this->stats.latency.Clear();
+}
+
 /**
  * @brief This method is called by the topic gatekeeper task to
- * 		  put a copy of the last message sent to the topic in
- * 		  the subscriber buffer.
+ * 		  put the last message sent to the topic in the subscriber
+ * 		  buffer. Only the message pointer is queued.
+ *
+ * 		  If the subscriber buffer is full, the message is released
+ * 		  instead and counted as dropped, so it is never overwritten
+ * 		  while read. In Communic::blocking, the gatekeeper task
+ * 		  first waits for room up to the subscription timeout.
  *
- * @param msg - A pointer to a buffer with the copy of the message.
+ * 		  In Communic::keepLast, the message put depth messages before
+ * 		  is taken back from its queue slot, if not read yet, and it is
+ * 		  released and counted as overwritten, so the queue always has room.
+ *
+ * @param msg - The shared message, with a reference for this subscriber.
  *
  * @return 1 - if success;
  * 		   0 - otherwise;
  */
-size_t Subscriber::PutMessage(void *msg)
+size_t Subscriber::PutMessage(sharedMessage_t *msg)
 {
-	void *queueSubMsg = NULL;
-	queueSubMsg = rt_queue_alloc(&(this->queue), this->messageSize);
+	sharedMessage_t **queueSubMsg = NULL;
+	sharedMessage_t *oldMsg;
+
+	if(this->qos.overflow == Communic::blocking)
+	{
+		if(this->room.Wait(this->qos.timeout) != RealTime::ok)
+		{
+			this->stats.dropped++;
+			this->ReleaseShared(msg);
+			return 0;
+		}
+	}
+	else if(this->qos.overflow == Communic::keepLast)
+	{
+		// The queue depth is at least the subscription depth, so the slot was not reused yet.
+		if(this->putNumber >= this->qos.depth)
+		{
+			oldMsg = __sync_lock_test_and_set(this->putSlots[this->putNumber % this->qos.depth], (sharedMessage_t *)NULL);
+			if(oldMsg != NULL)
+			{
+				__sync_sub_and_fetch(&this->pending, 1);
+				this->stats.overwritten++;
+				this->ReleaseShared(oldMsg);
+			}
+		}
+	}
+	else if(this->pending >= this->GetCapacity())
+	{
+		this->stats.dropped++;
+		this->ReleaseShared(msg);
+		return 0;
+	}
+
+	queueSubMsg = (sharedMessage_t **)this->queue.Alloc(sizeof(sharedMessage_t *));
 
 	if(queueSubMsg == NULL)
 	{
-		rt_printf("Problem put message: impossible to alloc subscriber queue for topic %d\n", this->topic);
+		if(this->qos.overflow == Communic::blocking)
+		{
+			this->room.Post();
+		}
+		this->stats.dropped++;
+		this->ReleaseShared(msg);
 		return 0;
-		//exit(1);
 	}
 
-	memcpy(queueSubMsg, msg, this->messageSize);
+	*queueSubMsg = msg;
+	__sync_fetch_and_add(&this->pending, 1);
 
-	rt_queue_send(&(this->queue), queueSubMsg, this->messageSize, Q_NORMAL);
+	if(this->qos.overflow == Communic::keepLast)
+	{
+		this->putSlots[this->putNumber++ % this->qos.depth] = queueSubMsg;
+	}
+
+	this->queue.Send(queueSubMsg, sizeof(sharedMessage_t *), comQueue_t::normal);
 	return 1;
 }
 
@@ -232,7 +723,11 @@ Publisher::Publisher(size_t id, size_t topic, size_t msgSize, void *topicHandler
 		topicHandler(topicHandler),
 		id(id),
 		messageSize(msgSize),
-		topicQueue(((Topic*)topicHandler)->GetQueue())
+		topicQueue(((Topic*)topicHandler)->GetQueue()),
+		delivery(((Topic*)topicHandler)->GetDelivery()),
+		sample(NULL),
+		headerSize(Communic::GetHeaderSize()),
+		sequence(0)
 {
 
 }
@@ -245,6 +740,15 @@ Publisher::Publisher(size_t id, size_t topic, size_t msgSize, void *topicHandler
  */
 int Publisher::Init(void)
 {
+	// The sample is built apart, so the topic slot is locked only while it is copied.
+	if(this->delivery == Communic::state)
+	{
+		this->sample = (uint8_t *)Heap::Alloc(this->messageSize + this->headerSize);
+		if(this->sample == NULL)
+		{
+			return RealTime::fail;
+		}
+	}
 	return RealTime::ok;
 }
 
@@ -254,7 +758,10 @@ int Publisher::Init(void)
  */
 Publisher::~Publisher(void)
 {
-
+	if(this->sample != NULL)
+	{
+		Heap::Free(this->sample);
+	}
 }
 
 /**
@@ -300,7 +807,7 @@ size_t Publisher::Send(void *msg)
 {
 	void *queueMsg;
 	// Take the queue buffer space with the length of message and copy the message content to buffer
-	queueMsg = rt_queue_alloc((RT_QUEUE*)(this->topicQueue),this->messageSize);
+	queueMsg = this->Loan();
 
 	if(queueMsg == NULL)
 	{
@@ -309,8 +816,77 @@ size_t Publisher::Send(void *msg)
 
 	memcpy(queueMsg, msg, this->messageSize);
 
+	return this->Publish(queueMsg);
+}
+
+/**
+ * @brief Take the topic queue buffer of the next message, so the
+ * 		  publisher builds the message in place, without a copy.
+ *
+ * 		  The buffer must be given to Publisher::Publish as soon as the
+ * 		  message is ready, since the other publishers of the topic wait it.
+ * 		  In the state delivery it is a buffer of the publisher.
+ *
+ * @return - A pointer to a buffer with the message size of the topic;
+ * 		   - NULL otherwise.
+ */
+void* Publisher::Loan(void)
+{
+	uint8_t *queueMsg;
+
+	if(this->delivery == Communic::state)
+	{
+		return this->sample + this->headerSize;
+	}
+
+	queueMsg = (uint8_t *)this->topicQueue->Alloc(this->messageSize + this->headerSize);
+
+	if(queueMsg == NULL)
+	{
+		((Topic*)this->topicHandler)->CountExhausted();
+		return NULL;
+	}
+	return queueMsg + this->headerSize;
+}
+
+/**
+ * @brief Send a message built in the buffer taken by Publisher::Loan.
+ *
+ * @param msg - The buffer returned by Publisher::Loan.
+ *
+ * @return 1 - if success;
+ * 		   0 - otherwise.
+ */
+size_t Publisher::Publish(void *msg)
+{
+	uint8_t *queueMsg = (uint8_t *)msg - this->headerSize;
+	size_t size = this->messageSize + this->headerSize;
+
+	if(this->headerSize != 0)
+	{
+		messageHeader_t *header = (messageHeader_t *)queueMsg;
+
+		header->sequence = this->sequence++;
+		header->publisherID = processTag | (uint32_t)this->id;
+		header->publishTime = Timer::GetTime();
+	}
+
+	// The subscribers in the other node receive the message by the network.
+	if(Network::IsEnabled())
+	{
+		Network::Send(this->topic, queueMsg, size);
+	}
+
+	if(this->delivery == Communic::state)
+	{
+		return (((Topic*)this->topicHandler)->WriteState(queueMsg, size) == RealTime::ok)? 1 : 0;
+	}
+
 	// Send the message in the queue buffer for all tasks waiting the message
-	rt_queue_send((RT_QUEUE*)(this->topicQueue), (void*)queueMsg, this->messageSize, Q_BROADCAST);
+	if(this->topicQueue->Send(queueMsg, size, comQueue_t::broadcast) != RealTime::ok)
+	{
+		return 0;
+	}
 
 	return 1;
 }
@@ -331,15 +907,22 @@ bool Publisher::operator == (size_t id)
  *
  * @param topic - The topic identifier.
  * @param messageSize - The size of the messages in the requested topic.
+ * @param cpu - The processor of the gatekeeper task or Task::anyCPU.
+ * @param delivery - Communic::gatekeeper, Communic::direct or Communic::state.
  *
  */
-Topic::Topic(uint8_t topic, size_t messageSize):
+Topic::Topic(size_t topic, size_t messageSize, size_t cpu, int delivery):
 		pubNumber(0),
 		subNumber(0),
+		cpu(cpu),
+		delivery(delivery),
+		state(NULL),
+		exhausted(0),
+		poolDemand(0),
 		topicTask(NULL),
 		tasksNumber(0)
 {
-	this->messageLen = messageSize;
+	this->messageLen = messageSize + Communic::GetHeaderSize();
 	this->topicID = topic;
 }
 
@@ -352,44 +935,36 @@ Topic::Topic(uint8_t topic, size_t messageSize):
 int Topic::Init()
 {
 	int createReturn;
-	size_t queueSize = this->messageLen;
-	char *topicName;
+	char topicName[LocalHeap::maxNameLength];
 
-	topicName = (char *)Heap::Alloc(sizeof(strlen("topic_xx")));
+	snprintf(topicName, sizeof(topicName), comTOPIC_NAME, (int)this->topicID);
 
-	if(!topicName)
+	// In the direct and state delivery the publishers reach the subscribers, without a gatekeeper task.
+	if(this->delivery == Communic::gatekeeper)
 	{
-		return RealTime::fail;
-	}
-
-	sprintf(topicName, comTOPIC_NAME, this->topicID);
+		void* p = Heap::Alloc(sizeof(Task));
 
-	void* p = Heap::Alloc(sizeof(Task));
+		topicTask = new(p) Task(TopicTaskFunc, TOPIC_TASK_PRIORITY, 100000, this, comSTART_TASKS_ID + this->topicID, "");
+		topicTask->SetAffinity(this->cpu);
 
-	topicTask = new(p) Task(TopicTaskFunc, TOPIC_TASK_PRIORITY, 100000, this, comSTART_TASKS_ID + this->topicID, "");
+		// The blocks are added by the subscribers in Topic::AddSubscriber.
+		if(this->pool.Create(sizeof(sharedMessage_t) + this->messageLen, comPOOL_MAX_BLOCKS) != RealTime::ok)
+		{
+			return RealTime::fail;
+		}
+	}
 
 	// If no queue related to topic exist, so there it is no exist.
-	if(rt_queue_bind(&(this->queue), topicName, 1000000000))
+	if(this->BindMessages(topicName))
 	{
-		createReturn = rt_mutex_create(&(this->mutex), topicName);
+		createReturn = this->mutex.Create(topicName);
 		if(createReturn)
 		{
 			// Problem to create topic: impossible create topic
 			return RealTime::fail;
 		}
 
-		/*
-		* Arguments: -*queue descriptor,
-		*            -string with topic name related to the queue,
-		*            -queue size with message length + the message header length used by Xenomai,
-		*            -Q_UNLIMITED indicates no error if buffer overflow,
-		*            -Q_PRIO indicate that the message from the highest priority task that arrives is the first that goes.
-		*/
-		createReturn = rt_queue_create(&(this->queue),
-										topicName,
-					      	  	  	  	queueSize,
-					      	  	  	  	Q_UNLIMITED,
-					      	  	  	  	Q_PRIO);
+		createReturn = this->CreateMessages(topicName);
 
 		if(createReturn)
         {
@@ -397,16 +972,13 @@ int Topic::Init()
 			return RealTime::fail;
 		}
 
-		if(rt_heap_create(&(this->heap), topicName, 2, H_SINGLE) != 0)
+		if(this->heap.Create(topicName, 2) != RealTime::ok)
 		{
 			// Problem to create topic: impossible create heap for topic
 			return RealTime::fail;
 		}
-		if(rt_heap_alloc(&(this->heap),
-						  2,
-						  TM_INFINITE,
-						  (void**)&(this->tasksNumber))
-				!= 0)
+		this->tasksNumber = (uint16_t *)this->heap.Alloc();
+		if(this->tasksNumber == NULL)
 		{
 			// Problem to create topic: impossible allocate heap for topic
 			return RealTime::fail;
@@ -417,23 +989,20 @@ int Topic::Init()
 	}
 	else
 	{
-		createReturn = rt_mutex_bind(&(this->mutex), topicName, 1000000000);
+		createReturn = this->mutex.Bind(topicName, TOPIC_BIND_TIMEOUT);
 		if(createReturn)
         {
 			// Problem to create topic locally: impossible bind topic mutex
 			return RealTime::fail;
 		}
-		createReturn = rt_heap_bind(&(this->heap), topicName, 1000000000);
+		createReturn = this->heap.Bind(topicName, 2, TOPIC_BIND_TIMEOUT);
 		if(createReturn)
         {
 			// Problem to create topic locally: impossible bind topic heap
 			return RealTime::fail;
 		}
-		if(rt_heap_alloc(&(this->heap),
-						  2,
-						  TM_INFINITE,
-						  (void**)&(this->tasksNumber))
-				!= 0)
+		this->tasksNumber = (uint16_t *)this->heap.Alloc();
+		if(this->tasksNumber == NULL)
 		{
 			// Problem to create topic: impossible allocate heap locally for topic
 			return RealTime::fail;
@@ -441,44 +1010,267 @@ int Topic::Init()
 
 	}
 
-	this->topicTask->Start();
+	// The messages from the other node are sent to the topic queue by the network receive task.
+	if(Network::IsEnabled() && (Network::AddTopic(this->topicID, this, this->messageLen) != RealTime::ok))
+	{
+		return RealTime::fail;
+	}
+
+	if(this->topicTask != NULL)
+	{
+		this->topicTask->Start();
+	}
+	return RealTime::ok;
+}
+
+/**
+ * @brief The Topic class destructor.
+ */
+Topic::~Topic(void)
+{
+	*(this->tasksNumber) = *(this->tasksNumber) - subNumber - pubNumber;
+
+	if(Network::IsEnabled())
+	{
+		Network::RemoveTopic(this->topicID);
+	}
+
+	if(this->topicTask != NULL)
+	{
+		this->topicTask->Unblock();
+		this->topicTask->Join();
+		this->pool.Delete();
+	}
+
+	if(*(this->tasksNumber) == 0)
+	{
+		if(this->delivery == Communic::state)
+		{
+			this->stateHeap.Delete();
+		}
+		else
+		{
+			this->queue.Delete();
+		}
+		this->heap.Free(this->tasksNumber);
+		this->heap.Delete();
+		this->mutex.Delete();
+	}
+	else
+	{
+		if(this->delivery == Communic::state)
+		{
+			this->stateHeap.Unbind();
+		}
+		else
+		{
+			this->queue.Unbind();
+		}
+		this->mutex.Unbind();
+	}
+}
+
+/**
+ * @brief Create the topic queue or, in the state delivery, the topic slot.
+ *
+ * @param name - The topic name.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Topic::CreateMessages(const char *name)
+{
+	char stateName[LocalHeap::maxNameLength];
+	size_t depth;
+
+	if(this->delivery == Communic::direct)
+	{
+		// The topic queue buffers the messages not read yet by the subscribers.
+		return this->queue.Create(name, this->messageLen, SUB_BUFFER_SIZE);
+	}
+
+	if(this->delivery == Communic::gatekeeper)
+	{
+		// The topic queue buffers the messages until the gatekeeper task dispatches them,
+		// so the publishers of all nodes don't overwrite a message while it is copied.
+		depth = TOPIC_BUFFER_BYTES/this->messageLen;
+		if(depth > TOPIC_BUFFER_SIZE)
+		{
+			depth = TOPIC_BUFFER_SIZE;
+		}
+		return this->queue.Create(name, this->messageLen, (depth < 2)? 2 : depth);
+	}
+
+	snprintf(stateName, sizeof(stateName), "s_%s", name);
+	if(this->stateHeap.Create(stateName, sizeof(sharedState_t) + this->messageLen) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+
+	this->state = (sharedState_t *)this->stateHeap.Alloc();
+	if(this->state == NULL)
+	{
+		return RealTime::fail;
+	}
+	this->state->sequence = 0;
+	this->state->length = 0;
+	this->state->capacity = this->messageLen;
+
+	Heap::SetSharedInit(&this->state->initState);
+	return RealTime::ok;
+}
+
+/**
+ * @brief Bind to the topic queue or, in the state delivery, to the topic slot.
+ *
+ * @param name - The topic name.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Topic::BindMessages(const char *name)
+{
+	char stateName[LocalHeap::maxNameLength];
+	size_t capacity;
+
+	if(this->delivery != Communic::state)
+	{
+		return this->queue.Bind(name, TOPIC_BIND_TIMEOUT);
+	}
+
+	// Map the slot header first to learn the sample capacity given by the creator.
+	snprintf(stateName, sizeof(stateName), "s_%s", name);
+	if(this->stateHeap.Bind(stateName, sizeof(sharedState_t), TOPIC_BIND_TIMEOUT) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+	this->state = (sharedState_t *)this->stateHeap.Alloc();
+	if(this->state == NULL)
+	{
+		return RealTime::fail;
+	}
+	Heap::WaitSharedInit(&this->state->initState);
+	capacity = this->state->capacity;
+	this->stateHeap.Unbind();
+
+	if(this->stateHeap.Bind(stateName, sizeof(sharedState_t) + capacity, TOPIC_BIND_TIMEOUT) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+	this->state = (sharedState_t *)this->stateHeap.Alloc();
+	if(this->state == NULL)
+	{
+		return RealTime::fail;
+	}
 	return RealTime::ok;
 }
 
 /**
- * @brief The Topic class destructor.
+ * @brief Get the topic queue.
+ *
+ * 		  This queue is shared between the publisher and the gatekeeper tasks.
+ *
+ * @return A pointer to the topic queue.
+ */
+comQueue_t * Topic::GetQueue(void)
+{
+	return &(this->queue);
+}
+
+/**
+ * @brief Get the topic slot, where the state delivery keeps the last sample.
+ *
+ * @return A pointer to the topic slot, or NULL in the other deliveries.
+ */
+sharedState_t * Topic::GetState(void)
+{
+	return this->state;
+}
+
+/**
+ * @brief Get the pool of shared messages of the gatekeeper delivery.
+ *
+ * @return A pointer to the pool.
+ */
+Pool * Topic::GetPool(void)
+{
+	return &(this->pool);
+}
+
+/**
+ * @brief Count a message not sent because no buffer was free.
+ */
+void Topic::CountExhausted(void)
+{
+	__sync_fetch_and_add(&this->exhausted, 1);
+}
+
+/**
+ * @brief Get the number of messages not sent because no buffer was free,
+ * 		  in the topic pool or in the topic queue.
+ *
+ * @return The number of messages since the statistics were cleared.
  */
-Topic::~Topic(void)
+uint32_t Topic::GetExhaustedNumber(void)
 {
-	*(this->tasksNumber) = *(this->tasksNumber) - subNumber - pubNumber;
+	return this->exhausted;
+}
 
-	this->topicTask->Unblock();
-	this->topicTask->Join();
+/**
+ * @brief Write a sample in the topic slot of the state delivery.
+ *
+ * 		  The sample is written only if no other publisher is writing the slot,
+ * 		  so a preempted publisher never holds the others.
+ *
+ * @param msg - The sample, with the message header if enabled.
+ * @param size - The sample size in bytes.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Topic::WriteState(const void *msg, size_t size)
+{
+	uint32_t sequence = this->state->sequence;
 
-	if(*(this->tasksNumber) == 0)
-	{
-		rt_queue_delete(&(this->queue));
-		rt_heap_free(&this->heap, this->tasksNumber);
-		rt_heap_delete(&this->heap);
-		rt_mutex_delete(&(this->mutex));
-	}
-	else
+	if((size > this->state->capacity) || (sequence & 1) ||
+	   !__sync_bool_compare_and_swap(&this->state->sequence, sequence, sequence + 1))
 	{
-		rt_queue_unbind(&(this->queue));
-		rt_mutex_unbind(&(this->mutex));
+		return RealTime::fail;
 	}
+
+	memcpy((void *)(this->state + 1), msg, size);
+	this->state->length = size;
+	__sync_synchronize();
+	this->state->sequence = sequence + 2;
+
+	return RealTime::ok;
 }
 
 /**
- * @brief Get the topic queue.
+ * @brief Deliver a message received from the other node to the local subscribers.
  *
- * 		  This queue is shared between the publisher and the gatekeeper tasks.
+ * @param msg - The message, with the message header if enabled.
+ * @param size - The message size in bytes.
  *
- * @return A pointer to the topic queue.
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
  */
-comQueue_t * Topic::GetQueue(void)
+int Topic::Deliver(const void *msg, size_t size)
 {
-	return &(this->queue);
+	void *buffer;
+
+	if(this->delivery == Communic::state)
+	{
+		return this->WriteState(msg, size);
+	}
+
+	buffer = this->queue.Alloc(size);
+	if(buffer == NULL)
+	{
+		return RealTime::fail;
+	}
+	memcpy(buffer, msg, size);
+	return this->queue.Send(buffer, size, comQueue_t::broadcast);
 }
 
 /**
@@ -491,6 +1283,16 @@ size_t Topic::GetTopicID(void)
 	return this->topicID;
 }
 
+/**
+ * @brief Get how the messages are delivered to the subscribers.
+ *
+ * @return Communic::gatekeeper, Communic::direct or Communic::state.
+ */
+int Topic::GetDelivery(void)
+{
+	return this->delivery;
+}
+
 /**
  * @brief Insert a subscriber instance in the topic list.
  *
@@ -501,8 +1303,37 @@ size_t Topic::GetTopicID(void)
  */
 size_t Topic::AddSubscriber(Subscriber* sub)
 {
+	// Each subscriber holds at most its queue messages and the one being read,
+	// but the big messages are limited by comPOOL_SUB_BYTES.
+	if(this->delivery == Communic::gatekeeper)
+	{
+		uint32_t blocks = sub->GetCapacity() + 1;
+		uint32_t limit = comPOOL_SUB_BYTES/(sizeof(sharedMessage_t) + this->messageLen);
+
+		if(limit < 2)
+		{
+			limit = 2;
+		}
+		this->poolDemand += (blocks < limit)? blocks : limit;
+
+		// The pool at least doubles in each growth, so many subscribers don't exhaust Pool::maxChunks.
+		if(this->poolDemand > this->pool.GetBlocksNumber())
+		{
+			blocks = this->poolDemand - this->pool.GetBlocksNumber();
+			this->pool.Grow((blocks > this->pool.GetBlocksNumber())? blocks : this->pool.GetBlocksNumber());
+		}
+	}
+
+	// The gatekeeper task walks the list in Topic::SendMessages.
+	this->mutex.Acquire();
+	if(!this->subsMap.Insert(sub->GetID(), sub))
+	{
+		this->mutex.Release();
+		return RealTime::fail;
+	}
 	this->subsList.InsertTail(sub);
 	this->subNumber += 1;
+	this->mutex.Release();
 	*(this->tasksNumber) = *(this->tasksNumber) + 1;
 	return RealTime::ok;
 }
@@ -517,6 +1348,10 @@ size_t Topic::AddSubscriber(Subscriber* sub)
  */
 size_t Topic::AddPublisher(Publisher* pub)
 {
+	if(!this->pubsMap.Insert(pub->GetID(), pub))
+	{
+		return RealTime::fail;
+	}
 	this->pubsList.InsertTail(pub);
 	this->pubNumber += 1;
 	*(this->tasksNumber) = *(this->tasksNumber) + 1;
@@ -533,8 +1368,11 @@ size_t Topic::AddPublisher(Publisher* pub)
  */
 size_t Topic::RemoveSubscriber(Subscriber* sub)
 {
+	this->mutex.Acquire();
+	this->subsMap.Remove(sub->GetID());
 	this->subsList.Remove(sub);
 	this->subNumber -= 1;
+	this->mutex.Release();
 	*(this->tasksNumber) = *(this->tasksNumber) - 1;
 	return RealTime::ok;
 }
@@ -549,8 +1387,9 @@ size_t Topic::RemoveSubscriber(Subscriber* sub)
  */
 size_t Topic::RemovePublisher(Publisher* pub)
 {
+	this->pubsMap.Remove(pub->GetID());
 	this->pubsList.Remove(pub);
-    this->pubNumber -= 1;
+	this->pubNumber -= 1;
 	*(this->tasksNumber) = *(this->tasksNumber) - 1;;
 	return RealTime::ok;
 }
@@ -558,7 +1397,7 @@ size_t Topic::RemovePublisher(Publisher* pub)
 /**
  * @brief Get the topic task gatekeeper object handler.
  *
- * @return The pointer to the task gatekeeper object handler.
+ * @return The pointer to the task gatekeeper object handler, or NULL in the direct delivery.
  */
 Task* Topic::GetTask(void)
 {
@@ -587,23 +1426,119 @@ size_t Topic::GetObjectsNumLocal(void)
 	return this->subNumber+this->pubNumber;
 }
 
+/**
+ * @brief Indicates if a subscriber identifier is in use in the topic.
+ *
+ * @param id - The subscriber identifier.
+ *
+ * @return true if the identifier is in use and false otherwise.
+ */
 bool Topic::HasSubID(size_t id)
 {
-	return this->subsList.HasKey(id);
+	return this->subsMap.Has(id);
 }
 
+/**
+ * @brief Indicates if a publisher identifier is in use in the topic.
+ *
+ * @param id - The publisher identifier.
+ *
+ * @return true if the identifier is in use and false otherwise.
+ */
 bool Topic::HasPubID(size_t id)
 {
-	return this->pubsList.HasKey(id);
+	return this->pubsMap.Has(id);
+}
+
+/**
+ * @brief Get the smallest subscriber identifier not in use in the topic.
+ *
+ * @return The identifier, taken by Topic::AddSubscriber.
+ */
+size_t Topic::GetFreeSubID(void)
+{
+	return this->subsMap.GetFree();
+}
+
+/**
+ * @brief Get the smallest publisher identifier not in use in the topic.
+ *
+ * @return The identifier, taken by Topic::AddPublisher.
+ */
+size_t Topic::GetFreePubID(void)
+{
+	return this->pubsMap.GetFree();
+}
+
+/**
+ * @brief Get a subscriber of the topic by its identifier.
+ *
+ * @param id - The subscriber identifier.
+ *
+ * @return The subscriber instance, or NULL if the identifier is not in use.
+ */
+Subscriber* Topic::GetSubscriber(size_t id)
+{
+	return this->subsMap.Get(id);
+}
+
+/**
+ * @brief Get a publisher of the topic by its identifier.
+ *
+ * @param id - The publisher identifier.
+ *
+ * @return The publisher instance, or NULL if the identifier is not in use.
+ */
+Publisher* Topic::GetPublisher(size_t id)
+{
+	return this->pubsMap.Get(id);
+}
+
+/**
+ * @brief Add the statistics of the local subscribers of the topic to a total.
+ *
+ * 		  The list is walked by its nodes, so the iteration of the
+ * 		  gatekeeper task in Topic::SendMessages is not disturbed.
+ *
+ * @param total - Where the statistics are added.
+ */
+void Topic::MergeStats(messageStats_t *total)
+{
+	for(ListNode<Subscriber> *node = this->subsList.GetHead(); node != NULL; node = node->GetNext())
+	{
+		messageStats_t *stats = node->GetValue()->GetStats();
+
+		total->received += stats->received;
+		total->dropped += stats->dropped;
+		total->overwritten += stats->overwritten;
+		total->late += stats->late;
+		total->lost += stats->lost;
+		total->reordered += stats->reordered;
+		total->latencySum += stats->latencySum;
+		total->latency.Add(stats->latency);
+	}
+}
+
+/**
+ * @brief Clear the statistics of the topic and of its local subscribers.
+ */
+void Topic::ClearStats(void)
+{
+	this->exhausted = 0;
+
+	for(ListNode<Subscriber> *node = this->subsList.GetHead(); node != NULL; node = node->GetNext())
+	{
+		node->GetValue()->ClearStats();
+	}
 }
 
 /**
  * @brief When a topic gatekeeper task go out from suspended
  * 		  it calls this method.
  *
- * 		  The topic gatekeeper task put a copy of the message
- * 		  from the topic queue (sent previously by a publisher) to
- * 		  ever subsciber queue in the topic list.
+ * 		  The topic gatekeeper task copies the message from the topic
+ * 		  queue (sent previously by a publisher) to a shared message
+ * 		  and puts its pointer in ever subsciber queue in the topic list.
  *
  *
  * @return - 1 if success;
@@ -612,22 +1547,56 @@ bool Topic::HasPubID(size_t id)
 size_t Topic::SendMessages(void)
 {
 	message_t *queuePointer = NULL;
+	sharedMessage_t *sharedMsg;
 
 	// Take the queue buffer space with the length of message and copy the message content to message pointer parameter
-	rt_queue_receive(&(this->queue), (void **)&queuePointer, TM_INFINITE);
+	this->queue.Receive((void **)&queuePointer);
 
 	if(queuePointer == NULL)
 	{
 		return 1; // Topic was deleted. Get out, to finish.
 	}
 
-	// Send for each subscriber the message on topic
-	for(this->subsList.InitIteration(); !this->subsList.IsEnd(); ++this->subsList)
+	// The subscribers can't join or leave the topic while the references are given.
+	this->mutex.Acquire();
+
+	if(this->subNumber > 0)
 	{
-	  	subsList.GetValue()->PutMessage(queuePointer);
+		// The message is copied once from the topic queue, shared by the
+		// publishers of all nodes, and every subscriber gets a reference.
+		sharedMsg = (sharedMessage_t *)this->pool.Alloc();
+
+		if(sharedMsg == NULL)
+		{
+			this->CountExhausted();
+		}
+		else
+		{
+			memcpy(sharedMsg + 1, queuePointer, this->messageLen);
+
+			// A message overwritten by a publisher during the copy is not dispatched,
+			// and it is counted as lost by the queue.
+			if(!this->queue.IsValid(queuePointer))
+			{
+				this->pool.Free(sharedMsg);
+			}
+			else
+			{
+				sharedMsg->length = this->messageLen;
+				sharedMsg->references = this->subNumber;
+
+				// Send for each subscriber the message on topic
+				for(this->subsList.InitIteration(); !this->subsList.IsEnd(); ++this->subsList)
+				{
+					subsList.GetValue()->PutMessage(sharedMsg);
+				}
+			}
+		}
 	}
 
-    rt_queue_free(&(this->queue), queuePointer);
+	this->mutex.Release();
+
+    this->queue.Free(queuePointer);
     return 0;
 }
 
@@ -645,12 +1614,15 @@ bool Topic::operator == (size_t topicID)
 namespace Communic
 {
 
-//static List<Topic, size_t> topicsList;
-#define MAX_TOPICS 256
+static Topic **topicsList = NULL; /**< The topic instances by identifier, with comMAX_TOPICS entries. */
+
+static uint8_t *topicsDelivery = NULL; /**< The delivery mode of each topic, used when the topic is created. */
 
-static Topic* topicsList[MAX_TOPICS];
+static comMutex_t comMutex;
 
-static RT_MUTEX comMutex;
+static bool useHeader = false; /**< Indicates that the messages have a messageHeader_t. */
+
+static messageStats_t topicStats; /**< Used to merge the subscribers statistics in PrintStats. */
 
 /**
  * @brief Initialize the Communic subsystem parameters and services.
@@ -661,37 +1633,122 @@ static RT_MUTEX comMutex;
  */
 int Init(void)
 {
-	if(rt_mutex_bind(&comMutex, "commtx", 10000000))
+	if(comMutex.Bind("commtx", 10000000))
 	{
 		int createReturn;
 
-		createReturn = rt_mutex_create(&comMutex, "commtx");
+		createReturn = comMutex.Create("commtx");
 		if(createReturn)
 		{
 			// Problem in Communic: impossible create mutex
 			return RealTime::fail;
 		}
 	}
-	for(size_t i = 0; i < MAX_TOPICS; ++i)
+	if(topicsList == NULL)
+	{
+		topicsList = (Topic **)Heap::Alloc(comMAX_TOPICS*sizeof(Topic *));
+		topicsDelivery = (uint8_t *)Heap::Alloc(comMAX_TOPICS*sizeof(uint8_t));
+
+		if((topicsList == NULL) || (topicsDelivery == NULL))
+		{
+			// Problem in Communic: impossible create the topics table
+			return RealTime::fail;
+		}
+	}
+	for(size_t i = 0; i < comMAX_TOPICS; ++i)
 	{
 		topicsList[i] = NULL;
+		topicsDelivery[i] = Communic::gatekeeper;
+	}
+	processTag = (uint32_t)getpid() << 16;
+
+	return RealTime::ok;
+}
+
+/**
+ * @brief Set how the messages of a topic are delivered to its subscribers.
+ *
+ * 		  It must be called before the first request for the topic, with
+ * 		  the same mode in all the executables that use the topic.
+ * 		  Without comSHM_RING in Xenomai, a direct delivery message is received
+ * 		  only by the subscribers waiting it, as in a broadcast to a RT_QUEUE.
+ *
+ * @param topic - The topic identifier or Communic::allTopics.
+ * @param mode - Communic::gatekeeper (default), Communic::direct or Communic::state.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int SetDelivery(size_t topic, int mode)
+{
+	if((mode != Communic::gatekeeper) && (mode != Communic::direct) && (mode != Communic::state))
+	{
+		return RealTime::fail;
+	}
+
+	if(topic == Communic::allTopics)
+	{
+		for(size_t i = 0; i < comMAX_TOPICS; ++i)
+		{
+			topicsDelivery[i] = mode;
+		}
+		return RealTime::ok;
+	}
+
+	if(topic >= comMAX_TOPICS)
+	{
+		return RealTime::fail;
 	}
 
+	topicsDelivery[topic] = mode;
 	return RealTime::ok;
 }
 
+/**
+ * @brief Enable the messageHeader_t before each message, used to measure
+ * 		  the latency and to detect the lost and reordered messages.
+ *
+ * 		  It must be called before the first request for a topic, with
+ * 		  the same value in all the executables that use the topics.
+ *
+ * @param enable - true to put the header in the messages.
+ */
+void SetMessageHeader(bool enable)
+{
+	useHeader = enable;
+}
+
+/**
+ * @brief Get the size of the header before each message.
+ *
+ * @return The size of messageHeader_t, or 0 if the header is disabled.
+ */
+size_t GetHeaderSize(void)
+{
+	return useHeader? sizeof(messageHeader_t) : 0;
+}
+
 /**
  * @brief Make a request for subscribing in a specific topic.
  *
  * @param topic - The topic identifier (a decimal number defined by the user).
  * @param msgSize - The size of the message to be expected in this topic.
+ * @param cpu - The processor of the topic gatekeeper task, if the topic is created.
+ * @param qos - The quality of service of the subscription, or NULL for the default
+ * 				one: Communic::dropNewest with 30 messages. In the direct delivery,
+ * 				the topic queue always keeps the last messages for all the subscribers.
  *
  * @return - A valid Subscriber instance if success;
  * 		   - NULL otherwise.
  */
-Subscriber* SubscribingRequest(size_t topic, uint64_t msgSize){
+Subscriber* SubscribingRequest(size_t topic, uint64_t msgSize, size_t cpu, const subscriberQoS_t *qos){
 
-	rt_mutex_acquire(&comMutex, TM_INFINITE); // nobody can request for publish, subscribe, send or receive messages
+	if(topic >= comMAX_TOPICS)
+	{
+		return NULL;
+	}
+
+	comMutex.Acquire(); // nobody can request for publish, subscribe, send or receive messages
 
 	Subscriber *subHandler;
 	int newTopicFlag = 0;
@@ -707,13 +1764,13 @@ Subscriber* SubscribingRequest(size_t topic, uint64_t msgSize){
 		void * p = RealTime::Heap::Alloc(sizeof(Topic));
 		if(p == NULL) // impossible create space for topic
 		{
-			rt_mutex_release(&comMutex);
+			comMutex.Release();
 			return NULL;
 		}
 		else
 		{
 			// Create the topic
-			topicHandler = new(p) Topic(topic, msgSize);
+			topicHandler = new(p) Topic(topic, msgSize, cpu, topicsDelivery[topic]);
 
 			if(topicHandler->Init() == RealTime::fail)
 			{
@@ -721,7 +1778,7 @@ Subscriber* SubscribingRequest(size_t topic, uint64_t msgSize){
 				topicHandler->~Topic();
 				RealTime::Heap::Free(topicHandler);
 
-				rt_mutex_release(&comMutex);
+				comMutex.Release();
 				return NULL;
 			}
 
@@ -739,12 +1796,12 @@ Subscriber* SubscribingRequest(size_t topic, uint64_t msgSize){
 			RealTime::Heap::Free(topicHandler);
 		}
 
-		rt_mutex_release(&comMutex);
+		comMutex.Release();
 		return NULL;
 	}
 
 	// Create a new subscriber with a new unique ID
-	subHandler = new(p) Subscriber(GetValidSubID(topicHandler), topic, msgSize);
+	subHandler = new(p) Subscriber(GetValidSubID(topicHandler), topic, msgSize, topicHandler, qos);
 
 	if(subHandler->Init() == RealTime::fail)
 	{
@@ -760,13 +1817,27 @@ Subscriber* SubscribingRequest(size_t topic, uint64_t msgSize){
 			RealTime::Heap::Free(subHandler);
 		}
 
-		rt_mutex_release(&comMutex);
+		comMutex.Release();
 		return NULL;
 	}
 
-	topicHandler->AddSubscriber(subHandler);
+	if(topicHandler->AddSubscriber(subHandler) != RealTime::ok)
+	{
+		subHandler->~Subscriber();
+		RealTime::Heap::Free(subHandler);
+
+		if(newTopicFlag) // if topic was not created before, erase it
+		{
+			topicsList[topic] = NULL;
+			topicHandler->~Topic();
+			RealTime::Heap::Free(topicHandler);
+		}
+
+		comMutex.Release();
+		return NULL;
+	}
 
-	rt_mutex_release(&comMutex);
+	comMutex.Release();
 	return subHandler;
 }
 
@@ -775,13 +1846,19 @@ Subscriber* SubscribingRequest(size_t topic, uint64_t msgSize){
  *
  * @param topic - The topic identifier (a decimal number defined by the user).
  * @param msgSize - The size of the message to be expected in this topic.
+ * @param cpu - The processor of the topic gatekeeper task, if the topic is created.
  *
  * @return - A valid Publisher instance if success;
  * 		   - NULL otherwise.
  */
-Publisher* PublishingRequest(size_t topic, uint64_t msgSize){
+Publisher* PublishingRequest(size_t topic, uint64_t msgSize, size_t cpu){
+
+	if(topic >= comMAX_TOPICS)
+	{
+		return NULL;
+	}
 
-	rt_mutex_acquire(&comMutex, TM_INFINITE); // nobody can request for publish, subscribe, send or receive messages
+	comMutex.Acquire(); // nobody can request for publish, subscribe, send or receive messages
 
 	Publisher *pubHandler;
 	int newTopicFlag = 0;
@@ -797,13 +1874,13 @@ Publisher* PublishingRequest(size_t topic, uint64_t msgSize){
 		void * p = RealTime::Heap::Alloc(sizeof(Topic));
 		if(p == NULL) // impossible create space for topic
 		{
-			rt_mutex_release(&comMutex);
+			comMutex.Release();
 			return NULL;
 		}
 		else
 		{
 			// Create the topic
-			topicHandler = new(p) Topic(topic, msgSize);
+			topicHandler = new(p) Topic(topic, msgSize, cpu, topicsDelivery[topic]);
 
 			if(topicHandler->Init() == RealTime::fail)
 			{
@@ -811,7 +1888,7 @@ Publisher* PublishingRequest(size_t topic, uint64_t msgSize){
 				topicHandler->~Topic();
 				RealTime::Heap::Free(topicHandler);
 
-				rt_mutex_release(&comMutex);
+				comMutex.Release();
 				return NULL;
 			}
 
@@ -829,7 +1906,7 @@ Publisher* PublishingRequest(size_t topic, uint64_t msgSize){
 			RealTime::Heap::Free(topicHandler);
 		}
 
-		rt_mutex_release(&comMutex);
+		comMutex.Release();
 		return NULL;
 	}
 
@@ -853,13 +1930,27 @@ Publisher* PublishingRequest(size_t topic, uint64_t msgSize){
 			RealTime::Heap::Free(pubHandler);
 		}
 
-		rt_mutex_release(&comMutex);
+		comMutex.Release();
 		return NULL;
 	}
 
-	topicHandler->AddPublisher(pubHandler);
+	if(topicHandler->AddPublisher(pubHandler) != RealTime::ok)
+	{
+		pubHandler->~Publisher();
+		RealTime::Heap::Free(pubHandler);
+
+		if(newTopicFlag) // if topic was not created before, erase it
+		{
+			topicsList[topic] = NULL;
+			topicHandler->~Topic();
+			RealTime::Heap::Free(topicHandler);
+		}
+
+		comMutex.Release();
+		return NULL;
+	}
 
-	rt_mutex_release(&comMutex);
+	comMutex.Release();
 	return pubHandler;
 }
 
@@ -872,13 +1963,14 @@ Publisher* PublishingRequest(size_t topic, uint64_t msgSize){
  * 		   - RealTime::fail otherwise.
  */
 int LeaveTopic(Publisher* pubHandler){
-	rt_mutex_acquire(&comMutex, TM_INFINITE); // nobody can request for publish, subscribe, send or receive messages
+	comMutex.Acquire(); // nobody can request for publish, subscribe, send or receive messages
 	size_t topic = pubHandler->GetTopic();
 	Topic *topicHandler = topicsList[topic];
 
 	if(topicHandler == NULL)
 	{
 		// Publisher not valid for unpublish
+		comMutex.Release();
 		return RealTime::fail;
 	}
 
@@ -894,7 +1986,7 @@ int LeaveTopic(Publisher* pubHandler){
 		RealTime::Heap::Free(topicHandler);
 	}
 
-	rt_mutex_release(&comMutex);
+	comMutex.Release();
 	return RealTime::ok;
 }
 
@@ -907,7 +1999,7 @@ int LeaveTopic(Publisher* pubHandler){
  * 		   - RealTime::fail otherwise.
  */
 int LeaveTopic(Subscriber* subHandler){
-	rt_mutex_acquire(&comMutex, TM_INFINITE);
+	comMutex.Acquire();
 
 	size_t topic = subHandler->GetTopic();
 
@@ -916,6 +2008,7 @@ int LeaveTopic(Subscriber* subHandler){
 	if(topicHandler == NULL)
 	{
 		// Subscriber not valid for unsubscribe
+		comMutex.Release();
 		return RealTime::fail;
 	}
 
@@ -932,31 +2025,140 @@ int LeaveTopic(Subscriber* subHandler){
 		RealTime::Heap::Free(topicHandler);
 	}
 
-	rt_mutex_release(&comMutex);
+	comMutex.Release();
 	return RealTime::ok;
 }
 
+/**
+ * @brief Get the local instance of a topic.
+ *
+ * @param topic - The topic identifier.
+ *
+ * @return - The topic instance if it is used in this executable;
+ * 		   - NULL otherwise.
+ */
+Topic* GetTopicHandler(size_t topic)
+{
+	return (topic < comMAX_TOPICS)? topicsList[topic] : NULL;
+}
+
+/**
+ * @brief Get an identifier for a new subscriber of a topic.
+ *
+ * @param topic - The topic instance.
+ *
+ * @return The smallest subscriber identifier not in use in the topic.
+ */
 size_t GetValidSubID(Topic* topic)
 {
-	size_t id;
+	return topic->GetFreeSubID();
+}
 
-	do
-	{
-		id = Timer::GetRandomValue();
-	}while(topic->HasSubID(id));
+/**
+ * @brief Get an identifier for a new publisher of a topic.
+ *
+ * @param topic - The topic instance.
+ *
+ * @return The smallest publisher identifier not in use in the topic.
+ */
+size_t GetValidPubID(Topic* topic)
+{
+	return topic->GetFreePubID();
+}
+
+/**
+ * @brief Merge the statistics of the local subscribers of a topic in topicStats.
+ *
+ * @param topic - A topic with a valid instance in topicsList.
+ */
+static void MergeTopicStats(size_t topic)
+{
+	topicStats.received = 0;
+	topicStats.dropped = 0;
+	topicStats.overwritten = 0;
+	topicStats.late = 0;
+	topicStats.lost = 0;
+	topicStats.reordered = 0;
+	topicStats.latencySum = 0;
+	topicStats.latency.Clear();
+	topicsList[topic]->MergeStats(&topicStats);
+}
 
-	return id;
+/**
+ * @brief Clear the message statistics of the subscribers of all the topics.
+ */
+void ClearStats(void)
+{
+	comMutex.Acquire();
+	for(size_t i = 0; i < comMAX_TOPICS; ++i)
+	{
+		if(topicsList[i] != NULL)
+		{
+			topicsList[i]->ClearStats();
+		}
+	}
+	comMutex.Release();
 }
 
-size_t GetValidPubID(Topic* topic)
+/**
+ * @brief Print the messages received, dropped, overwritten and late in
+ * 		  the local subscribers of each topic and, if the messages have
+ * 		  a header, the latency, lost and reordered messages.
+ */
+void PrintStats(void)
 {
-	size_t id;
-	do
+	double period = Timer::GetPeriod();
+
+	Stdout::Print("\nMessages in the subscribers:\n");
+	Stdout::Print("Topic\tReceived\tDropped\tOverwritten\tLate\tLost\tReordered\tExhausted\n");
+
+	comMutex.Acquire();
+	for(size_t i = 0; i < comMAX_TOPICS; ++i)
+	{
+		if(topicsList[i] == NULL)
+		{
+			continue;
+		}
+
+		MergeTopicStats(i);
+		if((topicStats.received + topicStats.dropped + topicStats.overwritten + topicsList[i]->GetExhaustedNumber()) == 0)
+		{
+			continue;
+		}
+
+		Stdout::Print("%d\t%d\t\t%d\t%d\t\t%d\t%d\t%d\t\t%d\n", i, topicStats.received,
+						topicStats.dropped, topicStats.overwritten, topicStats.late,
+						topicStats.lost, topicStats.reordered, topicsList[i]->GetExhaustedNumber());
+	}
+
+	if(useHeader)
 	{
-		id = Timer::GetRandomValue();
-	}while(topic->HasPubID(id));
+		Stdout::Print("\nMessages latency from publish to read:\n");
+		Stdout::Print("Topic\tAverage (s)\tp50 (s)\t\tp99 (s)\t\tp99.9 (s)\tMax (s)\n");
+
+		for(size_t i = 0; i < comMAX_TOPICS; ++i)
+		{
+			if(topicsList[i] == NULL)
+			{
+				continue;
+			}
+
+			MergeTopicStats(i);
+			if(topicStats.received == 0)
+			{
+				continue;
+			}
 
-	return id;
+			Stdout::Print("%d\t%f\t%f\t%f\t%f\t%f\n", i,
+							(topicStats.latencySum/period)/topicStats.received,
+							topicStats.latency.GetPercentile(50)/period,
+							topicStats.latency.GetPercentile(99)/period,
+							topicStats.latency.GetPercentile(99.9)/period,
+							topicStats.latency.GetPercentile(100)/period);
+		}
+	}
+	comMutex.Release();
+	Stdout::Print("\n");
 }
 
 void ClearAll(void)
@@ -37,13 +37,16 @@
 /*IMPLEMENTATION SPECIFIC INCLUDES*/
 /*=======================================================================================*/
 
-#include <alchemy/queue.h>
-#include <alchemy/heap.h>
-#include <alchemy/mutex.h>
 #include "stdio.h"
 #include "stdlib.h"
 #include "list.hpp"
 #include "rtheap.hpp"
+#include "rtqueue.hpp"
+#include "rtring.hpp"
+#include "rtpool.hpp"
+#include "idmap.hpp"
+#include "rtsignal.hpp"
+#include "histogram.hpp"
 
 namespace RealTime
 {
@@ -53,13 +56,109 @@ namespace RealTime
 
 #define comTOPIC_NAME	"topic_%d"
 
+// Comment comSHM_RING to exchange the topics messages by the Queue class,
+// i.e. RT_QUEUE in Xenomai, instead of the lock-free shared memory Ring class.
+// It must be equal in Master and Slave.
+#define comSHM_RING
+
+#define comMAX_SOURCES 8 /**< Publishers of a topic whose sequences are followed by each subscriber. */
+
+#define comMAX_TOPICS 4096 /**< The topic identifiers are smaller than it. */
+
+#define comPOOL_MAX_BLOCKS 65536 /**< Maximum number of shared messages of a topic. */
+#define comPOOL_SUB_BYTES 1048576 /**< Memory of the shared messages added to a topic pool by each subscriber, if less than its queue. */
+
 
 /*MODULE TYPES*/
 /*=======================================================================================*/
 
 typedef uint8_t message_t;
-typedef RT_QUEUE comQueue_t;
-typedef RT_MUTEX comMutex_t;
+#ifdef comSHM_RING
+typedef Ring comQueue_t;
+#else
+typedef Queue comQueue_t;
+#endif
+typedef Mutex comMutex_t;
+
+/**
+ * @brief The header of a message shared by all the local subscribers of a topic.
+ *
+ * 		  The message follows the header. Each subscriber receives a pointer to
+ * 		  the header and the buffer goes back to the heap when the last
+ * 		  subscriber releases it.
+ */
+typedef struct
+{
+	volatile uint32_t references; /**< Number of subscribers that didn't release the message yet. */
+	uint32_t length; /**< The message size in bytes. */
+	uint64_t reserved; /**< Keeps the message aligned to 8 bytes. */
+}sharedMessage_t;
+
+/**
+ * @brief The shared slot of a state topic, followed by its last sample.
+ *
+ * 		  It is a sequence lock: the publishers make the sequence odd while
+ * 		  they write the sample, so the subscribers copy the sample without
+ * 		  locking and retry if the sequence changed during the copy.
+ */
+typedef struct
+{
+	volatile uint32_t initState;
+	volatile uint32_t sequence; /**< Incremented twice by each sample written, 0 if none. */
+	uint32_t length; /**< The sample size in bytes. */
+	uint32_t capacity; /**< The maximum sample size in bytes. */
+}sharedState_t;
+
+/**
+ * @brief The optional header placed by the publishers before each message.
+ *
+ * 		  It is enabled by Communic::SetMessageHeader and is invisible to the
+ * 		  tasks, that see only the message after it.
+ */
+typedef struct
+{
+	timeCount_t publishTime; /**< When the message was published, in the publisher node clock. */
+	uint32_t sequence; /**< Counted by each publisher from 0. */
+	uint32_t publisherID;
+}messageHeader_t;
+
+/**
+ * @brief The last sequence received from a publisher.
+ */
+typedef struct
+{
+	uint32_t publisherID;
+	uint32_t expected; /**< The next sequence expected from the publisher. */
+}messageSource_t;
+
+/**
+ * @brief The transport statistics of the messages received by a subscriber, or of a topic.
+ */
+typedef struct
+{
+	uint32_t received;
+	uint32_t dropped; /**< New messages discarded because the subscriber queue was full. */
+	uint32_t overwritten; /**< Old messages discarded by newer ones before being read. */
+	uint32_t late; /**< Messages read after their lifespan. */
+	uint32_t lost; /**< Gaps in the sequences of the publishers. */
+	uint32_t reordered; /**< Messages received after a later one of the same publisher. */
+	timeCount_t latencySum;
+	Histogram latency; /**< From Publisher::Publish to Subscriber::Read. */
+	messageSource_t sources[comMAX_SOURCES];
+	uint32_t sourcesNumber;
+	uint32_t sourcesNext; /**< The source replaced by the next new publisher when all are taken, in round-robin. */
+}messageStats_t;
+
+/**
+ * @brief The quality of service of a subscription.
+ */
+typedef struct
+{
+	int overflow; /**< What is done when the queue is full: Communic::keepLast, Communic::dropNewest or Communic::blocking. */
+	uint32_t depth; /**< Number of messages kept for the subscriber. */
+	timeCount_t timeout; /**< Maximum time that the gatekeeper task waits for room in Communic::blocking. */
+	timeCount_t lifespan; /**< Age in the read after which a message is counted as late, or 0 to not check. Needs the message header. */
+}subscriberQoS_t;
 
 /*FUNCTIONS*/
 /*=======================================================================================*/
@@ -82,19 +181,45 @@ private:
 	size_t id; /**< An unique subscriber identifier. */
 	size_t topic; /**< Topic subscribed. */
 	size_t messageSize; /**< The message size expected to receive in the topic. */
-	RT_QUEUE queue; /**< A queue to buffer the incoming message to subscriber. */
+	int delivery; /**< The delivery mode of the topic. */
+	sharedState_t *state; /**< The topic slot in the state delivery. */
+	Pool *pool; /**< The topic pool of shared messages in the gatekeeper delivery. */
+	uint8_t *samples[2]; /**< The last sample read and the one being copied, in the state delivery. */
+	uint8_t current; /**< The index in samples of the last sample read. */
+	uint32_t stateSequence; /**< The slot sequence of the last sample read. */
+	comQueue_t queue; /**< A queue with the pointers of the incoming shared messages, or the topic queue in the direct delivery. */
+	volatile uint32_t pending; /**< Number of messages in the queue. */
+	sharedMessage_t ***putSlots; /**< The queue slots of the last messages put, used only in Communic::keepLast. */
+	uint32_t putNumber; /**< Number of messages put in the queue by the gatekeeper task. */
+	size_t headerSize; /**< Size of the messageHeader_t before each message, or 0 if disabled. */
+	messageStats_t stats;
+	subscriberQoS_t qos;
+	Semaphore room; /**< Free places in the queue, used only in Communic::blocking. */
+	uint32_t lostBase; /**< Messages lost by the topic queue before the statistics were cleared, in the direct delivery. */
 
 public:
-	Subscriber(size_t id, size_t topic, size_t msgSize);
+	Subscriber(size_t id, size_t topic, size_t msgSize, void *topicHandler, const subscriberQoS_t *qos);
 	~Subscriber(void);
 	int Init(void);
 	size_t GetTopic(void);
 	size_t GetID();
 	size_t GetMessageSize(void);
+	uint32_t GetCapacity(void);
 	size_t Receive(void *msg);
-	size_t PutMessage(void *msg);
+	size_t Receive(void *msg, timeCount_t timeout);
+	const void* Read(void);
+	const void* Read(timeCount_t timeout);
+	void Release(const void *msg);
+	size_t PutMessage(sharedMessage_t *msg);
+	messageStats_t* GetStats(void);
+	void ClearStats(void);
 	bool operator == (Subscriber &other);
 	bool operator == (size_t id);
+
+private:
+	void RecordHeader(const messageHeader_t *header);
+	void ReleaseShared(sharedMessage_t *sharedMsg);
+	uint32_t ReadState(void);
 };
 
 /**
@@ -112,6 +237,10 @@ private:
 	size_t id; /**< An unique publisher identifier. */
 	size_t messageSize; /**< The size of the message that is sent in the topic. */
 	comQueue_t *topicQueue; /**< The shared topic queue reference. */
+	int delivery; /**< The delivery mode of the topic. */
+	uint8_t *sample; /**< Where the sample is built before being written in the topic slot, in the state delivery. */
+	size_t headerSize; /**< Size of the messageHeader_t before each message, or 0 if disabled. */
+	uint32_t sequence; /**< Sequence of the next message published. */
 public:
 	Publisher(size_t id, size_t topic, size_t msgSize, void *topicHandler);
 	~Publisher(void);
@@ -120,6 +249,8 @@ public:
 	size_t GetID();
 	size_t GetMessageSize(void);
 	size_t Send(void *msg);
+	void* Loan(void);
+	size_t Publish(void *msg);
 	bool operator == (Publisher &other);
 	bool operator == (size_t id);
 };
@@ -138,19 +269,29 @@ private:
 	uint32_t messageLen; /**< The size of the message that is sent in the topic. */
 	List<RealTime::Subscriber, size_t> subsList; /**< The list of subscribers instances related to the topic. Each key in the list is an instance identifier. */
 	List<RealTime::Publisher, size_t> pubsList;  /**< The list of publishers instances related to the topic. Each key in the list is an instance identifier. */
-	uint8_t topicID; /**< An unique topic identifier. */
-	uint8_t pubNumber; /**< The number of publishers instances related to the topic. */
-	uint8_t subNumber; /**< The number of subscribers instances related to the topic. */
-	RT_HEAP heap;
+	IdMap<RealTime::Subscriber> subsMap; /**< The subscribers instances by identifier. */
+	IdMap<RealTime::Publisher> pubsMap; /**< The publishers instances by identifier. */
+	size_t topicID; /**< An unique topic identifier. */
+	uint32_t pubNumber; /**< The number of publishers instances related to the topic. */
+	uint32_t subNumber; /**< The number of subscribers instances related to the topic. */
+	size_t cpu; /**< The processor of the gatekeeper task. */
+	int delivery; /**< Communic::gatekeeper, Communic::direct or Communic::state. */
+	LocalHeap heap; /**< Shared memory with the number of tasks using the topic in all nodes. */
 	comQueue_t queue; /**< The topic queue that is shared with publishers and gatekeeper topic tasks. */
+	LocalHeap stateHeap; /**< Shared memory with the topic slot in the state delivery. */
+	sharedState_t *state; /**< The topic slot in the state delivery, or NULL. */
+	Pool pool; /**< The shared messages given to the subscribers in the gatekeeper delivery. */
+	volatile uint32_t exhausted; /**< Messages not sent because no buffer was free. */
+	uint32_t poolDemand; /**< Shared messages needed by the subscribers added to the topic. */
 	comMutex_t mutex; /**< Protected critical sessions in topic services. */
 
 public:
 	Task* topicTask;
-	Topic(uint8_t topic, size_t messageSize);
+	Topic(size_t topic, size_t messageSize, size_t cpu, int delivery);
 	~Topic(void);
 	int Init();
 	size_t GetTopicID(void);
+	int GetDelivery(void);
 	size_t AddSubscriber(Subscriber* sub);
 	size_t AddPublisher(Publisher* pub);
 	size_t RemoveSubscriber(Subscriber* sub);
@@ -161,12 +302,26 @@ public:
 	message_t * GetFromQueue(void);
 	void ReleaseQueue(message_t* queuePointer);
 	comQueue_t * GetQueue(void);
+	sharedState_t * GetState(void);
+	Pool * GetPool(void);
+	void CountExhausted(void);
+	uint32_t GetExhaustedNumber(void);
+	int WriteState(const void *msg, size_t size);
+	int Deliver(const void *msg, size_t size);
 	bool operator == (Topic &other);
 	bool operator == (size_t topicID);
 	bool HasSubID(size_t id);
 	bool HasPubID(size_t id);
+	size_t GetFreeSubID(void);
+	size_t GetFreePubID(void);
+	Subscriber* GetSubscriber(size_t id);
+	Publisher* GetPublisher(size_t id);
+	void MergeStats(messageStats_t *total);
+	void ClearStats(void);
 
 private:
+	int CreateMessages(const char *name);
+	int BindMessages(const char *name);
 	size_t SendMessages(void);
 	friend taskFUNCTION(TopicTaskFunc, args);
 };
@@ -175,16 +330,24 @@ private:
  * @brief Namespace related to the communication subsytem services.
  */
 namespace Communic{
-	static const uint8_t  maxTasks = 30;
-	static const uint8_t  maxTasksPerTopic = 5;
-	static const uint8_t  maxTopics = 20;
-	static const uint8_t  minTasksID = 50;
-	static const uint8_t  maxTasksID = minTasksID+maxTasks;
+	static const size_t maxTopics = comMAX_TOPICS;
+	static const int gatekeeper = 0; /**< A gatekeeper task copies each message of the topic to the subscribers queues. */
+	static const int direct = 1; /**< The subscribers read the messages from the topic queue, woken by the publisher. */
+	static const int state = 2; /**< The subscribers read the last sample from a topic slot, without waiting or queueing. */
+	static const size_t allTopics = 0xFFFF; /**< Used in SetDelivery to set every topic. */
+	static const int keepLast = 0; /**< A full subscriber queue discards its oldest message, so the last ones are read. */
+	static const int dropNewest = 1; /**< A full subscriber queue discards the new message (default). */
+	static const int blocking = 2; /**< The gatekeeper task waits for room in a full subscriber queue, up to a timeout. */
 
 	int Init(void);
-	Subscriber* SubscribingRequest(size_t topic, uint64_t msgSize);
+	int SetDelivery(size_t topic, int mode);
+	void SetMessageHeader(bool enable);
+	size_t GetHeaderSize(void);
+	void ClearStats(void);
+	void PrintStats(void);
+	Subscriber* SubscribingRequest(size_t topic, uint64_t msgSize, size_t cpu = Task::anyCPU, const subscriberQoS_t *qos = NULL);
 	int LeaveTopic(Subscriber* subHandler);
-	Publisher* PublishingRequest(size_t topic, uint64_t msgSize);
+	Publisher* PublishingRequest(size_t topic, uint64_t msgSize, size_t cpu = Task::anyCPU);
 	int LeaveTopic(Publisher* pubHandler);
 	Topic* GetTopicHandler(size_t topic);
 	size_t GetValidSubID(Topic* topic);
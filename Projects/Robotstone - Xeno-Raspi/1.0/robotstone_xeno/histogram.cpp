@@ -0,0 +1,210 @@
+/**
+ * @file	histogram.cpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the implementation of the Histogram class,
+ * which records the distribution of time measurements in a fixed memory.
+ */
+
+#include "histogram.hpp"
+#include <string.h>
+
+/**
+ * @brief Histogram class constructor.
+ *
+ */
+Histogram::Histogram(void)
+{
+	this->Clear();
+}
+
+/**
+ * @brief Discard all the recorded values.
+ *
+ */
+void Histogram::Clear(void)
+{
+	memset(this->counts, 0, sizeof(this->counts));
+	this->totalCount = 0;
+	this->maxValue = 0;
+}
+
+/**
+ * @brief Get the number of recorded values.
+ *
+ * @return The number of recorded values.
+ */
+uint32_t Histogram::GetTotalCount(void)
+{
+	return this->totalCount;
+}
+
+/**
+ * @brief Add the values recorded in another histogram to this one.
+ *
+ * @param other - The histogram added.
+ */
+void Histogram::Add(const Histogram &other)
+{
+	for(uint32_t i = 0; i < countsLength; ++i)
+	{
+		this->counts[i] += other.counts[i];
+	}
+	this->totalCount += other.totalCount;
+	if(other.maxValue > this->maxValue)
+	{
+		this->maxValue = other.maxValue;
+	}
+}
+
+/**
+ * @brief Copy the recorded values to a compact histogram.
+ *
+ * 		  The non-empty positions are kept while they fit in histCOMPACT_BINS.
+ * 		  Otherwise the neighbour positions are merged in the highest one, doubling
+ * 		  the merged width until they fit, so the percentiles of the copy are never
+ * 		  below the ones of this histogram.
+ *
+ * @param compact - Where the histogram is copied.
+ */
+void Histogram::Export(compactHistogram_t *compact)
+{
+	uint32_t mask = 0;
+	uint32_t number, last;
+
+	while(true)
+	{
+		number = 0;
+		last = Histogram::countsLength;
+		for(uint32_t i = 0; i < Histogram::countsLength; ++i)
+		{
+			if((this->counts[i] != 0) && ((i | mask) != last))
+			{
+				last = i | mask;
+				number++;
+			}
+		}
+		if(number <= histCOMPACT_BINS)
+		{
+			break;
+		}
+		mask = (mask << 1) | 1;
+	}
+
+	memset(compact, 0, sizeof(compactHistogram_t));
+	compact->maxValue = this->maxValue;
+	last = Histogram::countsLength;
+	for(uint32_t i = 0; i < Histogram::countsLength; ++i)
+	{
+		if(this->counts[i] == 0)
+		{
+			continue;
+		}
+		if((i | mask) != last)
+		{
+			last = i | mask;
+			compact->bins[compact->number].index = (uint16_t)last;
+			compact->number++;
+		}
+		compact->bins[compact->number - 1].count += this->counts[i];
+	}
+}
+
+/**
+ * @brief Replace the recorded values by the ones of a compact histogram.
+ *
+ * @param compact - The copy made by Histogram::Export.
+ */
+void Histogram::Import(const compactHistogram_t *compact)
+{
+	this->Clear();
+	for(uint32_t i = 0; (i < compact->number) && (i < histCOMPACT_BINS); ++i)
+	{
+		if(compact->bins[i].index < Histogram::countsLength)
+		{
+			this->counts[compact->bins[i].index] += compact->bins[i].count;
+			this->totalCount += compact->bins[i].count;
+		}
+	}
+	this->maxValue = compact->maxValue;
+}
+
+/**
+ * @brief Get the value below which a percentage of the recorded values fall.
+ *
+ * @param percentile - The percentage, from 0 to 100 (e.g. 99.9).
+ *
+ * @return The highest value equivalent to the percentile bucket, limited
+ * 		   by the maximum recorded value, or 0 if the histogram is empty.
+ */
+RealTime::timeCount_t Histogram::GetPercentile(double percentile)
+{
+	uint64_t target, cumulative = 0;
+	RealTime::timeCount_t value;
+
+	if(this->totalCount == 0)
+	{
+		return 0;
+	}
+
+	target = (uint64_t)((percentile/100.0)*((double)this->totalCount) + 0.5);
+	if(target == 0)
+	{
+		target = 1;
+	}
+
+	for(uint32_t i = 0; i < Histogram::countsLength; ++i)
+	{
+		cumulative += this->counts[i];
+		if(cumulative >= target)
+		{
+			value = Histogram::GetHighestEquivalent(i);
+			return (value < this->maxValue)? value : this->maxValue;
+		}
+	}
+
+	return this->maxValue;
+}
+
+/**
+ * @brief Get the highest value recorded in a histogram position.
+ *
+ * @param index - The position in the counts array.
+ *
+ * @return The highest value of the position.
+ */
+RealTime::timeCount_t Histogram::GetHighestEquivalent(uint32_t index)
+{
+	uint32_t shift;
+	RealTime::timeCount_t subBucket;
+
+	if(index < (2*Histogram::subBucketHalf))
+	{
+		return index;
+	}
+
+	shift = index/Histogram::subBucketHalf - 1;
+	subBucket = index%Histogram::subBucketHalf + Histogram::subBucketHalf;
+
+	return ((subBucket + 1) << shift) - 1;
+}
+
+/***************************************************************************************
+ * END: Module - histogram.cpp
+ ***************************************************************************************/
@@ -0,0 +1,131 @@
+/**
+ * @file	histogram.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the implementation of the Histogram class,
+ * which records the distribution of time measurements in a fixed memory.
+ */
+
+#ifndef HISTOGRAM_MACRO_HPP
+#define HISTOGRAM_MACRO_HPP
+
+/*MODULE INCLUDES*/
+/*=======================================================================================*/
+#include <stdint.h>
+#include "timer.hpp"
+
+/*MACROS*/
+/*=======================================================================================*/
+
+#define histCOMPACT_BINS 64 /**< Positions kept in a compactHistogram_t. */
+
+/*MODULE TYPES*/
+/*=======================================================================================*/
+
+/**
+ * @brief A non-empty position of a histogram.
+ */
+typedef struct
+{
+	uint16_t index; /**< The position in the counts array. */
+	uint16_t reserved;
+	uint32_t count;
+}histogramBin_t;
+
+/**
+ * @brief A copy of a histogram in a small fixed memory, made by Histogram::Export
+ * 		  to be sent to another node and read back by Histogram::Import.
+ */
+typedef struct
+{
+	RealTime::timeCount_t maxValue;
+	uint32_t number; /**< Number of bins used. */
+	uint32_t reserved;
+	histogramBin_t bins[histCOMPACT_BINS];
+}compactHistogram_t;
+
+/*CLASSES*/
+/*=======================================================================================*/
+
+/**
+ * @brief Log-linear histogram of time values, in the same way of the HdrHistogram.
+ *
+ * 		  The values below 2^subBucketBits are recorded exactly. The bigger values are
+ * 		  grouped by its most significant bit in buckets with 2^(subBucketBits-1) linear
+ * 		  sub-buckets, so the recorded value keeps a relative error below 1/2^(subBucketBits-1).
+ * 		  All the memory is inside the instance and recording doesn't allocate or lock.
+ */
+class Histogram
+{
+public:
+	static const uint32_t subBucketBits = 7;
+	static const uint32_t subBucketHalf = 1 << (subBucketBits - 1); /**< Linear sub-buckets in each bucket. */
+	static const uint32_t countsLength = (64 - subBucketBits + 2)*subBucketHalf; /**< Enough to cover all the 64 bits values. */
+private:
+	uint32_t counts[countsLength];
+	uint32_t totalCount;
+	RealTime::timeCount_t maxValue;
+public:
+	Histogram(void);
+	void Clear(void);
+	RealTime::timeCount_t GetPercentile(double percentile);
+	uint32_t GetTotalCount(void);
+	void Add(const Histogram &other);
+	void Export(compactHistogram_t *compact);
+	void Import(const compactHistogram_t *compact);
+
+	/**
+	 * @brief Record a value in the histogram.
+	 *
+	 * 		  It is called in every task activation, so it only
+	 * 		  does a bit scan, a shift and an increment.
+	 *
+	 * @param value - The value in implementation specific units.
+	 */
+	inline void Record(RealTime::timeCount_t value)
+	{
+		uint32_t index;
+
+		if(value < (2*subBucketHalf))
+		{
+			index = (uint32_t)value;
+		}
+		else
+		{
+			// The shift keeps the value between subBucketHalf and 2*subBucketHalf - 1.
+			uint32_t shift = (63 - __builtin_clzll(value)) - (subBucketBits - 1);
+			index = (shift + 1)*subBucketHalf + (uint32_t)(value >> shift) - subBucketHalf;
+		}
+
+		this->counts[index]++;
+		this->totalCount++;
+		if(value > this->maxValue)
+		{
+			this->maxValue = value;
+		}
+	}
+
+private:
+	static RealTime::timeCount_t GetHighestEquivalent(uint32_t index);
+};
+
+#endif // HISTOGRAM_MACRO_HPP
+/***************************************************************************************
+ * END: Module - histogram.hpp
+ ***************************************************************************************/
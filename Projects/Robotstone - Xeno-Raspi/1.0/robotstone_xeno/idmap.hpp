@@ -0,0 +1,259 @@
+/**
+ * @file	idmap.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the IdMap class implementation, a table of objects
+ * indexed by small identifiers, which are given by a bitmap of the
+ * identifiers in use.
+ */
+
+#ifndef RT_IDMAP_HPP_
+#define RT_IDMAP_HPP_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "rtheap.hpp"
+
+namespace RealTime
+{
+
+/**
+ * @brief Class that keeps objects by identifier, with constant time lookup.
+ *
+ * 		  The free identifiers are found in a bitmap, one bit by identifier,
+ * 		  so the smallest free one is given and the table stays dense.
+ * 		  The table grows when all the identifiers are in use. It is not
+ * 		  protected against concurrent changes.
+ */
+template<class T>
+class IdMap
+{
+private:
+	static const size_t wordBits = 32;
+	uint32_t *bitmap; /**< One bit by identifier, set if the identifier is in use. */
+	T **values; /**< The object of each identifier. */
+	size_t capacity; /**< Number of identifiers in the table, a multiple of wordBits. */
+	size_t count; /**< Number of identifiers in use. */
+	size_t hint; /**< The first bitmap word that may have a free identifier. */
+public:
+	IdMap(void);
+	~IdMap(void);
+	size_t GetFree(void);
+	bool Insert(size_t id, T *value);
+	T* Remove(size_t id);
+	T* Get(size_t id);
+	bool Has(size_t id);
+	size_t GetCount(void);
+
+private:
+	bool Grow(size_t minCapacity);
+};
+
+/**
+ * @brief IdMap class constructor. The table is allocated in the first insertion.
+ */
+template<class T>
+IdMap<T>::IdMap(void):
+		bitmap(NULL), values(NULL), capacity(0), count(0), hint(0)
+{
+
+}
+
+/**
+ * @brief IdMap class destructor. The objects are not deleted.
+ */
+template<class T>
+IdMap<T>::~IdMap(void)
+{
+	if(this->bitmap != NULL)
+	{
+		Heap::Free(this->bitmap);
+		Heap::Free(this->values);
+	}
+}
+
+/**
+ * @brief Get the smallest identifier not in use. It is taken only by IdMap::Insert.
+ *
+ * @return The identifier, which may be beyond the actual table.
+ */
+template<class T>
+size_t IdMap<T>::GetFree(void)
+{
+	size_t words = this->capacity/IdMap::wordBits;
+
+	for(; this->hint < words; ++this->hint)
+	{
+		if(this->bitmap[this->hint] != 0xFFFFFFFF)
+		{
+			return this->hint*IdMap::wordBits + __builtin_ctz(~this->bitmap[this->hint]);
+		}
+	}
+	return this->capacity;
+}
+
+/**
+ * @brief Put an object in an identifier, growing the table if needed.
+ *
+ * @param id - An identifier not in use, usually given by IdMap::GetFree.
+ * @param value - The object.
+ *
+ * @return - true if success;
+ * 		   - false if the identifier is in use or there is no memory.
+ */
+template<class T>
+bool IdMap<T>::Insert(size_t id, T *value)
+{
+	if((id >= this->capacity) && !this->Grow(id + 1))
+	{
+		return false;
+	}
+	if(this->Has(id))
+	{
+		return false;
+	}
+
+	this->bitmap[id/IdMap::wordBits] |= (uint32_t)1 << (id % IdMap::wordBits);
+	this->values[id] = value;
+	this->count++;
+	return true;
+}
+
+/**
+ * @brief Give back an identifier.
+ *
+ * @param id - The identifier.
+ *
+ * @return The object of the identifier, or NULL if it was not in use.
+ */
+template<class T>
+T* IdMap<T>::Remove(size_t id)
+{
+	T *value;
+
+	if(!this->Has(id))
+	{
+		return NULL;
+	}
+
+	value = this->values[id];
+	this->bitmap[id/IdMap::wordBits] &= ~((uint32_t)1 << (id % IdMap::wordBits));
+	this->values[id] = NULL;
+	this->count--;
+
+	if((id/IdMap::wordBits) < this->hint)
+	{
+		this->hint = id/IdMap::wordBits;
+	}
+	return value;
+}
+
+/**
+ * @brief Get the object of an identifier.
+ *
+ * @param id - The identifier.
+ *
+ * @return The object, or NULL if the identifier is not in use.
+ */
+template<class T>
+T* IdMap<T>::Get(size_t id)
+{
+	return (id < this->capacity)? this->values[id] : NULL;
+}
+
+/**
+ * @brief Indicates if an identifier is in use.
+ *
+ * @param id - The identifier.
+ *
+ * @return true if the identifier is in use and false otherwise.
+ */
+template<class T>
+bool IdMap<T>::Has(size_t id)
+{
+	return (id < this->capacity) &&
+		   ((this->bitmap[id/IdMap::wordBits] >> (id % IdMap::wordBits)) & 1);
+}
+
+/**
+ * @brief Get the number of identifiers in use.
+ *
+ * @return The number of identifiers.
+ */
+template<class T>
+size_t IdMap<T>::GetCount(void)
+{
+	return this->count;
+}
+
+/**
+ * @brief Double the table until it has a given number of identifiers.
+ *
+ * @param minCapacity - The number of identifiers needed.
+ *
+ * @return - true if success;
+ * 		   - false if there is no memory, keeping the actual table.
+ */
+template<class T>
+bool IdMap<T>::Grow(size_t minCapacity)
+{
+	size_t newCapacity = (this->capacity == 0)? IdMap::wordBits : this->capacity;
+	uint32_t *newBitmap;
+	T **newValues;
+
+	while(newCapacity < minCapacity)
+	{
+		newCapacity *= 2;
+	}
+
+	newBitmap = (uint32_t *)Heap::Alloc(newCapacity/IdMap::wordBits*sizeof(uint32_t));
+	newValues = (T **)Heap::Alloc(newCapacity*sizeof(T *));
+	if((newBitmap == NULL) || (newValues == NULL))
+	{
+		if(newBitmap != NULL)
+		{
+			Heap::Free(newBitmap);
+		}
+		if(newValues != NULL)
+		{
+			Heap::Free(newValues);
+		}
+		return false;
+	}
+
+	memset(newBitmap, 0, newCapacity/IdMap::wordBits*sizeof(uint32_t));
+	memset(newValues, 0, newCapacity*sizeof(T *));
+
+	if(this->bitmap != NULL)
+	{
+		memcpy(newBitmap, this->bitmap, this->capacity/IdMap::wordBits*sizeof(uint32_t));
+		memcpy(newValues, this->values, this->capacity*sizeof(T *));
+		Heap::Free(this->bitmap);
+		Heap::Free(this->values);
+	}
+
+	this->bitmap = newBitmap;
+	this->values = newValues;
+	this->capacity = newCapacity;
+	return true;
+}
+}
+
+#endif /* RT_IDMAP_HPP_ */
@@ -32,7 +32,6 @@
 #ifndef LIST_HPP_
 #define LIST_HPP_
 
-#include "alchemy/heap.h"
 #include <stdio.h>
 #include "test_led.hpp"
 #include "rtheap.hpp"
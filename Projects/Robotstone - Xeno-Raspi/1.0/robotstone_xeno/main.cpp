@@ -1,26 +1,95 @@
 // Comment IS_MASTER if you want compile code for Slave node
 // Uncomment IS_MASTER if you want compile code for Master node
+// Uncomment IS_COMMBENCH if you want compile the Communic micro-benchmark, instead of a node
 
 #define IS_MASTER
-#ifdef IS_MASTER
+//#define IS_COMMBENCH
+#if defined(IS_COMMBENCH)
+
+#include "commbench.hpp"
+#include "realtime.hpp"
+
+int main(void){
+
+	RealTime::Init();
+
+	CommBench bench(benchRESULT_FILE);
+
+	bench.Run();
+}
+
+#elif defined(IS_MASTER)
 
 #include "RobotMaster.hpp"
 #include <iostream>
 #include "realtime.hpp"
+#include <stdlib.h>
+#include <string.h>
 
 using namespace std;
 
 int main(int argc, char* argv[]){
 
 	int expID;
+	int slaves = 1;
 
 	RealTime::Init();
+
+	// The optional argument is the number of processors of the partitioned multicore mode.
+	if((argc > 1) && (RealTime::SetExecCPUS(atoi(argv[1])) != RealTime::ok))
+	{
+		Stdout::Print("Invalid number of processors: %s.\n", argv[1]);
+		return 1;
+	}
+
+	// The next arguments are the addresses of the Slave nodes, when they run in other machines,
+	// the Slave n in the order of the arguments. Otherwise the optional argument is the number
+	// of Slaves in the same machine.
+	if((argc > 2) && (strchr(argv[2], '.') != NULL))
+	{
+		RealTime::Heap::SetNodeName("master");
+		slaves = argc - 2;
+		if((slaves > robotMAX_SLAVES) ||
+		   (RealTime::Network::Init(Robotstone::masterNode, robotNET_MASTER_PORT) != RealTime::ok))
+		{
+			Stdout::Print("Invalid number of Slaves: %d (maximum of %d).\n", slaves, robotMAX_SLAVES);
+			return 1;
+		}
+		for(int i = 0; i < slaves; ++i)
+		{
+			if(RealTime::Network::AddPeer(argv[i + 2], robotNET_SLAVE_PORT + i*robotNET_SLAVE_STRIDE) != RealTime::ok)
+			{
+				Stdout::Print("Invalid Slave address: %s.\n", argv[i + 2]);
+				return 1;
+			}
+		}
+	}
+	else if(argc > 2)
+	{
+		slaves = atoi(argv[2]);
+		if((slaves < 1) || (slaves > robotMAX_SLAVES))
+		{
+			Stdout::Print("Invalid number of Slaves: %s (from 1 to %d).\n", argv[2], robotMAX_SLAVES);
+			return 1;
+		}
+	}
+
 	RobotMaster bench;
 
+	bench.SetSlaves(slaves);
+
 	Stdout::Print("Insert Experiment ID + ENTER: 1 to 7\n");
+	Stdout::Print("Or insert s + Experiment ID + ENTER (e.g. s1) to search the breakdown step.\n");
+	Stdout::Print("Or press c + ENTER to get the raw speed of each processor.\n");
 	Stdout::Print("Or press any other key to get processor raw speed.\n");
 
-		expID = getchar();getchar();
+		expID = getchar();
+		if(expID == 's')
+		{
+			bench.SetSearchMode(true);
+			expID = getchar();
+		}
+		getchar();
 		switch(expID)
 		{
 		case '1':
@@ -44,6 +113,9 @@ int main(int argc, char* argv[]){
 		case '7':
 			bench.RequestExperiment(Robotstone::exp7);
 			break;
+		case 'c':
+			bench.RequestExperiment(Robotstone::calculateCoreSpeed);
+			break;
 		default:
 			bench.RequestExperiment(Robotstone::calculateRawSpeed);
 		}
@@ -54,14 +126,54 @@ int main(int argc, char* argv[]){
 #include "RobotSlave.hpp"
 #include <iostream>
 #include "realtime.hpp"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
 
 using namespace std;
 
 int main(int argc, char* argv[]){
 
+	const char *master = NULL;
+	int node = 1;
+	char name[sizeof("slave") + 8];
+
 	RealTime::Init();
 
-	RobotSlave bench;
+	// The optional arguments are the address of the Master node, when it runs in another
+	// machine, and the number of this Slave, from 1 to the number of Slaves given to the Master.
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strchr(argv[i], '.') != NULL)
+		{
+			master = argv[i];
+		}
+		else
+		{
+			node = atoi(argv[i]);
+		}
+	}
+
+	if((node < 1) || (node > robotMAX_SLAVES))
+	{
+		RealTime::Stdout::Print("Invalid Slave number: %d (from 1 to %d).\n", node, robotMAX_SLAVES);
+		return 1;
+	}
+
+	if(master != NULL)
+	{
+		// Each Slave has its own shared memory names and ports, so more than one may run in a machine.
+		snprintf(name, sizeof(name), "slave%d", node);
+		RealTime::Heap::SetNodeName(name);
+		if((RealTime::Network::Init(node, robotNET_SLAVE_PORT + (node - 1)*robotNET_SLAVE_STRIDE) != RealTime::ok) ||
+		   (RealTime::Network::AddPeer(master, robotNET_MASTER_PORT) != RealTime::ok))
+		{
+			RealTime::Stdout::Print("Invalid Master address: %s.\n", master);
+			return 1;
+		}
+	}
+
+	RobotSlave bench(node);
 
 	bench.Start();
 }
@@ -0,0 +1,601 @@
+/**
+ * @file	network.cpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the UDP transport of the topics, used when the
+ * Master and the Slave run in different nodes. Each topic has its own
+ * port, and the messages received from the other node are delivered to the
+ * local topic by a receive task, so the publishers and subscribers
+ * work as in a single node.
+ */
+
+/*MODULE INCLUDES*/
+/*=======================================================================================*/
+#include "network.hpp"
+#include "realtime.hpp"
+#include "task.hpp"
+#include "stdout.hpp"
+#include <string.h>
+#include <new>
+
+/*IMPLEMENTATION SPECIFIC INCLUDES*/
+/*=======================================================================================*/
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/*MACROS*/
+/*=======================================================================================*/
+#define netMAX_TOPICS		256 /**< Each topic has its own port, so only the first topics are exchanged. */
+#define netFRAGMENT_SIZE	1448 /**< Message bytes in each datagram, so it fits an Ethernet frame. */
+#define netSOCKET_BUFFER	8388608 /**< Receive buffer of each topic socket in bytes. */
+#define netPOLL_TIMEOUT		100 /**< Time in ms to look for new topics sockets. */
+#define netTASK_PRIORITY	90 /**< The same of the topics gatekeeper tasks. */
+#define netTASK_ID			999
+#define netMAX_NODES		timerMAX_PEERS /**< The node numbers are smaller than it, so their clocks are estimated by Timer. */
+
+namespace RealTime
+{
+
+/*MODULE TYPES*/
+/*=======================================================================================*/
+
+/**
+ * @brief The transport state of a topic in this node.
+ */
+typedef struct
+{
+	volatile int socket; /**< Bound to the topic port, or -1 if the topic is not used. */
+	Topic *handler; /**< The local topic, where the received messages are delivered. */
+	size_t messageSize;
+	volatile uint32_t sendSequence;
+	uint32_t expected[netMAX_NODES]; /**< The next sequence expected from each node. */
+	bool isSynced[netMAX_NODES]; /**< Indicates that a message was received from the node, so its expected is valid. */
+	uint8_t *assembly; /**< Buffer of the fragmented messages. */
+	uint32_t assemblySequence;
+	uint16_t assemblyNode; /**< The sender of the message being received. */
+	uint32_t assemblyBytes; /**< Bytes of the message received, or 0 if no message is being received. */
+	netStats_t stats;
+}netTopic_t;
+
+namespace Network
+{
+
+static netTopic_t *topics[netMAX_TOPICS];
+static bool isEnabled = false;
+static struct sockaddr_in peers[netMAX_NODES]; /**< The address of each other node. */
+static uint16_t peerBases[netMAX_NODES]; /**< The port of the topic 0 in each other node. */
+static size_t peersNumber = 0;
+static uint16_t localNode; /**< The number of this node, sent in each datagram. */
+static uint16_t localBase;
+static uint8_t receiveBuffer[sizeof(netHeader_t) + netFRAGMENT_SIZE];
+static Task *receiveTask = NULL;
+
+/*FUNCTIONS*/
+/*=======================================================================================*/
+
+/**
+ * @brief Clear the statistics of a topic.
+ *
+ * @param stats - The topic statistics.
+ */
+static void ClearTopicStats(netStats_t *stats)
+{
+	stats->sent = 0;
+	stats->received = 0;
+	stats->lost = 0;
+	stats->reordered = 0;
+	stats->errors = 0;
+	stats->latencySum = 0;
+	stats->sendSum = 0;
+	stats->latency.Clear();
+}
+
+/**
+ * @brief Deliver a complete message received from another node to the local topic.
+ *
+ * 		  The times given by the other node are converted to the local clock
+ * 		  by the estimate of Timer::FromPeerTime, including the publishing
+ * 		  time in the message header, so the local subscribers measure the
+ * 		  latency as for a message published in the same node.
+ *
+ * @param entry - The topic transport state.
+ * @param header - The header of the last datagram of the message.
+ * @param msg - The message.
+ */
+static void Deliver(netTopic_t *entry, netHeader_t *header, uint8_t *msg)
+{
+	timeCount_t now = Timer::GetTime();
+	timeCount_t sendTime = Timer::FromPeerTime(header->sendTime, header->node);
+	int32_t distance;
+
+	// Each sender node counts its own sequences.
+	if(!entry->isSynced[header->node])
+	{
+		entry->expected[header->node] = header->sequence;
+		entry->isSynced[header->node] = true;
+	}
+
+	distance = (int32_t)(header->sequence - entry->expected[header->node]);
+	if(distance >= 0)
+	{
+		entry->stats.lost += distance;
+		entry->expected[header->node] = header->sequence + 1;
+	}
+	else
+	{
+		entry->stats.reordered++;
+	}
+	entry->stats.received++;
+
+	now = (now > sendTime)? now - sendTime : 0;
+	entry->stats.latencySum += now;
+	entry->stats.latency.Record(now);
+
+	// The message may not be aligned in the datagram buffer, so the header is copied.
+	if((Communic::GetHeaderSize() != 0) && (header->length >= sizeof(messageHeader_t)))
+	{
+		messageHeader_t msgHeader;
+
+		memcpy(&msgHeader, msg, sizeof(msgHeader));
+		msgHeader.publishTime = Timer::FromPeerTime(msgHeader.publishTime, header->node);
+		memcpy(msg, &msgHeader, sizeof(msgHeader));
+	}
+
+	if(entry->handler->Deliver(msg, header->length) != RealTime::ok)
+	{
+		entry->stats.errors++;
+	}
+}
+
+/**
+ * @brief Receive all the datagrams waiting in the socket of a topic.
+ *
+ * @param entry - The topic transport state.
+ * @param topic - The topic identifier.
+ */
+static void ReceiveDatagrams(netTopic_t *entry, size_t topic)
+{
+	netHeader_t *header = (netHeader_t *)receiveBuffer;
+	uint8_t *fragment = receiveBuffer + sizeof(netHeader_t);
+	ssize_t size;
+
+	for(;;)
+	{
+		size = recv(entry->socket, receiveBuffer, sizeof(receiveBuffer), MSG_DONTWAIT);
+		if(size < 0)
+		{
+			return;
+		}
+		size -= sizeof(netHeader_t);
+
+		if((size < 0) || (header->topic != topic) || (header->node >= netMAX_NODES) ||
+		   (header->length > entry->messageSize) || ((header->offset + size) > header->length))
+		{
+			entry->stats.errors++;
+			continue;
+		}
+
+		if((size_t)size == header->length)
+		{
+			Deliver(entry, header, fragment);
+			continue;
+		}
+
+		if(entry->assembly == NULL)
+		{
+			entry->stats.errors++;
+			continue;
+		}
+
+		if((entry->assemblyBytes == 0) || (header->node != entry->assemblyNode) ||
+		   (header->sequence != entry->assemblySequence))
+		{
+			// A fragment of a message older than the one being received is late.
+			if((entry->assemblyBytes != 0) && (header->node == entry->assemblyNode) &&
+			   ((int32_t)(header->sequence - entry->assemblySequence) < 0))
+			{
+				continue;
+			}
+			// The incomplete message is lost. The big messages of different
+			// nodes are not received at the same time by the benchmark.
+			entry->assemblySequence = header->sequence;
+			entry->assemblyNode = header->node;
+			entry->assemblyBytes = 0;
+		}
+
+		memcpy(entry->assembly + header->offset, fragment, size);
+		entry->assemblyBytes += size;
+
+		if(entry->assemblyBytes >= header->length)
+		{
+			entry->assemblyBytes = 0;
+			Deliver(entry, header, entry->assembly);
+		}
+	}
+}
+
+/**
+ * @brief The receive task of the node. It waits datagrams in the sockets
+ * 		  of all topics and delivers the messages to the local topics.
+ */
+taskFUNCTION(NetReceiveFunc, arg)
+{
+	struct pollfd fds[netMAX_TOPICS];
+	uint16_t fdsTopic[netMAX_TOPICS];
+	nfds_t fdsNumber;
+
+	(void)arg;
+
+	for(;;)
+	{
+		// The topics may be added while the experiment is initialized.
+		fdsNumber = 0;
+		for(size_t i = 0; i < netMAX_TOPICS; ++i)
+		{
+			if((topics[i] != NULL) && (topics[i]->socket >= 0))
+			{
+				fds[fdsNumber].fd = topics[i]->socket;
+				fds[fdsNumber].events = POLLIN;
+				fdsTopic[fdsNumber] = i;
+				fdsNumber++;
+			}
+		}
+
+		if(poll(fds, fdsNumber, netPOLL_TIMEOUT) <= 0)
+		{
+			continue;
+		}
+
+		for(nfds_t i = 0; i < fdsNumber; ++i)
+		{
+			if(fds[i].revents & POLLIN)
+			{
+				ReceiveDatagrams(topics[fdsTopic[i]], fdsTopic[i]);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Enable the UDP transport of the topics and start the receive task.
+ *
+ * 		  It must be called before the first topic request, and followed by
+ * 		  Network::AddPeer for each other node. The topic n uses the port
+ * 		  localPort + n in this node.
+ *
+ * @param node - The number of this node, smaller than timerMAX_PEERS.
+ * @param localPort - The port of the topic 0 in this node.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Init(uint16_t node, uint16_t localPort)
+{
+	void *p;
+
+	if(node >= netMAX_NODES)
+	{
+		return RealTime::fail;
+	}
+
+	localNode = node;
+	localBase = localPort;
+	peersNumber = 0;
+
+	for(size_t i = 0; i < netMAX_TOPICS; ++i)
+	{
+		topics[i] = NULL;
+	}
+
+	p = Heap::Alloc(sizeof(Task));
+	receiveTask = new(p) Task(NetReceiveFunc, netTASK_PRIORITY, 100000, NULL, netTASK_ID, "net_recv");
+	receiveTask->Start();
+
+	isEnabled = true;
+	return RealTime::ok;
+}
+
+/**
+ * @brief Add a node where the messages published in this node are sent.
+ *
+ * @param peerAddress - The IPv4 address of the other node, e.g. "192.168.0.2".
+ * @param peerPort - The port of the topic 0 in the other node, which uses the port peerPort + n for the topic n.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail if the address is invalid or there are too many nodes.
+ */
+int AddPeer(const char *peerAddress, uint16_t peerPort)
+{
+	struct sockaddr_in *peer = &peers[peersNumber];
+
+	if(peersNumber == (netMAX_NODES - 1))
+	{
+		return RealTime::fail;
+	}
+
+	memset(peer, 0, sizeof(struct sockaddr_in));
+	peer->sin_family = AF_INET;
+	peerBases[peersNumber] = peerPort;
+	if(inet_pton(AF_INET, peerAddress, &peer->sin_addr) != 1)
+	{
+		return RealTime::fail;
+	}
+
+	peersNumber++;
+	return RealTime::ok;
+}
+
+/**
+ * @brief Indicates if the topics are exchanged with another node.
+ *
+ * @return true if Network::Init was called with success.
+ */
+bool IsEnabled(void)
+{
+	return isEnabled;
+}
+
+/**
+ * @brief Open the socket of a topic. It is called when the topic is created in this node.
+ *
+ * @param topic - The topic identifier.
+ * @param handler - The local topic instance.
+ * @param messageSize - The size of the messages in the topic.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int AddTopic(size_t topic, Topic *handler, size_t messageSize)
+{
+	struct sockaddr_in local;
+	netTopic_t *entry;
+	int bufferSize = netSOCKET_BUFFER;
+	int fd;
+
+	if(topic >= netMAX_TOPICS)
+	{
+		return RealTime::fail;
+	}
+	entry = topics[topic];
+
+	if(entry == NULL)
+	{
+		void *p = Heap::Alloc(sizeof(netTopic_t));
+		if(p == NULL)
+		{
+			return RealTime::fail;
+		}
+		entry = (netTopic_t *)p;
+		entry->socket = -1;
+		entry->messageSize = 0;
+		entry->sendSequence = 0;
+		entry->assembly = NULL;
+		new(&entry->stats.latency) Histogram();
+		ClearTopicStats(&entry->stats);
+		topics[topic] = entry;
+	}
+	else if(entry->socket >= 0)
+	{
+		return RealTime::ok;
+	}
+
+	if((messageSize > netFRAGMENT_SIZE) && ((entry->assembly == NULL) || (entry->messageSize < messageSize)))
+	{
+		if(entry->assembly != NULL)
+		{
+			Heap::Free(entry->assembly);
+		}
+		entry->assembly = (uint8_t *)Heap::Alloc(messageSize);
+		if(entry->assembly == NULL)
+		{
+			return RealTime::fail;
+		}
+	}
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if(fd < 0)
+	{
+		return RealTime::fail;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+	setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(localBase + topic);
+	if(bind(fd, (struct sockaddr *)&local, sizeof(local)) != 0)
+	{
+		close(fd);
+		return RealTime::fail;
+	}
+
+	entry->handler = handler;
+	entry->messageSize = messageSize;
+	memset(entry->isSynced, 0, sizeof(entry->isSynced));
+	entry->assemblyBytes = 0;
+
+	// The receive task only uses the topic after the socket is set.
+	__sync_synchronize();
+	entry->socket = fd;
+	return RealTime::ok;
+}
+
+/**
+ * @brief Close the socket of a topic. It is called when the topic is deleted in this node.
+ *
+ * @param topic - The topic identifier.
+ */
+void RemoveTopic(size_t topic)
+{
+	int fd;
+
+	if((topic >= netMAX_TOPICS) || (topics[topic] == NULL))
+	{
+		return;
+	}
+	fd = topics[topic]->socket;
+	topics[topic]->socket = -1;
+	if(fd >= 0)
+	{
+		close(fd);
+	}
+}
+
+/**
+ * @brief Send a message to the subscribers of the topic in all the other nodes.
+ *
+ * 		  The message is sent to one node after the other, so the publisher
+ * 		  time spent here grows with the number of nodes.
+ *
+ * @param topic - The topic identifier.
+ * @param msg - The message.
+ * @param size - The message size in bytes.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail if the message was not sent to some node.
+ */
+int Send(size_t topic, const void *msg, size_t size)
+{
+	netTopic_t *entry = (topic < netMAX_TOPICS)? topics[topic] : NULL;
+	struct sockaddr_in address;
+	netHeader_t header;
+	struct iovec iov[2];
+	struct msghdr datagram;
+	size_t fragment;
+	int result = RealTime::ok;
+
+	if((entry == NULL) || (entry->socket < 0))
+	{
+		return RealTime::fail;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.sequence = __sync_fetch_and_add(&entry->sendSequence, 1);
+	header.length = size;
+	header.topic = topic;
+	header.node = localNode;
+	header.sendTime = Timer::GetTime();
+
+	memset(&datagram, 0, sizeof(datagram));
+	datagram.msg_name = &address;
+	datagram.msg_namelen = sizeof(address);
+	datagram.msg_iov = iov;
+	datagram.msg_iovlen = 2;
+	iov[0].iov_base = &header;
+	iov[0].iov_len = sizeof(header);
+
+	for(size_t i = 0; i < peersNumber; ++i)
+	{
+		address = peers[i];
+		address.sin_port = htons(peerBases[i] + topic);
+		header.offset = 0;
+
+		// The empty messages are sent too, with only the header.
+		do
+		{
+			fragment = ((size - header.offset) > netFRAGMENT_SIZE)? netFRAGMENT_SIZE : (size - header.offset);
+			iov[1].iov_base = (uint8_t *)msg + header.offset;
+			iov[1].iov_len = fragment;
+
+			if(sendmsg(entry->socket, &datagram, 0) < 0)
+			{
+				__sync_fetch_and_add(&entry->stats.errors, 1);
+				result = RealTime::fail;
+				break;
+			}
+			header.offset += fragment;
+		}while(header.offset < size);
+	}
+
+	__sync_fetch_and_add(&entry->stats.sendSum, Timer::GetTime() - header.sendTime);
+	if(result == RealTime::ok)
+	{
+		__sync_fetch_and_add(&entry->stats.sent, 1);
+	}
+	return result;
+}
+
+/**
+ * @brief Clear the statistics of all topics, before a test step.
+ */
+void ClearStats(void)
+{
+	for(size_t i = 0; i < netMAX_TOPICS; ++i)
+	{
+		if(topics[i] != NULL)
+		{
+			ClearTopicStats(&topics[i]->stats);
+		}
+	}
+}
+
+/**
+ * @brief Print the transport statistics of all topics in the test step.
+ *
+ * 		  The latency is measured from the publishing in the other node to the
+ * 		  local topic queue, with the other node clock converted by the estimate
+ * 		  of the clock synchronization, whose error is up to half its round trip.
+ * 		  The send cost is the average publisher time spent sending a message
+ * 		  to all the other nodes.
+ */
+void PrintReport(void)
+{
+	double period = Timer::GetPeriod();
+
+	if(!isEnabled)
+	{
+		return;
+	}
+
+	Stdout::Print("\nNetwork: UDP with");
+	for(size_t i = 0; i < peersNumber; ++i)
+	{
+		Stdout::Print(" %s", inet_ntoa(peers[i].sin_addr));
+	}
+	Stdout::Print("\n");
+	Stdout::Print("Topic\tSent\tReceived\tLost\tReordered\tErrors\tAverage (s)\tp99 (s)\t\tMax (s)\t\tSend cost (s)\n");
+	Stdout::Print("     \t    \t        \t    \t         \t      \tLatency\n");
+
+	for(size_t i = 0; i < netMAX_TOPICS; ++i)
+	{
+		netStats_t *stats;
+
+		if(topics[i] == NULL)
+		{
+			continue;
+		}
+		stats = &topics[i]->stats;
+
+		Stdout::Print("%d\t%d\t%d\t\t%d\t%d\t\t%d\t%f\t%f\t%f\t%f\n", i, stats->sent, stats->received,
+						stats->lost, stats->reordered, stats->errors,
+						(stats->received == 0)? 0.0 : (stats->latencySum/period)/stats->received,
+						stats->latency.GetPercentile(99)/period,
+						stats->latency.GetPercentile(100)/period,
+						(stats->sent == 0)? 0.0 : (stats->sendSum/period)/stats->sent);
+	}
+	Stdout::Print("\n");
+}
+
+}
+}
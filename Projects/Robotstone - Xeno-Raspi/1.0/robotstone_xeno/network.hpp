@@ -0,0 +1,106 @@
+/**
+ * @file	network.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the UDP transport of the topics, used when the
+ * Master and the Slaves run in different nodes. Each topic has its own
+ * port, and the messages received from the other nodes are delivered to the
+ * local topic by a receive task, so the publishers and subscribers
+ * work as in a single node. Each message published in a node is sent
+ * to all the other nodes added by Network::AddPeer.
+ */
+
+#ifndef RT_NETWORK_HPP_
+#define RT_NETWORK_HPP_
+
+/*MODULE INCLUDES*/
+/*=======================================================================================*/
+#include <stdint.h>
+#include <stddef.h>
+#include "timer.hpp"
+#include "histogram.hpp"
+#include "communic.hpp"
+
+/*IMPLEMENTATION SPECIFIC INCLUDES*/
+/*=======================================================================================*/
+#include <netinet/in.h>
+
+namespace RealTime
+{
+
+/*MODULE TYPES*/
+/*=======================================================================================*/
+
+/**
+ * @brief The header of each datagram. The nodes must have the same byte order.
+ *
+ * 		  The messages bigger than a datagram are sent in fragments, all
+ * 		  of them with the same sequence and send time.
+ */
+typedef struct
+{
+	uint32_t sequence; /**< The message sequence in the topic, given by the sender node. */
+	uint32_t length; /**< The message length in bytes. */
+	uint32_t offset; /**< The offset of the fragment in the message. */
+	uint16_t topic;
+	uint16_t node; /**< The number of the sender node. */
+	timeCount_t sendTime; /**< When the message was published, in the sender clock. */
+}netHeader_t;
+
+/**
+ * @brief The transport statistics of a topic in a test step.
+ */
+typedef struct
+{
+	uint32_t sent; /**< Messages sent to the other nodes. */
+	uint32_t received; /**< Messages received complete from the other nodes. */
+	uint32_t lost; /**< Gaps in the received sequences. */
+	uint32_t reordered; /**< Messages received after a later one. */
+	uint32_t errors; /**< Datagrams not sent or invalid. */
+	timeCount_t latencySum;
+	timeCount_t sendSum; /**< Time spent by the publishers sending the messages to all the other nodes. */
+	Histogram latency; /**< One-way latency from the publishing to the local topic queue. */
+}netStats_t;
+
+/**
+ * @brief Namespace related to the UDP transport between nodes.
+ */
+namespace Network
+{
+
+int Init(uint16_t node, uint16_t localPort);
+
+int AddPeer(const char *peerAddress, uint16_t peerPort);
+
+bool IsEnabled(void);
+
+int AddTopic(size_t topic, Topic *handler, size_t messageSize);
+
+void RemoveTopic(size_t topic);
+
+int Send(size_t topic, const void *msg, size_t size);
+
+void ClearStats(void);
+
+void PrintReport(void);
+
+}
+}
+
+#endif /* RT_NETWORK_HPP_ */
@@ -31,6 +31,8 @@
 namespace RealTime
 {
 
+static volatile size_t execCPUS = 1; /**< Number of processors used by the experiments. */
+
 /**
  * @brief Initialize the system real-time parameters.
  *
@@ -59,18 +61,48 @@ void Init(void)
 }
 
 
+/**
+ * @brief Set the number of processors used by the experiments. Each
+ * 		  processor from 0 to cpus - 1 runs a copy of the baseline task set.
+ *
+ * @param cpus - The number of processors.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail if the machine hasn't so many processors.
+ */
 int SetExecCPUS(size_t cpus)
 {
+	if((cpus == 0) || (cpus > GetCPUsNumber()))
+	{
+		return RealTime::fail;
+	}
+
 	RealTime::execCPUS = cpus;
-	return 1;
+	return RealTime::ok;
 }
 
-
+/**
+ * @brief Get the number of processors used by the experiments.
+ *
+ * @return The number of processors.
+ */
 size_t GetExecCPUS()
 {
 	return RealTime::execCPUS;
 }
 
+/**
+ * @brief Get the number of processors available to the tasks.
+ *
+ * @return The number of online processors.
+ */
+size_t GetCPUsNumber(void)
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (cpus > 0)? (size_t)cpus : 1;
+}
+
 
 }
 
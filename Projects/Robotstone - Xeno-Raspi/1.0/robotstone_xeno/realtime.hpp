@@ -45,14 +45,14 @@ namespace RealTime
 const int ok = 0;
 const int fail = 1;
 
-volatile static size_t execCPUS;
-
 void Init(void);
 
 int SetExecCPUS(size_t cpus);
 
 size_t GetExecCPUS();
 
+size_t GetCPUsNumber(void);
+
 }
 
 #endif /* REALTIME_HPP_ */
@@ -0,0 +1,33 @@
+/**
+ * @file	rtconfig.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module selects, at build time, the implementation used by the real-time services.
+ */
+
+#ifndef RT_CONFIG_HPP_
+#define RT_CONFIG_HPP_
+
+// Comment RT_POSIX if you want compile code for the Xenomai Alchemy API
+// Uncomment RT_POSIX if you want compile code for pthreads (SCHED_FIFO) on
+// stock or PREEMPT_RT Linux kernels. It can also be given as -DRT_POSIX.
+
+//#define RT_POSIX
+
+#endif /* RT_CONFIG_HPP_ */
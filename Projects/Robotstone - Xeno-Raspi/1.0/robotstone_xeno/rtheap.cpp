@@ -22,10 +22,38 @@
  */
 
 #include "rtheap.hpp"
+#include "realtime.hpp"
+#include <string.h>
+#include <time.h>
+
+#ifdef RT_POSIX
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 
 namespace RealTime
 {
 
+/**
+ * @brief The LocalHeap class constructor.
+ *
+ * 		  The instance must be created or bound later by LocalHeap::Create
+ * 		  or LocalHeap::Bind.
+ */
+LocalHeap::LocalHeap(void):
+#ifdef RT_POSIX
+		block(NULL),
+		isOwner(false),
+#endif
+		size(0)
+{
+#ifdef RT_POSIX
+	this->name[0] = '\0';
+#endif
+}
+
 /**
  * @brief The LocalHeap class constructor.
  *
@@ -34,15 +62,77 @@ namespace RealTime
  */
 LocalHeap::LocalHeap(const char* name, size_t heapSize)
 {
-	if(rt_heap_bind(&heap, name, 1000000) != 0)
+#ifdef RT_POSIX
+	this->block = NULL;
+	this->isOwner = false;
+#endif
+	if(this->Bind(name, heapSize, 1000000) != RealTime::ok)
 	{
-		if(rt_heap_create(&heap, name, heapSize, H_PRIO|H_SINGLE) != 0)
+		if(this->Create(name, heapSize) != RealTime::ok)
 		{
 			Stdout::Print("Impossible create %s heap.\n", name);
 			exit(1);
 		}
 	}
+}
+
+/**
+ * @brief Create a new shared memory region.
+ *
+ * @param name - A null terminated string to identify allocated memory for sharing.
+ * @param heapSize - The memory size inquire for allocation in bytes.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int LocalHeap::Create(const char* name, size_t heapSize)
+{
 	this->size = heapSize;
+#ifdef RT_POSIX
+	snprintf(this->name, LocalHeap::maxNameLength, "h_%s", name);
+	this->block = Heap::CreateShared(this->name, heapSize);
+	if(this->block == NULL)
+	{
+		return RealTime::fail;
+	}
+	this->isOwner = true;
+#else
+	if(rt_heap_create(&heap, name, heapSize, H_PRIO|H_SINGLE) != 0)
+	{
+		return RealTime::fail;
+	}
+#endif
+	return RealTime::ok;
+}
+
+/**
+ * @brief Bind to a shared memory region created by another task.
+ *
+ * @param name - A null terminated string to identify allocated memory for sharing.
+ * @param heapSize - The memory size inquire for allocation in bytes.
+ * @param timeout - The maximum time to wait the region creation in implementation specific units.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int LocalHeap::Bind(const char* name, size_t heapSize, timeCount_t timeout)
+{
+	this->size = heapSize;
+#ifdef RT_POSIX
+	snprintf(this->name, LocalHeap::maxNameLength, "h_%s", name);
+	this->block = Heap::BindShared(this->name, heapSize, timeout);
+	if(this->block == NULL)
+	{
+		return RealTime::fail;
+	}
+	this->isOwner = false;
+#else
+	if(rt_heap_bind(&heap, name, timeout) != 0)
+	{
+		return RealTime::fail;
+	}
+#endif
+	return RealTime::ok;
 }
 
 /**
@@ -55,6 +145,10 @@ LocalHeap::LocalHeap(const char* name, size_t heapSize)
  */
 void* LocalHeap::Alloc(void)
 {
+#ifdef RT_POSIX
+	// The whole region is a single block shared by all the tasks.
+	return this->block;
+#else
 	void *blockPointer;
 
 	if(rt_heap_alloc(&heap,
@@ -66,6 +160,7 @@ void* LocalHeap::Alloc(void)
 		return NULL;
 	}
 	return blockPointer;
+#endif
 }
 
 /**
@@ -75,7 +170,49 @@ void* LocalHeap::Alloc(void)
  */
 void LocalHeap::Free(void * block)
 {
+#ifndef RT_POSIX
 	rt_heap_free(&heap, block);
+#endif
+}
+
+/**
+ * @brief Delete the shared memory region.
+ */
+void LocalHeap::Delete(void)
+{
+#ifdef RT_POSIX
+	if(this->block == NULL)
+	{
+		return;
+	}
+	if(this->isOwner)
+	{
+		Heap::DeleteShared(this->name, this->block, this->size);
+	}
+	else
+	{
+		Heap::ReleaseShared(this->block, this->size);
+	}
+	this->block = NULL;
+#else
+	rt_heap_delete(&heap);
+#endif
+}
+
+/**
+ * @brief Unbind from the shared memory region, which stays valid for the other tasks.
+ */
+void LocalHeap::Unbind(void)
+{
+#ifdef RT_POSIX
+	if(this->block != NULL)
+	{
+		Heap::ReleaseShared(this->block, this->size);
+		this->block = NULL;
+	}
+#else
+	rt_heap_unbind(&heap);
+#endif
 }
 
 namespace Heap
@@ -84,21 +221,66 @@ namespace Heap
 //static uint64_t globalPoolSize = 335544320; // size for experiments in distribuited
 static uint64_t globalPoolSize = 251658240;//167772160;
 
+static volatile uint32_t allocNumber = 0; /**< Blocks allocated from the global pool since the start. */
+
+#ifdef RT_POSIX
+
+#define heapSHARED_PATH	"/rstone_%s%s"
+#define heapMAX_SHARED	256
+#define heapMAX_NODE_NAME	16
+
+/**
+ * @brief Header placed before each block allocated from the global pool.
+ */
+typedef union
+{
+	size_t size;
+	long double alignment;
+}blockHeader_t;
+
+static pthread_mutex_t globalMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t globalUsed = 0;
+
+static char sharedNames[heapMAX_SHARED][LocalHeap::maxNameLength + heapMAX_NODE_NAME + sizeof(heapSHARED_PATH)];
+static size_t sharedNumber = 0;
+static char nodePrefix[heapMAX_NODE_NAME] = ""; /**< Prefix of the shared memory names, set by Heap::SetNodeName. */
+
+/**
+ * @brief Remove the names of the shared memory objects created by the process.
+ *
+ * 		  The memory stays valid for the processes that are still using it.
+ */
+static void UnlinkAllShared(void)
+{
+	for(size_t i = 0; i < sharedNumber; ++i)
+	{
+		if(sharedNames[i][0] != '\0')
+		{
+			shm_unlink(sharedNames[i]);
+		}
+	}
+}
+#else
 static RT_HEAP globalHeap;
+#endif
 
 /**
  * @brief Initialized the system global parameters for system allocation.
  */
 void InitGlobal(void)
 {
+#ifdef RT_POSIX
+	atexit(UnlinkAllShared);
+#else
 	if(rt_heap_bind(&globalHeap, "globalHeap", 1000000) != 0)
 	{
 		if(rt_heap_create(&globalHeap, "globalHeap", globalPoolSize, H_PRIO) != 0)
 		{
-			rt_printf("Impossible create global heap.\n");
+			Stdout::Print("Impossible create global heap.\n");
 			exit(1);
 		}
 	}
+#endif
 }
 
 /**
@@ -112,6 +294,35 @@ void InitGlobal(void)
  */
 void *Alloc(size_t size)
 {
+#ifdef RT_POSIX
+	blockHeader_t *header;
+
+	pthread_mutex_lock(&globalMutex);
+
+	// Keep the same memory budget of the Xenomai global heap.
+	if(globalUsed + size > globalPoolSize)
+	{
+		pthread_mutex_unlock(&globalMutex);
+		return NULL;
+	}
+
+	header = (blockHeader_t *)malloc(sizeof(blockHeader_t) + size);
+	if(header == NULL)
+	{
+		pthread_mutex_unlock(&globalMutex);
+		return NULL;
+	}
+	globalUsed += size;
+
+	pthread_mutex_unlock(&globalMutex);
+
+	// Touch all the pages now, so no page fault happens in real-time code.
+	memset(header + 1, 0, size);
+	header->size = size;
+	__sync_fetch_and_add(&allocNumber, 1);
+
+	return (void *)(header + 1);
+#else
 	void *blockPointer;
 
 	if(rt_heap_alloc(&globalHeap,
@@ -122,7 +333,20 @@ void *Alloc(size_t size)
 	{
 		return NULL;
 	}
+	__sync_fetch_and_add(&allocNumber, 1);
 	return blockPointer;
+#endif
+}
+
+/**
+ * @brief Get the number of blocks allocated from the global pool, used
+ * 		  to find allocations in code that must not allocate.
+ *
+ * @return The number of calls to Heap::Alloc with success since the start.
+ */
+uint32_t GetAllocNumber(void)
+{
+	return allocNumber;
 }
 
 /**
@@ -132,7 +356,213 @@ void *Alloc(size_t size)
  */
 void Free(void * block)
 {
+#ifdef RT_POSIX
+	if(block == NULL)
+	{
+		return;
+	}
+
+	blockHeader_t *header = ((blockHeader_t *)block) - 1;
+
+	pthread_mutex_lock(&globalMutex);
+	globalUsed -= header->size;
+	pthread_mutex_unlock(&globalMutex);
+
+	free(header);
+#else
 	rt_heap_free(&globalHeap, block);
+#endif
+}
+
+#ifdef RT_POSIX
+
+/**
+ * @brief Create a named shared memory region, visible to other processes.
+ *
+ * 		  The region is zero filled. Its name is removed when the creator process exits.
+ *
+ * @param name - A null terminated string to identify the region.
+ * @param size - The region size in bytes.
+ *
+ * @return
+ * 			- A pointer to the region if success;
+ * 			- NULL if the region already exists or can not be created.
+ */
+void *CreateShared(const char *name, size_t size)
+{
+	char path[LocalHeap::maxNameLength + heapMAX_NODE_NAME + sizeof(heapSHARED_PATH)];
+	void *block;
+	int fd;
+
+	snprintf(path, sizeof(path), heapSHARED_PATH, nodePrefix, name);
+
+	fd = shm_open(path, O_RDWR|O_CREAT|O_EXCL, 0600);
+	if(fd < 0)
+	{
+		return NULL;
+	}
+
+	if(ftruncate(fd, size) != 0)
+	{
+		close(fd);
+		shm_unlink(path);
+		return NULL;
+	}
+
+	block = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if(block == MAP_FAILED)
+	{
+		shm_unlink(path);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&globalMutex);
+	if(sharedNumber < heapMAX_SHARED)
+	{
+		strcpy(sharedNames[sharedNumber++], path);
+	}
+	pthread_mutex_unlock(&globalMutex);
+
+	return block;
+}
+
+/**
+ * @brief Bind to a named shared memory region created by another task or process.
+ *
+ * @param name - A null terminated string to identify the region.
+ * @param size - The region size in bytes.
+ * @param timeout - The maximum time to wait the region creation in implementation
+ * 					specific units. 0 means wait forever.
+ *
+ * @return
+ * 			- A pointer to the region if success;
+ * 			- NULL otherwise.
+ */
+void *BindShared(const char *name, size_t size, timeCount_t timeout)
+{
+	char path[LocalHeap::maxNameLength + heapMAX_NODE_NAME + sizeof(heapSHARED_PATH)];
+	struct timespec retry = {0, 100000};
+	timeCount_t deadline = Timer::GetTime() + timeout;
+	struct stat info;
+	void *block;
+	int fd;
+
+	snprintf(path, sizeof(path), heapSHARED_PATH, nodePrefix, name);
+
+	for(;;)
+	{
+		fd = shm_open(path, O_RDWR, 0600);
+		if(fd >= 0)
+		{
+			// The creator may not have set the region size yet.
+			if((fstat(fd, &info) == 0) && ((size_t)info.st_size >= size))
+			{
+				break;
+			}
+			close(fd);
+		}
+
+		if((timeout != 0) && (Timer::GetTime() >= deadline))
+		{
+			return NULL;
+		}
+		nanosleep(&retry, NULL);
+	}
+
+	block = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if(block == MAP_FAILED)
+	{
+		return NULL;
+	}
+	return block;
+}
+
+/**
+ * @brief Release the caller mapping of a shared memory region.
+ *
+ * @param block - The region pointer.
+ * @param size - The region size in bytes.
+ */
+void ReleaseShared(void *block, size_t size)
+{
+	munmap(block, size);
+}
+
+/**
+ * @brief Release the caller mapping and remove the name of a shared memory region.
+ *
+ * @param name - A null terminated string to identify the region.
+ * @param block - The region pointer.
+ * @param size - The region size in bytes.
+ */
+void DeleteShared(const char *name, void *block, size_t size)
+{
+	char path[LocalHeap::maxNameLength + heapMAX_NODE_NAME + sizeof(heapSHARED_PATH)];
+
+	snprintf(path, sizeof(path), heapSHARED_PATH, nodePrefix, name);
+
+	munmap(block, size);
+	shm_unlink(path);
+
+	pthread_mutex_lock(&globalMutex);
+	for(size_t i = 0; i < sharedNumber; ++i)
+	{
+		if(strcmp(sharedNames[i], path) == 0)
+		{
+			sharedNames[i][0] = '\0';
+		}
+	}
+	pthread_mutex_unlock(&globalMutex);
+}
+
+#endif
+
+/**
+ * @brief Give a name to the node in the shared memory names, so two
+ * 		  nodes in the same machine (e.g. Master and Slave connected by
+ * 		  the network) don't share their regions.
+ *
+ * 		  It must be called before the first shared memory region is created.
+ * 		  In Xenomai, each node must run in its own session.
+ *
+ * @param name - The node name.
+ */
+void SetNodeName(const char *name)
+{
+#ifdef RT_POSIX
+	snprintf(nodePrefix, sizeof(nodePrefix), "%s_", name);
+#endif
+}
+
+/**
+ * @brief Mark a shared memory region as initialized by its creator.
+ *
+ * @param initState - The initialization flag inside the region.
+ */
+void SetSharedInit(volatile uint32_t *initState)
+{
+	__sync_synchronize();
+	*initState = 1;
+}
+
+/**
+ * @brief Wait the creator of a shared memory region finish its initialization.
+ *
+ * @param initState - The initialization flag inside the region.
+ */
+void WaitSharedInit(volatile uint32_t *initState)
+{
+	struct timespec retry = {0, 100000};
+
+	while(*initState == 0)
+	{
+		nanosleep(&retry, NULL);
+	}
+	__sync_synchronize();
 }
 
 }
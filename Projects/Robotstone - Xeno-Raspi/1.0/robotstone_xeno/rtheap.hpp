@@ -25,10 +25,14 @@
 #ifndef RT_HEAP_MACRO_HPP
 #define RT_HEAP_MACRO_HPP
 
+#include "rtconfig.hpp"
+#ifndef RT_POSIX
 #include "alchemy/heap.h"
+#endif
 #include "stdlib.h"
 #include <stdio.h>
 #include "stdout.hpp"
+#include "timer.hpp"
 
 using namespace std;
 
@@ -42,13 +46,26 @@ namespace RealTime
  */
 class LocalHeap
 {
+public:
+	static const size_t maxNameLength = 32; /**< The maximum length of the string identifier. */
 private:
+#ifdef RT_POSIX
+	void *block; /**< The shared memory mapping. */
+	char name[maxNameLength]; /**< The shared memory object name. */
+	bool isOwner; /**< Indicates that the instance created the shared memory object. */
+#else
 	RT_HEAP heap;
+#endif
 	size_t size;
 public:
+	LocalHeap(void);
 	LocalHeap(const char* name, size_t heapSize);
+	int Create(const char* name, size_t heapSize);
+	int Bind(const char* name, size_t heapSize, timeCount_t timeout);
 	void *Alloc(void);
 	void Free(void * block);
+	void Delete(void);
+	void Unbind(void);
 };
 
 /**
@@ -63,6 +80,24 @@ void *Alloc(size_t size);
 
 void Free(void * block);
 
+uint32_t GetAllocNumber(void);
+
+#ifdef RT_POSIX
+void *CreateShared(const char *name, size_t size);
+
+void *BindShared(const char *name, size_t size, timeCount_t timeout);
+
+void ReleaseShared(void *block, size_t size);
+
+void DeleteShared(const char *name, void *block, size_t size);
+#endif
+
+void SetNodeName(const char *name);
+
+void SetSharedInit(volatile uint32_t *initState);
+
+void WaitSharedInit(volatile uint32_t *initState);
+
 }
 }
 
@@ -0,0 +1,288 @@
+/**
+ * @file	rtpool.cpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the Pool class implementation, a fixed set of
+ * memory blocks of the same size, taken and given back in constant time
+ * by the tasks of a process without locks.
+ */
+
+#include "rtpool.hpp"
+#include "realtime.hpp"
+#include "rtheap.hpp"
+#include <string.h>
+
+/**
+ * @brief The header placed before each block, keeping the blocks aligned to 16 bytes.
+ */
+typedef struct
+{
+	uint32_t index;
+	volatile uint32_t next; /**< The next free block, while the block is free. */
+	uint32_t reserved[2];
+}poolBlock_t;
+
+#define poolHEADER(pool, index) ((poolBlock_t *)(pool->blocks[index]) - 1)
+
+namespace RealTime
+{
+
+/**
+ * @brief The Pool class constructor.
+ *
+ * 		  The pool must be created later by Pool::Create.
+ */
+Pool::Pool(void)
+		: blocks(NULL), top(Pool::none), chunksNumber(0), oldTablesNumber(0),
+		  blocksNumber(0), tableSize(0), maxBlocks(0), stride(0)
+{
+
+}
+
+/**
+ * @brief Create an empty pool. The blocks are added by Pool::Grow.
+ *
+ * 		  No memory is taken for the blocks not added, so the maximum may be
+ * 		  much bigger than the usual size of the pool.
+ *
+ * @param blockSize - The size of each block in bytes.
+ * @param maxBlocks - The maximum number of blocks in the pool.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Pool::Create(size_t blockSize, uint32_t maxBlocks)
+{
+	this->stride = (sizeof(poolBlock_t) + blockSize + sizeof(poolBlock_t) - 1) & ~(sizeof(poolBlock_t) - 1);
+	this->maxBlocks = maxBlocks;
+	this->blocksNumber = 0;
+	this->chunksNumber = 0;
+	this->oldTablesNumber = 0;
+	this->tableSize = 0;
+	this->top = Pool::none;
+	this->blocks = NULL;
+
+	return RealTime::ok;
+}
+
+/**
+ * @brief Add blocks to the pool, allocated together from the global heap.
+ *
+ * 		  It may be called while other tasks take and give back blocks,
+ * 		  but not by two tasks at the same time.
+ *
+ * @param number - The number of blocks to add.
+ *
+ * @return The number of blocks added, limited by the maximum of the pool.
+ */
+uint32_t Pool::Grow(uint32_t number)
+{
+	uint8_t *chunk;
+
+	if(number > (this->maxBlocks - this->blocksNumber))
+	{
+		number = this->maxBlocks - this->blocksNumber;
+	}
+
+	if((number == 0) || (this->chunksNumber == Pool::maxChunks))
+	{
+		return 0;
+	}
+
+	if(this->GrowTable(this->blocksNumber + number) != RealTime::ok)
+	{
+		return 0;
+	}
+
+	chunk = (uint8_t *)Heap::Alloc(number*this->stride);
+	if(chunk == NULL)
+	{
+		return 0;
+	}
+	this->chunks[this->chunksNumber++] = chunk;
+
+	for(uint32_t i = 0; i < number; ++i)
+	{
+		uint32_t index = this->blocksNumber + i;
+		poolBlock_t *header = (poolBlock_t *)(chunk + i*this->stride);
+
+		header->index = index;
+		this->blocks[index] = (uint8_t *)(header + 1);
+	}
+
+	// The addresses are visible before the blocks are in the free stack.
+	__sync_synchronize();
+	for(uint32_t i = 0; i < number; ++i)
+	{
+		this->Push(this->blocksNumber + i);
+	}
+	this->blocksNumber += number;
+
+	return number;
+}
+
+/**
+ * @brief Take a free block.
+ *
+ * @return - A pointer to the block if success;
+ * 		   - NULL if all the blocks are in use.
+ */
+void *Pool::Alloc(void)
+{
+	uint64_t oldTop;
+	uint64_t newTop;
+	uint32_t index;
+
+	do
+	{
+		oldTop = this->top;
+		index = (uint32_t)oldTop;
+
+		if(index == Pool::none)
+		{
+			return NULL;
+		}
+		newTop = (((oldTop >> 32) + 1) << 32) | poolHEADER(this, index)->next;
+	}while(!__sync_bool_compare_and_swap(&this->top, oldTop, newTop));
+
+	return (void *)this->blocks[index];
+}
+
+/**
+ * @brief Give back a block taken by Pool::Alloc.
+ *
+ * @param block - The block pointer.
+ */
+void Pool::Free(void *block)
+{
+	if(block == NULL)
+	{
+		return;
+	}
+	this->Push((((poolBlock_t *)block) - 1)->index);
+}
+
+/**
+ * @brief Delete the pool. All its blocks must have been given back.
+ */
+void Pool::Delete(void)
+{
+	for(uint32_t i = 0; i < this->chunksNumber; ++i)
+	{
+		Heap::Free(this->chunks[i]);
+	}
+	for(uint32_t i = 0; i < this->oldTablesNumber; ++i)
+	{
+		Heap::Free(this->oldTables[i]);
+	}
+	this->chunksNumber = 0;
+	this->oldTablesNumber = 0;
+	this->blocksNumber = 0;
+	this->tableSize = 0;
+	this->top = Pool::none;
+
+	if(this->blocks != NULL)
+	{
+		Heap::Free(this->blocks);
+		this->blocks = NULL;
+	}
+}
+
+/**
+ * @brief Get the number of blocks in the pool, in use or not.
+ *
+ * @return The number of blocks.
+ */
+uint32_t Pool::GetBlocksNumber(void)
+{
+	return this->blocksNumber;
+}
+
+/**
+ * @brief Make the table of blocks addresses big enough, doubling its size.
+ *
+ * 		  The addresses are copied to the new table before it replaces the
+ * 		  old one, which stays valid for the tasks still reading it.
+ *
+ * @param blocksNumber - The number of blocks that the table must have.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Pool::GrowTable(uint32_t blocksNumber)
+{
+	uint32_t size = (this->tableSize == 0)? 16 : this->tableSize;
+	uint8_t **table;
+
+	if(blocksNumber <= this->tableSize)
+	{
+		return RealTime::ok;
+	}
+	if(this->oldTablesNumber == Pool::maxChunks)
+	{
+		return RealTime::fail;
+	}
+
+	while(size < blocksNumber)
+	{
+		size *= 2;
+	}
+	if(size > this->maxBlocks)
+	{
+		size = this->maxBlocks;
+	}
+
+	table = (uint8_t **)Heap::Alloc(size*sizeof(uint8_t *));
+	if(table == NULL)
+	{
+		return RealTime::fail;
+	}
+
+	if(this->blocks != NULL)
+	{
+		memcpy(table, this->blocks, this->blocksNumber*sizeof(uint8_t *));
+		this->oldTables[this->oldTablesNumber++] = this->blocks;
+	}
+
+	// The addresses are copied before the new table is seen.
+	__sync_synchronize();
+	this->blocks = table;
+	this->tableSize = size;
+	return RealTime::ok;
+}
+
+/**
+ * @brief Put a block in the top of the free stack.
+ *
+ * @param index - The block index.
+ */
+void Pool::Push(uint32_t index)
+{
+	uint64_t oldTop;
+	uint64_t newTop;
+
+	do
+	{
+		oldTop = this->top;
+		poolHEADER(this, index)->next = (uint32_t)oldTop;
+		newTop = (((oldTop >> 32) + 1) << 32) | index;
+	}while(!__sync_bool_compare_and_swap(&this->top, oldTop, newTop));
+}
+
+}
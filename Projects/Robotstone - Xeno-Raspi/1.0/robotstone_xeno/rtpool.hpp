@@ -0,0 +1,78 @@
+/**
+ * @file	rtpool.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the Pool class implementation, a fixed set of
+ * memory blocks of the same size, taken and given back in constant time
+ * by the tasks of a process without locks.
+ */
+
+#ifndef RT_POOL_HPP_
+#define RT_POOL_HPP_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "rtconfig.hpp"
+
+namespace RealTime
+{
+
+/**
+ * @brief Class that provides a lock-free pool of memory blocks with the same size.
+ *
+ * 		  The free blocks are kept in a stack of block indexes, whose top has
+ * 		  a tag incremented in each change, so a block taken and given back
+ * 		  between the reading and the update of the top by another task is
+ * 		  noticed. The blocks are allocated from the global heap only by
+ * 		  Pool::Grow, out of the time critical paths. The table of the
+ * 		  blocks addresses also grows with the pool, and the old tables are
+ * 		  kept until Pool::Delete, since other tasks may be reading them.
+ */
+class Pool
+{
+public:
+	static const uint32_t maxChunks = 32; /**< Maximum number of Pool::Grow calls. */
+	static const uint32_t none = 0xFFFFFFFF; /**< The index of an empty stack. */
+private:
+	uint8_t ** volatile blocks; /**< The address of each block, by index. */
+	volatile uint64_t top; /**< The index of the first free block in the low word and the tag in the high word. */
+	uint8_t *chunks[maxChunks];
+	uint8_t **oldTables[maxChunks]; /**< The tables of blocks addresses replaced by bigger ones. */
+	uint32_t chunksNumber;
+	uint32_t oldTablesNumber;
+	uint32_t blocksNumber;
+	uint32_t tableSize; /**< Number of addresses in the blocks table. */
+	uint32_t maxBlocks;
+	size_t stride; /**< Distance in bytes between two blocks, with the block header. */
+public:
+	Pool(void);
+	int Create(size_t blockSize, uint32_t maxBlocks);
+	uint32_t Grow(uint32_t number);
+	void *Alloc(void);
+	void Free(void *block);
+	void Delete(void);
+	uint32_t GetBlocksNumber(void);
+
+private:
+	int GrowTable(uint32_t blocksNumber);
+	void Push(uint32_t index);
+};
+}
+
+#endif /* RT_POOL_HPP_ */
@@ -0,0 +1,461 @@
+/**
+ * @file	rtqueue.cpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the Queue class implementation, which provides
+ * message queues shared between tasks by a common string identifier.
+ */
+
+#include "rtqueue.hpp"
+#include "realtime.hpp"
+#include <stdio.h>
+
+#ifdef RT_POSIX
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+/**
+ * @brief The header placed before the message in each queue slot.
+ */
+typedef struct
+{
+	volatile uint32_t sequence; /**< The message sequence plus one when the message is complete. */
+	uint32_t length;
+}queueSlot_t;
+#endif
+
+namespace RealTime
+{
+
+#ifdef RT_POSIX
+/**
+ * @brief Block the caller while the futex word keeps the expected value.
+ *
+ * @param word - The futex word.
+ * @param expected - The value of the word that keeps the caller blocked.
+ * @param timeout - The maximum wait, or NULL to wait forever.
+ *
+ * @return 0 if woken up, or the errno value (EINTR if unblocked by Task::Unblock,
+ * 		   ETIMEDOUT if the timeout expired).
+ */
+static int FutexWait(volatile uint32_t *word, uint32_t expected, const struct timespec *timeout)
+{
+	if(syscall(SYS_futex, word, FUTEX_WAIT, expected, timeout, NULL, 0) != 0)
+	{
+		return errno;
+	}
+	return 0;
+}
+
+/**
+ * @brief Wake up all the tasks waiting in the futex word.
+ */
+static void FutexWakeAll(volatile uint32_t *word)
+{
+	syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+#endif
+
+/**
+ * @brief The Queue class constructor.
+ *
+ * 		  The instance must be created or bound later by Queue::Create or Queue::Bind.
+ */
+Queue::Queue(void)
+#ifdef RT_POSIX
+		: state(NULL), slots(NULL), slotStride(0), readSeq(0), lostNumber(0)
+#endif
+{
+
+}
+
+/**
+ * @brief Create a new queue.
+ *
+ * @param name - A null terminated string to identify the queue for sharing.
+ * @param messageSize - The maximum size of each message in bytes.
+ * @param depth - The number of messages that can be buffered by the queue,
+ * 				  at least 2 in POSIX.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Queue::Create(const char* name, size_t messageSize, size_t depth)
+{
+#ifdef RT_POSIX
+	char sharedName[LocalHeap::maxNameLength];
+	snprintf(sharedName, sizeof(sharedName), "q_%s", name);
+
+	// With two slots at least, a receiver can always tell a slot being
+	// written for its message from one being overwritten by the next lap.
+	if(depth < 2)
+	{
+		depth = 2;
+	}
+
+	// Keep the slot headers aligned to 8 bytes.
+	this->slotStride = sizeof(queueSlot_t) + ((messageSize + 7) & ~((size_t)7));
+
+	if(this->shared.Create(sharedName, sizeof(sharedQueue_t) + depth*this->slotStride) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+
+	this->state = (sharedQueue_t *)this->shared.Alloc();
+	this->slots = (uint8_t *)(this->state + 1);
+	this->state->depth = depth;
+	this->state->slotSize = messageSize;
+	this->state->head = 0;
+	this->state->claim = 0;
+	this->readSeq = 0;
+
+	for(size_t i = 0; i < depth; ++i)
+	{
+		((queueSlot_t *)(this->slots + i*this->slotStride))->sequence = 0;
+	}
+
+	Heap::SetSharedInit(&this->state->initState);
+#else
+	/*
+	* Arguments: -*queue descriptor,
+	*            -string with queue name,
+	*            -queue size with all the messages length,
+	*            -Q_UNLIMITED indicates no error if buffer overflow,
+	*            -Q_PRIO indicate that the message from the highest priority task that arrives is the first that goes.
+	*/
+	if(rt_queue_create(&(this->queue), name, messageSize*depth, Q_UNLIMITED, Q_PRIO))
+	{
+		return RealTime::fail;
+	}
+#endif
+	return RealTime::ok;
+}
+
+/**
+ * @brief Bind to a queue created by another task.
+ *
+ * @param name - A null terminated string to identify the queue for sharing.
+ * @param timeout - The maximum time to wait the queue creation in implementation specific units.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Queue::Bind(const char* name, timeCount_t timeout)
+{
+#ifdef RT_POSIX
+	char sharedName[LocalHeap::maxNameLength];
+	size_t depth, slotSize;
+	snprintf(sharedName, sizeof(sharedName), "q_%s", name);
+
+	// Map the header first to learn the queue dimensions.
+	if(this->shared.Bind(sharedName, sizeof(sharedQueue_t), timeout) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+	this->state = (sharedQueue_t *)this->shared.Alloc();
+	Heap::WaitSharedInit(&this->state->initState);
+	depth = this->state->depth;
+	slotSize = this->state->slotSize;
+	this->shared.Unbind();
+
+	this->slotStride = sizeof(queueSlot_t) + ((slotSize + 7) & ~((size_t)7));
+
+	if(this->shared.Bind(sharedName, sizeof(sharedQueue_t) + depth*this->slotStride, timeout) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+	this->state = (sharedQueue_t *)this->shared.Alloc();
+	this->slots = (uint8_t *)(this->state + 1);
+
+	// Only the messages sent after the binding are received.
+	this->readSeq = this->state->claim;
+#else
+	if(rt_queue_bind(&(this->queue), name, timeout))
+	{
+		return RealTime::fail;
+	}
+#endif
+	return RealTime::ok;
+}
+
+/**
+ * @brief Take a queue buffer to build a message.
+ *
+ * 		  In POSIX the senders take the slots with an atomic increment, so
+ * 		  a sender that never calls Queue::Send doesn't block the other ones.
+ *
+ * @param size - The message size in bytes.
+ *
+ * @return - A pointer to the buffer if success;
+ * 		   - NULL otherwise.
+ */
+void *Queue::Alloc(size_t size)
+{
+#ifdef RT_POSIX
+	uint32_t seq;
+	queueSlot_t *slot;
+
+	if(size > this->state->slotSize)
+	{
+		return NULL;
+	}
+
+	seq = __sync_fetch_and_add(&this->state->claim, 1);
+	slot = (queueSlot_t *)(this->slots + (seq % this->state->depth)*this->slotStride);
+
+	// The slot is tagged with the message being written, until Queue::Send.
+	slot->sequence = seq;
+	__sync_synchronize();
+
+	return (void *)(slot + 1);
+#else
+	return rt_queue_alloc(&(this->queue), size);
+#endif
+}
+
+/**
+ * @brief Send a message built in a buffer taken by Queue::Alloc.
+ *
+ * @param msg - The buffer returned by Queue::Alloc.
+ * @param size - The message size in bytes.
+ * @param mode - Queue::normal or Queue::broadcast.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Queue::Send(void *msg, size_t size, int mode)
+{
+#ifdef RT_POSIX
+	queueSlot_t *slot = (queueSlot_t *)msg - 1;
+
+	// Every instance keeps its own read sequence, so a message is always
+	// seen by all the receivers and both modes behave the same.
+	slot->length = size;
+	__sync_synchronize();
+	slot->sequence = slot->sequence + 1;
+
+	__sync_fetch_and_add(&this->state->head, 1);
+
+	FutexWakeAll(&this->state->head);
+#else
+	if(rt_queue_send(&(this->queue), msg, size, (mode == Queue::broadcast)? Q_BROADCAST : Q_NORMAL) < 0)
+	{
+		return RealTime::fail;
+	}
+#endif
+	return RealTime::ok;
+}
+
+/**
+ * @brief Wait to receive a message.
+ *
+ * 		  While a message doesn't arrives, the caller task
+ * 		  will be suspended.
+ *
+ * @param msg - Receives the pointer to the queue buffer with the message.
+ * 				It must be given back by Queue::Free.
+ *
+ * @return - The message size if success;
+ * 		   - A negative value if the wait was interrupted or the queue deleted.
+ */
+ssize_t Queue::Receive(void **msg)
+{
+	return this->Receive(msg, timerMAX_DELAY);
+}
+
+/**
+ * @brief Wait to receive a message, for a limited time.
+ *
+ * @param msg - Receives the pointer to the queue buffer with the message.
+ * 				It must be given back by Queue::Free.
+ * @param timeout - The maximum wait in implementation specific units,
+ * 					or timerMAX_DELAY to wait forever.
+ *
+ * @return - The message size if success;
+ * 		   - -ETIMEDOUT if no message arrived in the timeout;
+ * 		   - Another negative value if the wait was interrupted or the queue deleted.
+ */
+ssize_t Queue::Receive(void **msg, timeCount_t timeout)
+{
+#ifdef RT_POSIX
+	uint32_t head, oldest;
+	int32_t distance;
+	queueSlot_t *slot;
+	timeCount_t deadline = 0, now;
+	struct timespec remaining;
+	int waitReturn;
+
+	*msg = NULL;
+
+	if(timeout != timerMAX_DELAY)
+	{
+		deadline = Timer::GetTime() + timeout;
+	}
+
+	for(;;)
+	{
+		head = this->state->head;
+		slot = (queueSlot_t *)(this->slots + (this->readSeq % this->state->depth)*this->slotStride);
+		distance = (int32_t)(slot->sequence - (this->readSeq + 1));
+
+		if(distance == 0)
+		{
+			break;
+		}
+
+		if(distance > 0)
+		{
+			// A receiver that fell more than the queue depth behind lost the oldest messages.
+			oldest = this->state->claim - this->state->depth;
+			if((int32_t)(oldest - this->readSeq) > 0)
+			{
+				this->lostNumber += oldest - this->readSeq;
+				this->readSeq = oldest;
+			}
+			else
+			{
+				this->lostNumber++;
+				this->readSeq++;
+			}
+			continue;
+		}
+
+		if(timeout == timerMAX_DELAY)
+		{
+			waitReturn = FutexWait(&this->state->head, head, NULL);
+		}
+		else
+		{
+			// The futex takes a relative timeout, so it is computed again after each wake up.
+			now = Timer::GetTime();
+			if(now >= deadline)
+			{
+				return -ETIMEDOUT;
+			}
+			remaining.tv_sec = (deadline - now)/1000000000;
+			remaining.tv_nsec = (deadline - now)%1000000000;
+			waitReturn = FutexWait(&this->state->head, head, &remaining);
+		}
+
+		if(waitReturn == EINTR)
+		{
+			return -EINTR;
+		}
+	}
+	__sync_synchronize();
+
+	this->readSeq++;
+
+	*msg = (void *)(slot + 1);
+	return slot->length;
+#else
+	return rt_queue_receive(&(this->queue), msg, (timeout == timerMAX_DELAY)? TM_INFINITE : timeout);
+#endif
+}
+
+/**
+ * @brief Check that a received message was not overwritten by a sender,
+ * 		  which must be done after copying it and before using the copy.
+ *
+ * 		  In Xenomai, the buffer is owned by the receiver until Queue::Free.
+ *
+ * @param msg - The buffer returned by Queue::Receive.
+ *
+ * @return - true if the buffer still has the message;
+ * 		   - false otherwise.
+ */
+bool Queue::IsValid(void *msg)
+{
+#ifdef RT_POSIX
+	queueSlot_t *slot = (queueSlot_t *)msg - 1;
+
+	__sync_synchronize();
+	return slot->sequence == this->readSeq;
+#else
+	(void)msg;
+	return true;
+#endif
+}
+
+/**
+ * @brief Give back the buffer of a received message.
+ *
+ * 		  In POSIX, if the message was overwritten while it was used, it is
+ * 		  counted as lost, because its content may be mixed with the next one.
+ *
+ * @param msg - The buffer returned by Queue::Receive.
+ */
+void Queue::Free(void *msg)
+{
+#ifdef RT_POSIX
+	queueSlot_t *slot = (queueSlot_t *)msg - 1;
+
+	__sync_synchronize();
+	if(slot->sequence != this->readSeq)
+	{
+		this->lostNumber++;
+	}
+#else
+	rt_queue_free(&(this->queue), msg);
+#endif
+}
+
+/**
+ * @brief Delete the queue.
+ */
+void Queue::Delete(void)
+{
+#ifdef RT_POSIX
+	this->shared.Delete();
+#else
+	rt_queue_delete(&(this->queue));
+#endif
+}
+
+/**
+ * @brief Unbind from the queue, which stays valid for the other tasks.
+ */
+void Queue::Unbind(void)
+{
+#ifdef RT_POSIX
+	this->shared.Unbind();
+#else
+	rt_queue_unbind(&(this->queue));
+#endif
+}
+
+/**
+ * @brief Get the number of messages lost by this instance, i.e. overwritten
+ * 		  by the senders before or while being read. Xenomai doesn't lose
+ * 		  messages, since its senders fail when the queue is full.
+ *
+ * @return The number of messages lost since the creation or binding.
+ */
+uint32_t Queue::GetLostNumber(void)
+{
+#ifdef RT_POSIX
+	return this->lostNumber;
+#else
+	return 0;
+#endif
+}
+
+}
@@ -0,0 +1,98 @@
+/**
+ * @file	rtqueue.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the Queue class implementation, which provides
+ * message queues shared between tasks by a common string identifier.
+ */
+
+#ifndef RT_QUEUE_HPP_
+#define RT_QUEUE_HPP_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "rtconfig.hpp"
+#include "timer.hpp"
+#include "rtheap.hpp"
+
+/*IMPLEMENTATION SPECIFIC INCLUDES*/
+/*=======================================================================================*/
+#ifdef RT_POSIX
+#include <pthread.h>
+#else
+#include <alchemy/queue.h>
+#endif
+
+namespace RealTime
+{
+
+#ifdef RT_POSIX
+/**
+ * @brief The process shared header of a Queue instance, followed by the message slots.
+ */
+typedef struct
+{
+	volatile uint32_t initState;
+	volatile uint32_t head; /**< Number of messages sent. It is also the futex word waited by receivers. */
+	volatile uint32_t claim; /**< Sequence of the next message taken by a sender. */
+	uint32_t depth; /**< Number of message slots. */
+	uint32_t slotSize; /**< Maximum message size of each slot. */
+}sharedQueue_t;
+#endif
+
+/**
+ * @brief Class that provides a message queue shared between tasks using a common string identifier.
+ *
+ * 		  A message is sent by taking a buffer with Queue::Alloc, filling it and
+ * 		  passing it to Queue::Send. A message is received as a pointer to the queue
+ * 		  buffer, which must be given back with Queue::Free after its use.
+ */
+class Queue
+{
+public:
+	static const int normal = 0; /**< The message is delivered to one receiver. */
+	static const int broadcast = 1; /**< The message is delivered to all the receivers. */
+private:
+#ifdef RT_POSIX
+	LocalHeap shared;
+	sharedQueue_t *state;
+	uint8_t *slots;
+	size_t slotStride;
+	uint32_t readSeq; /**< Sequence of the next message read by this instance. */
+	uint32_t lostNumber; /**< Messages overwritten before or while being read by this instance. */
+#else
+	RT_QUEUE queue;
+#endif
+public:
+	Queue(void);
+	int Create(const char* name, size_t messageSize, size_t depth);
+	int Bind(const char* name, timeCount_t timeout);
+	void *Alloc(size_t size);
+	int Send(void *msg, size_t size, int mode);
+	ssize_t Receive(void **msg);
+	ssize_t Receive(void **msg, timeCount_t timeout);
+	bool IsValid(void *msg);
+	void Free(void *msg);
+	void Delete(void);
+	void Unbind(void);
+	uint32_t GetLostNumber(void);
+};
+}
+
+#endif /* RT_QUEUE_HPP_ */
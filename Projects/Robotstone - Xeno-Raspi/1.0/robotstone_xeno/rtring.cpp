@@ -0,0 +1,481 @@
+/**
+ * @file	rtring.cpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the Ring class implementation, a lock-free message
+ * ring in shared memory with the same interface of the Queue class. The
+ * messages are passed between processes without system calls, except the
+ * wake-up of receivers that are waiting for a message.
+ */
+
+#include "rtring.hpp"
+#include "realtime.hpp"
+#include <stdio.h>
+#include <errno.h>
+
+#ifdef RT_POSIX
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+ * @brief The header placed before the message in each ring slot.
+ */
+typedef struct
+{
+	volatile uint32_t sequence; /**< The message sequence plus one when the message is complete. */
+	uint32_t length;
+}ringSlot_t;
+
+namespace RealTime
+{
+
+/**
+ * @brief The Ring class constructor.
+ *
+ * 		  The instance must be created or bound later by Ring::Create or Ring::Bind.
+ */
+Ring::Ring(void)
+		: state(NULL), slots(NULL), mask(0), readSeq(0), lostNumber(0)
+{
+
+}
+
+/**
+ * @brief Create a new ring.
+ *
+ * @param name - A null terminated string to identify the ring for sharing.
+ * @param messageSize - The maximum size of each message in bytes.
+ * @param depth - The number of messages kept by the ring, rounded up to a power of two.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Ring::Create(const char* name, size_t messageSize, size_t depth)
+{
+	char sharedName[LocalHeap::maxNameLength];
+	uint32_t slotsNumber = 2;
+	uint32_t stride;
+
+	// With two slots at least, a receiver can always tell a slot being
+	// written for its message from one being overwritten by the next lap.
+	while(slotsNumber < depth)
+	{
+		slotsNumber <<= 1;
+	}
+
+	// Each slot begins in its own cache line.
+	stride = (sizeof(ringSlot_t) + messageSize + Ring::cacheLine - 1) & ~((uint32_t)Ring::cacheLine - 1);
+
+	snprintf(sharedName, sizeof(sharedName), "r_%s", name);
+	if(this->shared.Create(sharedName, sizeof(sharedRing_t) + slotsNumber*stride) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+
+	this->state = (sharedRing_t *)this->shared.Alloc();
+	if(this->state == NULL)
+	{
+		return RealTime::fail;
+	}
+	this->slots = (uint8_t *)(this->state + 1);
+	this->state->depth = slotsNumber;
+	this->state->slotSize = messageSize;
+	this->state->slotStride = stride;
+	this->state->claim = 0;
+	this->state->published = 0;
+	this->state->waiters = 0;
+	this->state->readers = 0;
+
+	for(uint32_t i = 0; i < slotsNumber; ++i)
+	{
+		((ringSlot_t *)(this->slots + i*stride))->sequence = 0;
+	}
+
+	this->mask = slotsNumber - 1;
+	this->readSeq = 0;
+
+#ifndef RT_POSIX
+	snprintf(sharedName, sizeof(sharedName), "e_%s", name);
+	if(rt_event_create(&this->event, sharedName, 0, EV_PRIO))
+	{
+		this->shared.Delete();
+		return RealTime::fail;
+	}
+	this->eventMask = 1 << (__sync_fetch_and_add(&this->state->readers, 1) & 31);
+#endif
+
+	Heap::SetSharedInit(&this->state->initState);
+	return RealTime::ok;
+}
+
+/**
+ * @brief Bind to a ring created by another task.
+ *
+ * @param name - A null terminated string to identify the ring for sharing.
+ * @param timeout - The maximum time to wait the ring creation in implementation specific units.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Ring::Bind(const char* name, timeCount_t timeout)
+{
+	char sharedName[LocalHeap::maxNameLength];
+	size_t size;
+
+	snprintf(sharedName, sizeof(sharedName), "r_%s", name);
+
+	// Map the header first to learn the ring dimensions.
+	if(this->shared.Bind(sharedName, sizeof(sharedRing_t), timeout) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+	this->state = (sharedRing_t *)this->shared.Alloc();
+	if(this->state == NULL)
+	{
+		return RealTime::fail;
+	}
+	Heap::WaitSharedInit(&this->state->initState);
+	size = sizeof(sharedRing_t) + this->state->depth*this->state->slotStride;
+	this->shared.Unbind();
+
+	if(this->shared.Bind(sharedName, size, timeout) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+	this->state = (sharedRing_t *)this->shared.Alloc();
+	if(this->state == NULL)
+	{
+		return RealTime::fail;
+	}
+	this->slots = (uint8_t *)(this->state + 1);
+	this->mask = this->state->depth - 1;
+
+#ifndef RT_POSIX
+	snprintf(sharedName, sizeof(sharedName), "e_%s", name);
+	if(rt_event_bind(&this->event, sharedName, timeout))
+	{
+		this->shared.Unbind();
+		return RealTime::fail;
+	}
+	// Each receiver waits in its own event bit, so a receiver clearing
+	// its bit doesn't lose the wake-up of another one.
+	this->eventMask = 1 << (__sync_fetch_and_add(&this->state->readers, 1) & 31);
+#endif
+
+	// Only the messages sent after the binding are received.
+	this->readSeq = this->state->claim;
+	return RealTime::ok;
+}
+
+/**
+ * @brief Take a ring slot to build a message.
+ *
+ * 		  The senders take the slots with an atomic increment, so
+ * 		  they never wait for each other.
+ *
+ * @param size - The message size in bytes.
+ *
+ * @return - A pointer to the buffer if success;
+ * 		   - NULL otherwise.
+ */
+void *Ring::Alloc(size_t size)
+{
+	uint32_t seq;
+	ringSlot_t *slot;
+
+	if(size > this->state->slotSize)
+	{
+		return NULL;
+	}
+
+	seq = __sync_fetch_and_add(&this->state->claim, 1);
+	slot = (ringSlot_t *)(this->slots + (seq & this->mask)*this->state->slotStride);
+
+	// The slot is tagged with the message being written, until Ring::Send.
+	slot->sequence = seq;
+	__sync_synchronize();
+
+	return (void *)(slot + 1);
+}
+
+/**
+ * @brief Send a message built in a slot taken by Ring::Alloc.
+ *
+ * @param msg - The buffer returned by Ring::Alloc.
+ * @param size - The message size in bytes.
+ * @param mode - Ring::normal or Ring::broadcast, that behave the same.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Ring::Send(void *msg, size_t size, int mode)
+{
+	ringSlot_t *slot = (ringSlot_t *)msg - 1;
+
+	(void)mode;
+
+	slot->length = size;
+	__sync_synchronize();
+	slot->sequence = slot->sequence + 1;
+
+	// The full barrier orders the sequence store before the waiters load,
+	// as the receivers do in the opposite order in Ring::Receive.
+	__sync_fetch_and_add(&this->state->published, 1);
+
+	if(this->state->waiters != 0)
+	{
+		this->Wake();
+	}
+	return RealTime::ok;
+}
+
+/**
+ * @brief Wait to receive a message.
+ *
+ * 		  While a message doesn't arrives, the caller task
+ * 		  will be suspended.
+ *
+ * @param msg - Receives the pointer to the ring slot with the message.
+ * 				It must be given back by Ring::Free.
+ *
+ * @return - The message size if success;
+ * 		   - A negative value if the wait was interrupted.
+ */
+ssize_t Ring::Receive(void **msg)
+{
+	return this->Receive(msg, timerMAX_DELAY);
+}
+
+/**
+ * @brief Wait to receive a message, for a limited time.
+ *
+ * @param msg - Receives the pointer to the ring slot with the message.
+ * 				It must be given back by Ring::Free.
+ * @param timeout - The maximum wait in implementation specific units,
+ * 					or timerMAX_DELAY to wait forever.
+ *
+ * @return - The message size if success;
+ * 		   - -ETIMEDOUT if no message arrived in the timeout;
+ * 		   - Another negative value if the wait was interrupted.
+ */
+ssize_t Ring::Receive(void **msg, timeCount_t timeout)
+{
+	ringSlot_t *slot;
+	int32_t distance;
+	uint32_t published;
+	int waitReturn;
+	timeCount_t deadline = 0, now, remaining = timerMAX_DELAY;
+
+	*msg = NULL;
+
+	if(timeout != timerMAX_DELAY)
+	{
+		deadline = Timer::GetTime() + timeout;
+	}
+
+	for(;;)
+	{
+		slot = (ringSlot_t *)(this->slots + (this->readSeq & this->mask)*this->state->slotStride);
+		distance = (int32_t)(slot->sequence - (this->readSeq + 1));
+
+		if(distance == 0)
+		{
+			break;
+		}
+
+		if(distance > 0)
+		{
+			// The slot has a message of a later lap: skip to the oldest message kept.
+			uint32_t oldest = this->state->claim - this->state->depth;
+
+			if((int32_t)(oldest - this->readSeq) > 0)
+			{
+				this->lostNumber += oldest - this->readSeq;
+				this->readSeq = oldest;
+			}
+			else
+			{
+				this->lostNumber++;
+				this->readSeq++;
+			}
+			continue;
+		}
+
+		// The message is not complete yet.
+		if(timeout != timerMAX_DELAY)
+		{
+			now = Timer::GetTime();
+			if(now >= deadline)
+			{
+				return -ETIMEDOUT;
+			}
+			remaining = deadline - now;
+		}
+
+		published = this->state->published;
+		__sync_fetch_and_add(&this->state->waiters, 1);
+
+		waitReturn = 0;
+		if((int32_t)(slot->sequence - (this->readSeq + 1)) < 0)
+		{
+			waitReturn = this->Wait(published, remaining);
+		}
+
+		__sync_fetch_and_sub(&this->state->waiters, 1);
+
+		if(waitReturn == EINTR)
+		{
+			return -EINTR;
+		}
+	}
+	__sync_synchronize();
+
+	this->readSeq++;
+
+	*msg = (void *)(slot + 1);
+	return slot->length;
+}
+
+/**
+ * @brief Check that a received message was not overwritten by a sender,
+ * 		  which must be done after copying it and before using the copy.
+ *
+ * @param msg - The buffer returned by Ring::Receive.
+ *
+ * @return - true if the slot still has the message;
+ * 		   - false otherwise.
+ */
+bool Ring::IsValid(void *msg)
+{
+	ringSlot_t *slot = (ringSlot_t *)msg - 1;
+
+	__sync_synchronize();
+	return slot->sequence == this->readSeq;
+}
+
+/**
+ * @brief Give back the slot of a received message.
+ *
+ * 		  If the message was overwritten while it was used, it is counted
+ * 		  as lost, because its content may be mixed with the next one.
+ *
+ * @param msg - The buffer returned by Ring::Receive.
+ */
+void Ring::Free(void *msg)
+{
+	ringSlot_t *slot = (ringSlot_t *)msg - 1;
+
+	__sync_synchronize();
+	if(slot->sequence != this->readSeq)
+	{
+		this->lostNumber++;
+	}
+}
+
+/**
+ * @brief Delete the ring.
+ */
+void Ring::Delete(void)
+{
+#ifndef RT_POSIX
+	rt_event_delete(&this->event);
+#endif
+	this->shared.Delete();
+	this->state = NULL;
+}
+
+/**
+ * @brief Unbind from the ring, which stays valid for the other tasks.
+ */
+void Ring::Unbind(void)
+{
+#ifndef RT_POSIX
+	rt_event_unbind(&this->event);
+#endif
+	this->shared.Unbind();
+	this->state = NULL;
+}
+
+/**
+ * @brief Get the number of messages lost by this instance, i.e. overwritten
+ * 		  by the senders before being read.
+ *
+ * @return The number of messages lost since the creation or binding.
+ */
+uint32_t Ring::GetLostNumber(void)
+{
+	return this->lostNumber;
+}
+
+/**
+ * @brief Suspend the caller while no message is sent.
+ *
+ * @param published - The number of messages sent seen by the caller before waiting.
+ * @param timeout - The maximum wait, or timerMAX_DELAY to wait forever.
+ *
+ * @return 0 if woken up or if the timeout expired, or EINTR if unblocked by Task::Unblock.
+ */
+int Ring::Wait(uint32_t published, timeCount_t timeout)
+{
+#ifdef RT_POSIX
+	struct timespec relative;
+	struct timespec *wait = NULL;
+
+	if(timeout != timerMAX_DELAY)
+	{
+		relative.tv_sec = timeout/1000000000;
+		relative.tv_nsec = timeout%1000000000;
+		wait = &relative;
+	}
+
+	if(syscall(SYS_futex, &this->state->published, FUTEX_WAIT, published, wait, NULL, 0) != 0)
+	{
+		return (errno == EINTR)? EINTR : 0;
+	}
+#else
+	unsigned int mask;
+
+	rt_event_clear(&this->event, this->eventMask, NULL);
+	if(this->state->published != published)
+	{
+		return 0;
+	}
+	if(rt_event_wait(&this->event, this->eventMask, &mask, EV_ANY, (timeout == timerMAX_DELAY)? TM_INFINITE : timeout) == -EINTR)
+	{
+		return EINTR;
+	}
+#endif
+	return 0;
+}
+
+/**
+ * @brief Wake up all the receivers waiting for a message.
+ */
+void Ring::Wake(void)
+{
+#ifdef RT_POSIX
+	syscall(SYS_futex, &this->state->published, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+	rt_event_signal(&this->event, ~0U);
+#endif
+}
+
+}
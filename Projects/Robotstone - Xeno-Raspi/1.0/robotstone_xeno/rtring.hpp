@@ -0,0 +1,116 @@
+/**
+ * @file	rtring.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the Ring class implementation, a lock-free message
+ * ring in shared memory with the same interface of the Queue class. The
+ * messages are passed between processes without system calls, except the
+ * wake-up of receivers that are waiting for a message.
+ */
+
+#ifndef RT_RING_HPP_
+#define RT_RING_HPP_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "rtconfig.hpp"
+#include "timer.hpp"
+#include "rtheap.hpp"
+
+/*IMPLEMENTATION SPECIFIC INCLUDES*/
+/*=======================================================================================*/
+#ifndef RT_POSIX
+#include <alchemy/event.h>
+#endif
+
+namespace RealTime
+{
+
+/**
+ * @brief The shared header of a Ring instance, followed by the message slots.
+ *
+ * 		  The sender and receiver fields are in different cache lines, so
+ * 		  the receivers polling for messages don't disturb the senders.
+ */
+typedef struct
+{
+	volatile uint32_t initState;
+	uint32_t depth; /**< Number of message slots, a power of two. */
+	uint32_t slotSize; /**< Maximum message size of each slot. */
+	uint32_t slotStride; /**< Distance in bytes between two slots. */
+	uint8_t pad0[48];
+	volatile uint32_t claim; /**< Sequence of the next message taken by a sender. */
+	uint8_t pad1[60];
+	volatile uint32_t published; /**< Number of messages sent. It is also the futex word waited by receivers. */
+	volatile uint32_t waiters; /**< Number of receivers waiting for a message. */
+	volatile uint32_t readers; /**< Number of instances bound, to give each one an event bit in Xenomai. */
+	uint8_t pad2[52];
+}sharedRing_t;
+
+/**
+ * @brief Class that provides a lock-free message ring shared between tasks using a common string identifier.
+ *
+ * 		  Each slot is tagged with the sequence of its message, so the senders
+ * 		  take slots with one atomic increment and never wait for each other, and
+ * 		  each receiver keeps its own read sequence, so all the receivers get all
+ * 		  the messages (both Ring::normal and Ring::broadcast modes). A receiver
+ * 		  is woken up by the sender only if it is waiting for a message.
+ *
+ * 		  The senders never wait for the receivers: a receiver that falls more
+ * 		  than the ring depth behind skips the overwritten messages, which are
+ * 		  counted by Ring::GetLostNumber.
+ */
+class Ring
+{
+public:
+	static const int normal = 0; /**< Same as Ring::broadcast, kept for compatibility with the Queue class. */
+	static const int broadcast = 1; /**< The message is delivered to all the receivers. */
+	static const size_t cacheLine = 64;
+private:
+	LocalHeap shared;
+	sharedRing_t *state;
+	uint8_t *slots;
+	uint32_t mask; /**< Depth minus one, to index the slots. */
+	uint32_t readSeq; /**< Sequence of the next message read by this instance. */
+	uint32_t lostNumber; /**< Messages overwritten before being read by this instance. */
+#ifndef RT_POSIX
+	RT_EVENT event; /**< Signaled by the senders when there are receivers waiting. */
+	unsigned int eventMask; /**< The event bit waited by this instance. */
+#endif
+public:
+	Ring(void);
+	int Create(const char* name, size_t messageSize, size_t depth);
+	int Bind(const char* name, timeCount_t timeout);
+	void *Alloc(size_t size);
+	int Send(void *msg, size_t size, int mode);
+	ssize_t Receive(void **msg);
+	ssize_t Receive(void **msg, timeCount_t timeout);
+	bool IsValid(void *msg);
+	void Free(void *msg);
+	void Delete(void);
+	void Unbind(void);
+	uint32_t GetLostNumber(void);
+
+private:
+	int Wait(uint32_t published, timeCount_t timeout);
+	void Wake(void);
+};
+}
+
+#endif /* RT_RING_HPP_ */
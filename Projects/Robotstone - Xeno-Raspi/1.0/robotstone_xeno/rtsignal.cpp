@@ -23,13 +23,35 @@
  */
 
 #include "rtsignal.hpp"
+#include "realtime.hpp"
+#include "task.hpp"
 #include <stdio.h>
+#include <errno.h>
+#include <time.h>
 
 #include "test_led.hpp"
 
 namespace RealTime
 {
 
+#ifdef RT_POSIX
+/**
+ * @brief Initialize a mutex that can be shared between processes.
+ *
+ * @param mutex - The mutex inside a shared memory region.
+ */
+static void InitSharedMutex(pthread_mutex_t *mutex)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+	pthread_mutex_init(mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+#endif
+
 /**
  * @brief The Signal class constructor.
  *
@@ -38,6 +60,37 @@ namespace RealTime
 Signal::Signal(const char* name):
 		name(name)
 {
+#ifdef RT_POSIX
+	char sharedName[LocalHeap::maxNameLength];
+	snprintf(sharedName, sizeof(sharedName), "s_%s", name);
+
+	if(this->shared.Bind(sharedName, sizeof(sharedSignal_t), 10000000) == RealTime::ok)
+	{
+		this->state = (sharedSignal_t *)this->shared.Alloc();
+		Heap::WaitSharedInit(&this->state->initState);
+	}
+	else
+	{
+		if(this->shared.Create(sharedName, sizeof(sharedSignal_t)) != RealTime::ok)
+		{
+			Stdout::Print("Impossible create %s Signal.\n", name);
+			exit(1);
+		}
+
+		pthread_condattr_t attr;
+
+		this->state = (sharedSignal_t *)this->shared.Alloc();
+		InitSharedMutex(&this->state->mutex);
+
+		pthread_condattr_init(&attr);
+		pthread_condattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+		pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+		pthread_cond_init(&this->state->cond, &attr);
+		pthread_condattr_destroy(&attr);
+
+		Heap::SetSharedInit(&this->state->initState);
+	}
+#else
 	char mutexName[25];
 	sprintf(mutexName, "mtx_%s", name);
 
@@ -53,6 +106,7 @@ Signal::Signal(const char* name):
 			exit(1);
 		}
 	}
+#endif
 }
 
 /**
@@ -64,11 +118,19 @@ Signal::Signal(const char* name):
  */
 void Signal::SignalizeUni(void)
 {
+#ifdef RT_POSIX
+	pthread_mutex_lock(&this->state->mutex);
+
+	pthread_cond_signal(&this->state->cond);
+
+	pthread_mutex_unlock(&this->state->mutex);
+#else
 	rt_mutex_acquire(&this->mutex, TM_INFINITE);
 
 	rt_cond_signal(&this->cond);
 
 	rt_mutex_release(&this->mutex);
+#endif
 }
 
 /**
@@ -80,11 +142,19 @@ void Signal::SignalizeUni(void)
  */
 void Signal::SignalizeBroad(void)
 {
+#ifdef RT_POSIX
+	pthread_mutex_lock(&this->state->mutex);
+
+	pthread_cond_broadcast(&this->state->cond);
+
+	pthread_mutex_unlock(&this->state->mutex);
+#else
 	rt_mutex_acquire(&this->mutex, TM_INFINITE);
 
 	rt_cond_broadcast(&this->cond);
 
 	rt_mutex_release(&this->mutex);
+#endif
 }
 
 /**
@@ -96,9 +166,15 @@ void Signal::SignalizeBroad(void)
  */
 void Signal::Wait(void)
 {
+#ifdef RT_POSIX
+	pthread_mutex_lock(&this->state->mutex);
+	pthread_cond_wait(&this->state->cond, &this->state->mutex);
+	pthread_mutex_unlock(&this->state->mutex);
+#else
 	rt_mutex_acquire(&this->mutex, TM_INFINITE);
 	rt_cond_wait(&this->cond, &this->mutex, TM_INFINITE);
 	rt_mutex_release(&this->mutex);
+#endif
 
 }
 
@@ -109,4 +185,461 @@ const char* Signal::GetName(void)
 {
 	return this->name;
 }
+
+/**
+ * @brief The ReleaseBarrier class constructor.
+ *
+ * @param name - A null terminated string to identify the barrier for sharing.
+ */
+ReleaseBarrier::ReleaseBarrier(const char* name):
+		name(name)
+{
+	char sharedName[LocalHeap::maxNameLength];
+	snprintf(sharedName, sizeof(sharedName), "b_%s", name);
+
+#ifndef RT_POSIX
+	char condName[LocalHeap::maxNameLength];
+	char mutexName[LocalHeap::maxNameLength];
+	snprintf(condName, sizeof(condName), "bc_%s", name);
+	snprintf(mutexName, sizeof(mutexName), "bm_%s", name);
+#endif
+
+	if(this->shared.Bind(sharedName, sizeof(sharedBarrier_t), 10000000) == RealTime::ok)
+	{
+		this->state = (sharedBarrier_t *)this->shared.Alloc();
+		Heap::WaitSharedInit(&this->state->initState);
+#ifndef RT_POSIX
+		rt_cond_bind(&this->cond, condName, TM_INFINITE);
+		rt_mutex_bind(&this->mutex, mutexName, TM_INFINITE);
+#endif
+		return;
+	}
+
+	if(this->shared.Create(sharedName, sizeof(sharedBarrier_t)) != RealTime::ok)
+	{
+		Stdout::Print("Impossible create %s Barrier.\n", name);
+		exit(1);
+	}
+
+	this->state = (sharedBarrier_t *)this->shared.Alloc();
+	this->state->registered = 0;
+	this->state->arrived = 0;
+	this->state->generation = 0;
+	this->state->releaseTime = 0;
+
+#ifdef RT_POSIX
+	pthread_condattr_t attr;
+
+	InitSharedMutex(&this->state->mutex);
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&this->state->cond, &attr);
+	pthread_condattr_destroy(&attr);
+#else
+	if(rt_cond_create(&this->cond, condName) || rt_mutex_create(&this->mutex, mutexName))
+	{
+		Stdout::Print("Impossible create %s Barrier.\n", name);
+		exit(1);
+	}
+#endif
+
+	Heap::SetSharedInit(&this->state->initState);
+}
+
+/**
+ * @brief Count one more task in the releases. It must be called
+ * 		  before the task waits in the barrier the first time.
+ */
+void ReleaseBarrier::Register(void)
+{
+	this->Lock();
+	this->state->registered++;
+	this->Unlock();
+}
+
+/**
+ * @brief Stop counting a task in the releases. It must not be
+ * 		  waiting in the barrier.
+ */
+void ReleaseBarrier::Unregister(void)
+{
+	this->Lock();
+	this->state->registered--;
+	this->Broadcast();
+	this->Unlock();
+}
+
+/**
+ * @brief Wait for the next release and then for its time instant.
+ *
+ * 		  The caller is counted as arrived until the release.
+ *
+ * @return The release time instant.
+ */
+timeCount_t ReleaseBarrier::Wait(void)
+{
+	uint32_t generation;
+	timeCount_t releaseTime;
+
+	this->Lock();
+
+	this->state->arrived++;
+	generation = this->state->generation;
+
+	// The releaser may be waiting for this arrival.
+	this->Broadcast();
+
+	// The wait may also end by Task::Unblock, so the generation tells the real release.
+	while(this->state->generation == generation)
+	{
+#ifdef RT_POSIX
+		pthread_cond_wait(&this->state->cond, &this->state->mutex);
+#else
+		rt_cond_wait(&this->cond, &this->mutex, TM_INFINITE);
+#endif
+	}
+	releaseTime = this->state->releaseTime;
+
+	this->Unlock();
+
+	Task::DelayUntil(releaseTime);
+
+	return releaseTime;
+}
+
+/**
+ * @brief Wait until all the registered tasks are waiting for the next release.
+ *
+ * @param timeout - The maximum time to wait in implementation specific units.
+ *
+ * @return - RealTime::ok if all the tasks arrived;
+ * 		   - RealTime::fail if the timeout expired.
+ */
+int ReleaseBarrier::WaitArrivals(timeCount_t timeout)
+{
+	timeCount_t deadline = Timer::GetTime() + timeout;
+	int waitReturn = RealTime::ok;
+
+	this->Lock();
+
+	while(this->state->arrived < this->state->registered)
+	{
+		if(Timer::GetTime() >= deadline)
+		{
+			waitReturn = RealTime::fail;
+			break;
+		}
+#ifdef RT_POSIX
+		struct timespec wakeup;
+
+		wakeup.tv_sec = deadline/1000000000;
+		wakeup.tv_nsec = deadline%1000000000;
+		pthread_cond_timedwait(&this->state->cond, &this->state->mutex, &wakeup);
+#else
+		rt_cond_wait_until(&this->cond, &this->mutex, deadline);
+#endif
+	}
+
+	this->Unlock();
+
+	return waitReturn;
+}
+
+/**
+ * @brief Release the tasks waiting in the barrier.
+ *
+ * 		  The release time must leave enough time for all the tasks to
+ * 		  wake up, otherwise the late ones start as soon as they can.
+ *
+ * @param releaseTime - The time instant, in implementation specific units,
+ * 						when all the tasks start.
+ */
+void ReleaseBarrier::Release(timeCount_t releaseTime)
+{
+	this->Lock();
+
+	this->state->releaseTime = releaseTime;
+	this->state->arrived = 0;
+	this->state->generation++;
+	this->Broadcast();
+
+	this->Unlock();
+}
+
+/**
+ * @brief Get the number of tasks counted in the releases.
+ *
+ * @return The number of tasks registered.
+ */
+uint32_t ReleaseBarrier::GetRegistered(void)
+{
+	return this->state->registered;
+}
+
+/**
+ * @brief Get the number of tasks waiting for the next release.
+ *
+ * @return The number of tasks arrived.
+ */
+uint32_t ReleaseBarrier::GetArrived(void)
+{
+	return this->state->arrived;
+}
+
+/**
+ * @brief Get the name which barrier is referred.
+ */
+const char* ReleaseBarrier::GetName(void)
+{
+	return this->name;
+}
+
+/**
+ * @brief Acquire the barrier mutex.
+ */
+void ReleaseBarrier::Lock(void)
+{
+#ifdef RT_POSIX
+	pthread_mutex_lock(&this->state->mutex);
+#else
+	rt_mutex_acquire(&this->mutex, TM_INFINITE);
+#endif
+}
+
+/**
+ * @brief Release the barrier mutex.
+ */
+void ReleaseBarrier::Unlock(void)
+{
+#ifdef RT_POSIX
+	pthread_mutex_unlock(&this->state->mutex);
+#else
+	rt_mutex_release(&this->mutex);
+#endif
+}
+
+/**
+ * @brief Wake up the tasks and the releaser waiting in the barrier.
+ * 		  The barrier mutex must be acquired.
+ */
+void ReleaseBarrier::Broadcast(void)
+{
+#ifdef RT_POSIX
+	pthread_cond_broadcast(&this->state->cond);
+#else
+	rt_cond_broadcast(&this->cond);
+#endif
+}
+
+/**
+ * @brief The Mutex class constructor.
+ *
+ * 		  The instance must be created or bound later by Mutex::Create or Mutex::Bind.
+ */
+Mutex::Mutex(void)
+#ifdef RT_POSIX
+		: state(NULL)
+#endif
+{
+
+}
+
+/**
+ * @brief Create a new mutex.
+ *
+ * @param name - A null terminated string to identify the mutex for sharing.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Mutex::Create(const char* name)
+{
+#ifdef RT_POSIX
+	char sharedName[LocalHeap::maxNameLength];
+	snprintf(sharedName, sizeof(sharedName), "m_%s", name);
+
+	if(this->shared.Create(sharedName, sizeof(sharedMutex_t)) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+
+	this->state = (sharedMutex_t *)this->shared.Alloc();
+	InitSharedMutex(&this->state->mutex);
+	Heap::SetSharedInit(&this->state->initState);
+#else
+	if(rt_mutex_create(&this->mutex, name))
+	{
+		return RealTime::fail;
+	}
+#endif
+	return RealTime::ok;
+}
+
+/**
+ * @brief Bind to a mutex created by another task.
+ *
+ * @param name - A null terminated string to identify the mutex for sharing.
+ * @param timeout - The maximum time to wait the mutex creation in implementation specific units.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Mutex::Bind(const char* name, timeCount_t timeout)
+{
+#ifdef RT_POSIX
+	char sharedName[LocalHeap::maxNameLength];
+	snprintf(sharedName, sizeof(sharedName), "m_%s", name);
+
+	if(this->shared.Bind(sharedName, sizeof(sharedMutex_t), timeout) != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+
+	this->state = (sharedMutex_t *)this->shared.Alloc();
+	Heap::WaitSharedInit(&this->state->initState);
+#else
+	if(rt_mutex_bind(&this->mutex, name, timeout))
+	{
+		return RealTime::fail;
+	}
+#endif
+	return RealTime::ok;
+}
+
+/**
+ * @brief Acquire the mutex, blocking the caller while other task owns it.
+ */
+void Mutex::Acquire(void)
+{
+#ifdef RT_POSIX
+	pthread_mutex_lock(&this->state->mutex);
+#else
+	rt_mutex_acquire(&this->mutex, TM_INFINITE);
+#endif
+}
+
+/**
+ * @brief Release the mutex previously acquired.
+ */
+void Mutex::Release(void)
+{
+#ifdef RT_POSIX
+	pthread_mutex_unlock(&this->state->mutex);
+#else
+	rt_mutex_release(&this->mutex);
+#endif
+}
+
+/**
+ * @brief Delete the mutex.
+ */
+void Mutex::Delete(void)
+{
+#ifdef RT_POSIX
+	this->shared.Delete();
+#else
+	rt_mutex_delete(&this->mutex);
+#endif
+}
+
+/**
+ * @brief Unbind from the mutex, which stays valid for the other tasks.
+ */
+void Mutex::Unbind(void)
+{
+#ifdef RT_POSIX
+	this->shared.Unbind();
+#else
+	rt_mutex_unbind(&this->mutex);
+#endif
+}
+
+/**
+ * @brief The Semaphore class constructor. The semaphore starts with zero count.
+ */
+Semaphore::Semaphore(void)
+{
+#ifdef RT_POSIX
+	if(sem_init(&this->sem, 0, 0) != 0)
+#else
+	if(rt_sem_create(&this->sem, NULL, 0, S_PRIO) != 0)
+#endif
+	{
+		Stdout::Print("Impossible create Semaphore.\n");
+		exit(1);
+	}
+}
+
+/**
+ * @brief Increment the semaphore count, releasing one waiting task.
+ */
+void Semaphore::Post(void)
+{
+#ifdef RT_POSIX
+	sem_post(&this->sem);
+#else
+	rt_sem_v(&this->sem);
+#endif
+}
+
+/**
+ * @brief Wait the semaphore count be positive and decrement it.
+ */
+void Semaphore::Wait(void)
+{
+#ifdef RT_POSIX
+	while(sem_wait(&this->sem) != 0 && errno == EINTR)
+	{
+
+	}
+#else
+	while(rt_sem_p(&this->sem, TM_INFINITE) == -EINTR)
+	{
+
+	}
+#endif
+}
+
+/**
+ * @brief Wait the semaphore count be positive and decrement it, up to a timeout.
+ *
+ * @param timeout - The maximum time to wait in implementation specific units.
+ *
+ * @return - RealTime::ok if the count was decremented;
+ * 		   - RealTime::fail if the timeout expired.
+ */
+int Semaphore::Wait(timeCount_t timeout)
+{
+#ifdef RT_POSIX
+	struct timespec deadline;
+	int waitReturn;
+
+	// sem_timedwait only takes an absolute time of the realtime clock.
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeout/1000000000;
+	deadline.tv_nsec += timeout%1000000000;
+	if(deadline.tv_nsec >= 1000000000)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	while(((waitReturn = sem_timedwait(&this->sem, &deadline)) != 0) && (errno == EINTR))
+	{
+
+	}
+	return (waitReturn == 0)? RealTime::ok : RealTime::fail;
+#else
+	int waitReturn;
+
+	while((waitReturn = rt_sem_p(&this->sem, timeout)) == -EINTR)
+	{
+
+	}
+	return (waitReturn == 0)? RealTime::ok : RealTime::fail;
+#endif
+}
+
 }
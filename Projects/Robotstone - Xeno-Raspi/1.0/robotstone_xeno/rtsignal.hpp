@@ -25,21 +25,71 @@
 
 #ifndef SIGNAL_HPP_
 #define SIGNAL_HPP_
+#include "rtconfig.hpp"
+#ifdef RT_POSIX
+#include <pthread.h>
+#include <semaphore.h>
+#else
 #include <alchemy/cond.h>
 #include <alchemy/mutex.h>
-#include "realtime.hpp"
+#include <alchemy/sem.h>
+#endif
+#include "timer.hpp"
+#include "rtheap.hpp"
 
 namespace RealTime
 {
 
+#ifdef RT_POSIX
+/**
+ * @brief The process shared state of a Signal instance.
+ */
+typedef struct
+{
+	volatile uint32_t initState;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+}sharedSignal_t;
+
+/**
+ * @brief The process shared state of a Mutex instance.
+ */
+typedef struct
+{
+	volatile uint32_t initState;
+	pthread_mutex_t mutex;
+}sharedMutex_t;
+#endif
+
+/**
+ * @brief The process shared state of a ReleaseBarrier instance.
+ */
+typedef struct
+{
+	volatile uint32_t initState;
+#ifdef RT_POSIX
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+#endif
+	uint32_t registered; /**< Number of tasks that take part in the releases. */
+	uint32_t arrived; /**< Number of tasks waiting for the next release. */
+	uint32_t generation; /**< Number of releases done. */
+	timeCount_t releaseTime; /**< The time instant of the last release. */
+}sharedBarrier_t;
+
 /**
  * @brief Class that provides services to signal tasks that a condition was satisfied.
  */
 class Signal
 {
 private:
+#ifdef RT_POSIX
+	LocalHeap shared;
+	sharedSignal_t *state;
+#else
 	RT_COND cond;
 	RT_MUTEX mutex;
+#endif
 	const char* name;
 public:
 	Signal(const char* name);
@@ -48,6 +98,86 @@ public:
 	void Wait(void);
 	const char* GetName(void);
 };
+
+/**
+ * @brief Class that releases a group of tasks at the same time instant,
+ * 		  shared between tasks using a common string identifier.
+ *
+ * 		  The tasks are counted by ReleaseBarrier::Register, so the
+ * 		  releaser knows when all of them are waiting. Unlike the Signal
+ * 		  class, a task that arrives after ReleaseBarrier::Release waits
+ * 		  for the next release, and the releaser sees that it was late.
+ * 		  All the tasks wake up before the release time and wait for it,
+ * 		  so they start together, independently of the wake up order.
+ */
+class ReleaseBarrier
+{
+private:
+	LocalHeap shared;
+	sharedBarrier_t *state;
+#ifndef RT_POSIX
+	RT_COND cond;
+	RT_MUTEX mutex;
+#endif
+	const char* name;
+public:
+	ReleaseBarrier(const char* name);
+	void Register(void);
+	void Unregister(void);
+	timeCount_t Wait(void);
+	int WaitArrivals(timeCount_t timeout);
+	void Release(timeCount_t releaseTime);
+	uint32_t GetRegistered(void);
+	uint32_t GetArrived(void);
+	const char* GetName(void);
+
+private:
+	void Lock(void);
+	void Unlock(void);
+	void Broadcast(void);
+};
+
+/**
+ * @brief Class that provides mutual exclusion between tasks using a common string identifier.
+ */
+class Mutex
+{
+private:
+#ifdef RT_POSIX
+	LocalHeap shared;
+	sharedMutex_t *state;
+#else
+	RT_MUTEX mutex;
+#endif
+public:
+	Mutex(void);
+	int Create(const char* name);
+	int Bind(const char* name, timeCount_t timeout);
+	void Acquire(void);
+	void Release(void);
+	void Delete(void);
+	void Unbind(void);
+};
+
+/**
+ * @brief Class that provides a counting semaphore between the tasks of the same process.
+ *
+ * 		  Unlike the Signal class, a post is never lost if no task is waiting yet.
+ */
+class Semaphore
+{
+private:
+#ifdef RT_POSIX
+	sem_t sem;
+#else
+	RT_SEM sem;
+#endif
+public:
+	Semaphore(void);
+	void Post(void);
+	void Wait(void);
+	int Wait(timeCount_t timeout);
+};
 }
 
 #endif /* SIGNAL_HPP_ */
@@ -38,8 +38,13 @@ namespace Stdout
  */
 void Init(void)
 {
+#ifdef RT_POSIX
+	// Line buffered, so reports from different tasks do not interleave.
+	setvbuf(stdout, NULL, _IOLBF, 0);
+#else
 	// Perform auto-init of rt_print buffers if the task doesn't do so
 	rt_print_auto_init(1);
+#endif
 
 }
 
@@ -53,7 +58,11 @@ void Print(const char *message, ...)
 {
 	va_list args;
 	va_start(args, message);
+#ifdef RT_POSIX
+	vprintf(message, args);
+#else
 	rt_vprintf(message, args);
+#endif
 	va_end(args);
 }
 
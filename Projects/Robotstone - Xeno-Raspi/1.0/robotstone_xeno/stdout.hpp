@@ -27,7 +27,11 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdarg.h>
+#include "rtconfig.hpp"
+#ifndef RT_POSIX
 #include <trank/rtdk.h>
+#endif
 
 namespace RealTime
 {
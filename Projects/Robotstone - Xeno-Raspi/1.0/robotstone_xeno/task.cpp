@@ -24,10 +24,71 @@
 
 
 #include "task.hpp"
+#include "stdout.hpp"
+#include <sched.h>
+
+#ifdef RT_POSIX
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/syscall.h>
+
+/**
+ * @brief Signal sent by Task::Unblock to interrupt a blocking call of the task.
+ */
+#define taskUNBLOCK_SIGNAL SIGUSR1
+
+/**
+ * @brief The minimal stack size given to the threads. The sizes requested
+ * 		  for Xenomai are too small for the glibc functions used by tasks.
+ */
+#define taskMIN_STACK_SIZE ((size_t)PTHREAD_STACK_MIN*4)
+#endif
 
 namespace RealTime
 {
 
+#ifdef RT_POSIX
+static __thread Task *selfTask = NULL; /**< The task instance running in the calling thread. */
+static pthread_once_t unblockOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief The handler of the unblock signal does nothing, it only makes
+ * 		  the blocking call of the thread return with EINTR.
+ */
+static void UnblockHandler(int signal)
+{
+
+}
+
+/**
+ * @brief Install the unblock signal handler, without restarting the interrupted calls.
+ */
+static void InstallUnblockHandler(void)
+{
+	struct sigaction action;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = UnblockHandler;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = 0;
+	sigaction(taskUNBLOCK_SIGNAL, &action, NULL);
+}
+
+/**
+ * @brief The thread entry point, that runs the task code.
+ *
+ * @param task - The Task instance.
+ */
+void* Task::Entry(void *task)
+{
+	selfTask = (Task *)task;
+	selfTask->func(selfTask->args);
+	return NULL;
+}
+#endif
+
 /**
  * @brief The Task class constructor.
  *
@@ -39,13 +100,16 @@ namespace RealTime
  * @param name - A optional task name or "".
  */
 Task::Task(taskCode_t func, uint8_t priority, uint32_t memory, void* args, size_t id, const char* name):
-id(id), validity(1)
+id(id), validity(1), cpu(Task::anyCPU)
 {
 	this->func = func;
 	this->priority = priority;
 	this->memory = memory;
 	this->args = args;
 	this->name = name;
+#ifdef RT_POSIX
+	sem_init(&this->handle.resume, 0, 0);
+#endif
 }
 
 /**
@@ -70,7 +134,7 @@ void* Task::GetArgs(void){
  *
  * @return The task identifier.
  */
-uint8_t Task::GetID(void){
+size_t Task::GetID(void){
 	return this->id;
 }
 
@@ -92,11 +156,58 @@ uint8_t Task::GetPriority(void){
 	return this->priority;	
 }
 
+/**
+ * @brief Set the processor where the task will run. It takes effect
+ * 		  in the next Task::Start.
+ *
+ * @param cpu - The processor number or Task::anyCPU.
+ */
+void Task::SetAffinity(size_t cpu)
+{
+	this->cpu = cpu;
+}
+
 /**
  * @brief Starts the task execution as soon it its turn to use CPU.
  */
 void Task::Start(void)
 {
+#ifdef RT_POSIX
+	pthread_attr_t attr;
+	struct sched_param param;
+	size_t stackSize = this->memory;
+
+	pthread_once(&unblockOnce, InstallUnblockHandler);
+
+	if(stackSize < taskMIN_STACK_SIZE)
+	{
+		stackSize = taskMIN_STACK_SIZE;
+	}
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, stackSize);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	param.sched_priority = this->priority;
+	pthread_attr_setschedparam(&attr, &param);
+
+	if(this->cpu != Task::anyCPU)
+	{
+		cpu_set_t cpus;
+
+		CPU_ZERO(&cpus);
+		CPU_SET(this->cpu, &cpus);
+		pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+	}
+
+	if(pthread_create(&this->handle.thread, &attr, Task::Entry, this) != 0)
+	{
+		Stdout::Print("Impossible create task %d with SCHED_FIFO priority %d.\n", this->id, this->priority);
+		exit(1);
+	}
+
+	pthread_attr_destroy(&attr);
+#else
 	/*
 	* Arguments: &task,
 	*            name,
@@ -110,7 +221,14 @@ void Task::Start(void)
 					this->priority,
 					T_JOINABLE);
 
-	//rt_task_set_affinity(&this->handle, &cpus);
+	if(this->cpu != Task::anyCPU)
+	{
+		cpu_set_t cpus;
+
+		CPU_ZERO(&cpus);
+		CPU_SET(this->cpu, &cpus);
+		rt_task_set_affinity(&this->handle, &cpus);
+	}
 
 	/*
 	* Arguments: &task,
@@ -120,6 +238,7 @@ void Task::Start(void)
 	rt_task_start(&this->handle,
 	              this->func,
 	              (void*)this->args);
+#endif
 }
 
 /**
@@ -163,12 +282,16 @@ taskHandle_t* Task::GetHandle(void){
  */
 size_t Task::GetPID(void)
 {
+#ifdef RT_POSIX
+	return syscall(SYS_gettid);
+#else
 	RT_TASK *task = rt_task_self();
 	RT_TASK_INFO info;
 
 	rt_task_inquire(task, &info);
 
 	return info.pid;
+#endif
 }
 
 /**
@@ -177,7 +300,11 @@ size_t Task::GetPID(void)
  */
 void Task::Join(void)
 {
+#ifdef RT_POSIX
+	pthread_join(this->handle.thread, NULL);
+#else
 	rt_task_join(&this->handle);
+#endif
 }
 
 /**
@@ -185,7 +312,18 @@ void Task::Join(void)
  */
 void Task::Suspend(void)
 {
+#ifdef RT_POSIX
+	if(selfTask == NULL)
+	{
+		return;
+	}
+	while(sem_wait(&selfTask->handle.resume) != 0 && errno == EINTR)
+	{
+
+	}
+#else
 	rt_task_suspend(NULL);
+#endif
 }
 
 /**
@@ -193,7 +331,11 @@ void Task::Suspend(void)
  */
 void Task::Resume(void)
 {
+#ifdef RT_POSIX
+	sem_post(&this->handle.resume);
+#else
 	rt_task_resume(this->GetHandle());
+#endif
 }
 
 /**
@@ -201,7 +343,11 @@ void Task::Resume(void)
  */
 void Task::Unblock(void)
 {
+#ifdef RT_POSIX
+	pthread_kill(this->handle.thread, taskUNBLOCK_SIGNAL);
+#else
 	rt_task_unblock(this->GetHandle());
+#endif
 }
 
 /**
@@ -211,7 +357,15 @@ void Task::Unblock(void)
  */
 void Task::Delay(timeCount_t period)
 {
+#ifdef RT_POSIX
+	struct timespec delay;
+
+	delay.tv_sec = period/1000000000;
+	delay.tv_nsec = period%1000000000;
+	clock_nanosleep(CLOCK_MONOTONIC, 0, &delay, NULL);
+#else
 	rt_task_sleep(period);
+#endif
 }
 
 /**
@@ -221,7 +375,15 @@ void Task::Delay(timeCount_t period)
  */
 void Task::DelayUntil(timeCount_t date)
 {
+#ifdef RT_POSIX
+	struct timespec wakeup;
+
+	wakeup.tv_sec = date/1000000000;
+	wakeup.tv_nsec = date%1000000000;
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL);
+#else
 	rt_task_sleep_until(date);
+#endif
 }
 
 
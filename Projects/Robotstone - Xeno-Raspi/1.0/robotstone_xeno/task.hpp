@@ -40,7 +40,13 @@
 #include <signal.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include "rtconfig.hpp"
+#ifdef RT_POSIX
+#include <pthread.h>
+#include <semaphore.h>
+#else
 #include <alchemy/task.h>
+#endif
 
 
 /*MACROS*/
@@ -53,7 +59,18 @@ namespace RealTime
 /*MODULE TYPES*/
 /*=======================================================================================*/
 typedef void (*taskCode_t)(void*);
+#ifdef RT_POSIX
+/**
+ * @brief The system implementation handler of a task.
+ */
+typedef struct
+{
+	pthread_t thread; /**< The thread running the task code. */
+	sem_t resume; /**< Posted to resume the task from Task::Suspend. */
+}taskHandle_t;
+#else
 typedef RT_TASK taskHandle_t;
+#endif
 
 
 /*CLASSES*/
@@ -68,6 +85,8 @@ public:
 	static const uint8_t  maxPriority 	 = 99;
 	// The minimum priority value of specific implementation.
 	static const uint8_t  minPriority 	 = 1;
+	// Value of Task::SetAffinity to let the system choose the processor.
+	static const size_t anyCPU = (size_t)-1;
 private:
 	void *args;
 	uint32_t memory;
@@ -76,6 +95,7 @@ private:
 	taskHandle_t handle;
 	size_t id;
 	size_t validity;
+	size_t cpu; /**< The processor where the task runs or Task::anyCPU. */
 	const char *name;
 public:
 	Task(taskCode_t code, uint8_t priority, uint32_t memory, void * args, size_t id, const char* name);
@@ -83,9 +103,10 @@ public:
 	bool operator == (const Task& task) const { return this->id == task.id; }
 	bool operator == (const size_t id) const { return this->id == id; }
 	void* GetArgs(void);
-	uint8_t GetID(void);
+	size_t GetID(void);
 	uint32_t GetMemoryLenght(void);
 	uint8_t GetPriority(void);
+	void SetAffinity(size_t cpu);
 	void Start(void);
 	void IncreasePriority(size_t prioInc);
 	taskHandle_t* GetHandle(void);
@@ -98,6 +119,10 @@ public:
 	static void Delay(timeCount_t period);
 	static void DelayUntil(timeCount_t date);
 
+#ifdef RT_POSIX
+private:
+	static void* Entry(void *task);
+#endif
 
 };
 }
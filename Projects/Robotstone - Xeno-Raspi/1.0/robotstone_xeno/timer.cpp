@@ -34,16 +34,58 @@ namespace Timer
 
 static timeCount_t timerPeriod;
 
+/**
+ * @brief A clock offset measured in a synchronization round.
+ */
+typedef struct
+{
+	timeCount_t localTime; /**< The local time of the measurement. */
+	int64_t offset; /**< The other node clock minus the local clock. */
+}peerPoint_t;
+
+/**
+ * @brief The estimate of the other node clock, offset(t) = base + a + b*(t - reference).
+ */
+typedef struct
+{
+	int64_t base; /**< The offset of the first round, so the fit is done in small values. */
+	double a;
+	double b; /**< The drift, in local time units by local time unit. */
+	timeCount_t reference;
+}peerModel_t;
+
+/**
+ * @brief The synchronization state of the clock of another node.
+ */
+typedef struct
+{
+	peerPoint_t points[timerSYNC_ROUNDS]; /**< The points of the last rounds, in a circular buffer. */
+	uint32_t rounds; /**< Number of rounds done. */
+	peerPoint_t roundBest; /**< The sample of the actual round with the smallest round trip. */
+	timeCount_t roundTrip; /**< The round trip of roundBest, or 0 if the round has no sample. */
+	timeCount_t lastRoundTrip; /**< The round trip of the last round. */
+	peerModel_t models[2]; /**< The estimate being used and the one being computed. */
+	volatile uint32_t current; /**< The index in models of the estimate being used. */
+	volatile bool isSynced;
+}peerClock_t;
+
+static peerClock_t peerClocks[timerMAX_PEERS]; /**< The clock of each node, by the node number. */
+
 /**
  * @brief Initialize the services related to timing.
  *
  */
 void Init(void)
 {
+#ifdef RT_POSIX
+	// CLOCK_MONOTONIC is always read in nanoseconds.
+	timerPeriod = 1000000000;
+#else
 	RT_TIMER_INFO timerInfo;
 
 	rt_timer_inquire(&timerInfo);
 	timerPeriod = 1000000000/(timeCount_t)(timerInfo.period);
+#endif
 }
 
 /**
@@ -53,7 +95,14 @@ void Init(void)
  *
  */
 timeCount_t GetTime(void){
+#ifdef RT_POSIX
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((timeCount_t)now.tv_sec)*1000000000 + (timeCount_t)now.tv_nsec;
+#else
 	return (timeCount_t)rt_timer_read();
+#endif
 }
 
 /**
@@ -79,5 +128,193 @@ size_t GetRandomValue(void)
 	value = ((uint8_t)value);
 	return value;
 }
+
+/**
+ * @brief Add a time exchange with the other node to the actual synchronization round.
+ *
+ * 		  A message is sent to the other node, which answers with the times when
+ * 		  it received the message and when it sent the answer. The clock offset
+ * 		  is exact if the two ways take the same time, so from the exchanges of
+ * 		  a round only the one with the smallest round trip is kept: it is the
+ * 		  one less disturbed by queuing and scheduling delays.
+ *
+ * @param sent - The local time when the message was sent.
+ * @param peerReceived - The other node time when the message was received.
+ * @param peerSent - The other node time when the answer was sent.
+ * @param received - The local time when the answer was received.
+ * @param peer - The number of the other node, smaller than timerMAX_PEERS.
+ */
+void AddPeerSample(timeCount_t sent, timeCount_t peerReceived, timeCount_t peerSent, timeCount_t received, size_t peer)
+{
+	peerClock_t *clock;
+	timeCount_t trip = (received - sent) - (peerSent - peerReceived);
+
+	if((peer >= timerMAX_PEERS) || (peerSent < peerReceived) || (received < sent) ||
+	   ((received - sent) < (peerSent - peerReceived)))
+	{
+		return;
+	}
+	clock = &peerClocks[peer];
+
+	// The differences are taken modulo 2^64, so clocks with any origin are compared.
+	if((clock->roundTrip == 0) || (trip < clock->roundTrip))
+	{
+		clock->roundTrip = (trip == 0)? 1 : trip;
+		clock->roundBest.localTime = sent + (received - sent)/2;
+		clock->roundBest.offset = ((int64_t)(peerReceived - sent) + (int64_t)(peerSent - received))/2;
+	}
+}
+
+/**
+ * @brief Finish the actual synchronization round, estimating the offset and the drift
+ * 		  of the other node clock by a linear fit of the offsets of the last rounds.
+ *
+ * 		  The estimate is changed while other tasks may read it, so it is computed
+ * 		  in the unused copy, which then replaces the one in use.
+ *
+ * @param peer - The number of the other node, smaller than timerMAX_PEERS.
+ *
+ * @return - true if success;
+ * 		   - false if the round has no exchange, keeping the actual estimate.
+ */
+bool UpdatePeerClock(size_t peer)
+{
+	peerClock_t *clock;
+	peerModel_t *model;
+	uint32_t points;
+	double x, y, sumX = 0, sumY = 0, sumXX = 0, sumXY = 0, meanX, meanY;
+
+	if((peer >= timerMAX_PEERS) || (peerClocks[peer].roundTrip == 0))
+	{
+		return false;
+	}
+	clock = &peerClocks[peer];
+	model = &clock->models[clock->current ^ 1];
+
+	clock->points[clock->rounds % timerSYNC_ROUNDS] = clock->roundBest;
+	clock->rounds++;
+	clock->lastRoundTrip = clock->roundTrip;
+	clock->roundTrip = 0;
+
+	points = (clock->rounds < timerSYNC_ROUNDS)? clock->rounds : timerSYNC_ROUNDS;
+
+	// The fit is done around the last point, in values small enough for doubles.
+	model->reference = clock->roundBest.localTime;
+	model->base = clock->roundBest.offset;
+
+	for(uint32_t i = 0; i < points; ++i)
+	{
+		x = (double)(int64_t)(clock->points[i].localTime - model->reference);
+		y = (double)(clock->points[i].offset - model->base);
+		sumX += x;
+		sumY += y;
+		sumXX += x*x;
+		sumXY += x*y;
+	}
+
+	meanX = sumX/points;
+	meanY = sumY/points;
+	model->b = 0;
+	if((points > 1) && ((sumXX - sumX*meanX) > 0))
+	{
+		model->b = (sumXY - sumX*meanY)/(sumXX - sumX*meanX);
+	}
+	model->a = meanY - model->b*meanX;
+
+	__sync_synchronize();
+	clock->current ^= 1;
+	clock->isSynced = true;
+	return true;
+}
+
+/**
+ * @brief Indicates if the other node clock was estimated.
+ *
+ * @param peer - The number of the other node.
+ *
+ * @return true if at least one synchronization round was done.
+ */
+bool IsPeerSynced(size_t peer)
+{
+	return (peer < timerMAX_PEERS) && peerClocks[peer].isSynced;
+}
+
+/**
+ * @brief Get the offset of the other node clock in a local time.
+ *
+ * @param model - The estimate of the other node clock.
+ * @param localTime - The local time.
+ *
+ * @return The other node clock minus the local clock.
+ */
+static int64_t GetModelOffset(const peerModel_t *model, timeCount_t localTime)
+{
+	double x = (double)(int64_t)(localTime - model->reference);
+
+	return model->base + (int64_t)(model->a + model->b*x);
+}
+
+/**
+ * @brief Convert a time of the other node clock to the local clock.
+ *
+ * @param peerTime - A time instant given by the other node.
+ * @param peer - The number of the other node.
+ *
+ * @return The same instant in the local clock, or peerTime if the
+ * 		   other node clock was not estimated.
+ */
+timeCount_t FromPeerTime(timeCount_t peerTime, size_t peer)
+{
+	const peerModel_t *model;
+	timeCount_t localTime;
+
+	if(!IsPeerSynced(peer))
+	{
+		return peerTime;
+	}
+	model = &peerClocks[peer].models[peerClocks[peer].current];
+
+	// The offset depends on the local time, so it is taken in a first
+	// approximation of the local time, which is enough for small drifts.
+	localTime = peerTime - GetModelOffset(model, peerTime - model->base);
+	return peerTime - GetModelOffset(model, localTime);
+}
+
+/**
+ * @brief Get the actual offset of the other node clock.
+ *
+ * @param peer - The number of the other node.
+ *
+ * @return The other node clock minus the local clock, in implementation specific units.
+ */
+int64_t GetPeerOffset(size_t peer)
+{
+	return IsPeerSynced(peer)? GetModelOffset(&peerClocks[peer].models[peerClocks[peer].current], GetTime()) : 0;
+}
+
+/**
+ * @brief Get the drift of the other node clock.
+ *
+ * @param peer - The number of the other node.
+ *
+ * @return The other node clock rate minus the local one, relative to the local one.
+ */
+double GetPeerDrift(size_t peer)
+{
+	return IsPeerSynced(peer)? peerClocks[peer].models[peerClocks[peer].current].b : 0.0;
+}
+
+/**
+ * @brief Get the smallest round trip of the last synchronization round, which
+ * 		  bounds the error of the offset estimate.
+ *
+ * @param peer - The number of the other node.
+ *
+ * @return The round trip in implementation specific units.
+ */
+timeCount_t GetPeerRoundTrip(size_t peer)
+{
+	return (peer < timerMAX_PEERS)? peerClocks[peer].lastRoundTrip : 0;
+}
 }
 }
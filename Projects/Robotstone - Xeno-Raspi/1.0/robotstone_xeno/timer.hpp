@@ -27,6 +27,7 @@
 /*MODULE INCLUDES*/
 /*=======================================================================================*/
 #include <stdint.h>
+#include "rtconfig.hpp"
 
 
 /*IMPLEMENTATION SPECIFIC INCLUDES*/
@@ -35,7 +36,11 @@
 #include <signal.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#ifdef RT_POSIX
+#include <time.h>
+#else
 #include <alchemy/timer.h>
+#endif
 
 #define timerMAX_DELAY 0x7FFFFFFFFFFFFFFF
 
@@ -44,11 +49,17 @@ namespace RealTime
 /*MACROS*/
 /*=======================================================================================*/
 
+#define timerSYNC_ROUNDS 16 /**< Number of clock synchronization rounds used to estimate the offset and the drift of the other node clock. */
+#define timerMAX_PEERS 16 /**< The clocks of the nodes numbered from 0 to timerMAX_PEERS - 1 may be estimated. */
 
 /*MODULE TYPES*/
 /*=======================================================================================*/
 
+#ifdef RT_POSIX
+typedef unsigned long long timeCount_t; /**< This type corresponds to time values related to the system specific units (ns)*/
+#else
 typedef RTIME timeCount_t; /**< This type corresponds to time values related to the system specific units*/
+#endif
 #define tCFormat "%lld" /**< String formatter for timeCount_t values. */
 
 /*CLASSES*/
@@ -67,6 +78,20 @@ timeCount_t GetTime(void);
 timeCount_t GetPeriod(void);
 
 size_t GetRandomValue(void);
+
+void AddPeerSample(timeCount_t sent, timeCount_t peerReceived, timeCount_t peerSent, timeCount_t received, size_t peer = 0);
+
+bool UpdatePeerClock(size_t peer = 0);
+
+bool IsPeerSynced(size_t peer = 0);
+
+timeCount_t FromPeerTime(timeCount_t peerTime, size_t peer = 0);
+
+int64_t GetPeerOffset(size_t peer = 0);
+
+double GetPeerDrift(size_t peer = 0);
+
+timeCount_t GetPeerRoundTrip(size_t peer = 0);
 }
 }
 
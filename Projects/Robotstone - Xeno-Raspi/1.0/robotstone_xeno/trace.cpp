@@ -0,0 +1,426 @@
+/**
+ * @file	trace.cpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the activation trace of the synthetic tasks. Each task
+ * writes one record per job in its own TraceRing and a low priority task
+ * of the Tracer class moves the records to a binary file.
+ */
+
+#include "trace.hpp"
+#include "rtheap.hpp"
+#include "stdout.hpp"
+#include "realtime.hpp"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+taskFUNCTION(DrainCode, arg);
+
+/*TRACE RING METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief TraceRing class constructor.
+ *
+ * 		  The records memory is taken later by TraceRing::Init.
+ */
+TraceRing::TraceRing(void):
+		records(NULL), head(0), tail(0), dropped(0)
+{
+
+}
+
+/**
+ * @brief Take the records memory, so no allocation happens while the task is running.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int TraceRing::Init(void)
+{
+	if(this->records != NULL)
+	{
+		return RealTime::ok;
+	}
+
+	this->records = (traceRecord_t *)RealTime::Heap::Alloc(TraceRing::capacity*sizeof(traceRecord_t));
+
+	return (this->records != NULL)? RealTime::ok : RealTime::fail;
+}
+
+/**
+ * @brief Take the oldest record from the ring.
+ *
+ * @param record - Receives a copy of the record.
+ *
+ * @return true - if a record was taken;
+ * 		   false - if the ring is empty.
+ */
+bool TraceRing::Pop(traceRecord_t *record)
+{
+	uint32_t actualTail = this->tail;
+
+	if(actualTail == this->head)
+	{
+		return false;
+	}
+
+	// Read the record only after seeing the head that published it.
+	__sync_synchronize();
+	*record = this->records[actualTail & (TraceRing::capacity - 1)];
+
+	// The slot can only be reused after the copy.
+	__sync_synchronize();
+	this->tail = actualTail + 1;
+
+	return true;
+}
+
+/**
+ * @brief Get the number of records discarded because the ring was full.
+ *
+ * @return The number of dropped records.
+ */
+uint32_t TraceRing::GetDropped(void)
+{
+	return this->dropped;
+}
+
+/**
+ * @brief Clear the dropped records counter. It must be called
+ * 		  while the producer task is not running.
+ */
+void TraceRing::ClearDropped(void)
+{
+	this->dropped = 0;
+}
+
+/*TRACER METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief Tracer class constructor.
+ *
+ * 		  No file is written until Tracer::Open is called.
+ */
+Tracer::Tracer(void):
+		rings(NULL),
+		ringsNumber(0),
+		ringsSize(0),
+		fd(-1),
+		map(NULL),
+		mapSize(0),
+		fileLength(0),
+		recordCount(0),
+		step(0),
+		stop(0),
+		isEnabled(false),
+		isStarted(false),
+		fileName(""),
+		drainTask(DrainCode, Tracer::drainPriority, Tracer::drainStackSize, (void*)this, 0, ""),
+		release(),
+		parked()
+{
+
+}
+
+/**
+ * @brief Create the trace file, discarding a previous one with the same name.
+ *
+ * @param fileName - The file path.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail otherwise.
+ */
+int Tracer::Open(const char *fileName)
+{
+	traceFileHeader_t header;
+
+	this->fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if(this->fd < 0)
+	{
+		RealTime::Stdout::Print("Impossible create the trace file %s.\n", fileName);
+		return RealTime::fail;
+	}
+	this->fileName = fileName;
+
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, traceFILE_MAGIC, sizeof(header.magic));
+	header.version = traceFILE_VERSION;
+	header.recordSize = sizeof(traceRecord_t);
+	header.timerPeriod = RealTime::Timer::GetPeriod();
+
+	this->Write(&header, sizeof(header));
+	this->Sync();
+	this->isEnabled = true;
+
+	return RealTime::ok;
+}
+
+/**
+ * @brief Register the ring of a synthetic task to be drained.
+ *
+ * 		  It must be called while the drain task is parked. The ring
+ * 		  memory is taken only if the trace file is open.
+ *
+ * @param ring - The ring of the synthetic task.
+ *
+ * @return - RealTime::ok if success;
+ * 		   - RealTime::fail if the ring or the rings table cannot be allocated.
+ */
+int Tracer::Register(TraceRing *ring)
+{
+	if(!this->isEnabled)
+	{
+		return RealTime::ok;
+	}
+
+	if(ring->Init() != RealTime::ok)
+	{
+		return RealTime::fail;
+	}
+
+	if(this->ringsNumber == this->ringsSize)
+	{
+		size_t size = (this->ringsSize == 0) ? Tracer::ringsInitialSize : this->ringsSize*2;
+		TraceRing **table = (TraceRing **)RealTime::Heap::Alloc(size*sizeof(TraceRing *));
+
+		if(table == NULL)
+		{
+			return RealTime::fail;
+		}
+
+		if(this->rings != NULL)
+		{
+			memcpy(table, this->rings, this->ringsNumber*sizeof(TraceRing *));
+			RealTime::Heap::Free(this->rings);
+		}
+		this->rings = table;
+		this->ringsSize = size;
+	}
+	this->rings[this->ringsNumber++] = ring;
+
+	return RealTime::ok;
+}
+
+/**
+ * @brief Release the drain task for a test step.
+ *
+ * 		  The task is only created in the first call. After each test step
+ * 		  it stays parked waiting the next release.
+ *
+ * @param step - The test step number saved in the records.
+ */
+void Tracer::Start(uint16_t step)
+{
+	if(!this->isEnabled)
+	{
+		return;
+	}
+
+	this->step = step;
+	this->stop = 0;
+
+	if(!this->isStarted)
+	{
+		this->drainTask.Start();
+		this->isStarted = true;
+	}
+	this->release.Post();
+}
+
+/**
+ * @brief Park the drain task after it moves all the records of the test step
+ * 		  and update the file. It must be called after the synthetic tasks finish.
+ */
+void Tracer::Stop(void)
+{
+	if(!this->isEnabled)
+	{
+		return;
+	}
+
+	this->stop = 1;
+	this->drainTask.Unblock();
+	this->parked.Wait();
+
+	this->Sync();
+}
+
+/**
+ * @brief Get the number of records saved in the trace file.
+ *
+ * @return The number of records.
+ */
+uint64_t Tracer::GetRecordCount(void)
+{
+	return this->recordCount;
+}
+
+/**
+ * @brief Get the trace file name.
+ *
+ * @return The trace file name.
+ */
+const char* Tracer::GetFileName(void)
+{
+	return this->fileName;
+}
+
+/**
+ * @brief Verify if the trace file was opened by Tracer::Open.
+ *
+ * @return true - if the records are saved;
+ * 		   false - otherwise.
+ */
+bool Tracer::IsEnabled(void)
+{
+	return this->isEnabled;
+}
+
+/**
+ * @brief Move all the records available in the rings to the file.
+ */
+void Tracer::Drain(void)
+{
+	traceRecord_t record;
+
+	for(size_t i = 0; i < this->ringsNumber; ++i)
+	{
+		while(this->rings[i]->Pop(&record))
+		{
+			record.step = this->step;
+			this->Write(&record, sizeof(record));
+			if(this->fd >= 0)
+			{
+				this->recordCount++;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Append data to the file, enlarging its mapping when necessary.
+ *
+ * @param data - The data to be copied.
+ * @param size - The data size in bytes.
+ */
+void Tracer::Write(const void *data, size_t size)
+{
+	if(this->fd < 0)
+	{
+		return;
+	}
+
+	if(this->fileLength + size > this->mapSize)
+	{
+		if(this->map != NULL)
+		{
+			munmap(this->map, this->mapSize);
+		}
+
+		// Tracer::Sync unmaps the file, so the size is taken from the file length.
+		this->mapSize = ((this->fileLength + size + Tracer::fileGrowSize - 1)/Tracer::fileGrowSize)*Tracer::fileGrowSize;
+
+		if(ftruncate(this->fd, this->mapSize) != 0)
+		{
+			this->map = (uint8_t *)MAP_FAILED;
+		}
+		else
+		{
+			this->map = (uint8_t *)mmap(NULL, this->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+		}
+
+		if(this->map == (uint8_t *)MAP_FAILED)
+		{
+			RealTime::Stdout::Print("Impossible enlarge the trace file %s. Trace stopped.\n", this->fileName);
+			close(this->fd);
+			this->fd = -1;
+			this->map = NULL;
+			this->mapSize = 0;
+			return;
+		}
+	}
+
+	memcpy(this->map + this->fileLength, data, size);
+	this->fileLength += size;
+}
+
+/**
+ * @brief Update the header and cut the unused end of the file, so it
+ * 		  stays valid if the executable finishes before the next test step.
+ */
+void Tracer::Sync(void)
+{
+	// Nothing was written since the last update.
+	if((this->fd < 0) || (this->map == NULL))
+	{
+		return;
+	}
+
+	((traceFileHeader_t *)this->map)->recordCount = this->recordCount;
+
+	munmap(this->map, this->mapSize);
+	this->map = NULL;
+	this->mapSize = 0;
+
+	if(ftruncate(this->fd, this->fileLength) != 0)
+	{
+		RealTime::Stdout::Print("Impossible update the trace file %s.\n", this->fileName);
+	}
+}
+
+/**
+ * @brief The code executed by the drain task.
+ *
+ * 		  The task runs with the lowest priority, so the records are moved
+ * 		  only when the synthetic tasks are not running.
+ *
+ * @arg - The Tracer instance.
+ *
+ */
+taskFUNCTION(DrainCode, arg)
+{
+	Tracer *tracer = (Tracer *)arg;
+
+	// The task drains one test step in each iteration and
+	// stays parked between them.
+	while(true)
+	{
+		tracer->release.Wait();
+
+		while(!tracer->stop)
+		{
+			tracer->Drain();
+			RealTime::Task::Delay(RealTime::Timer::GetPeriod()/10);
+		}
+
+		// Take the records completed before the synthetic tasks stopped.
+		tracer->Drain();
+
+		tracer->parked.Post();
+	}
+}
+
+/***************************************************************************************
+ * END: Module - trace.cpp
+ ***************************************************************************************/
@@ -0,0 +1,179 @@
+/**
+ * @file	trace.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the activation trace of the synthetic tasks. Each task
+ * writes one record per job in its own TraceRing and a low priority task
+ * of the Tracer class moves the records to a binary file.
+ */
+
+#ifndef TRACE_MACRO_HPP
+#define TRACE_MACRO_HPP
+
+/*MODULE INCLUDES*/
+/*=======================================================================================*/
+#include <stdint.h>
+#include <stddef.h>
+#include "timer.hpp"
+#include "task.hpp"
+#include "rtsignal.hpp"
+
+/*MACROS*/
+/*=======================================================================================*/
+
+#define traceFILE_MAGIC "RSTRACE" /**< The first bytes of a trace file. */
+#define traceFILE_VERSION 2
+
+/*MODULE TYPES*/
+/*=======================================================================================*/
+
+/**
+ * @brief The trace record of a synthetic task job.
+ *
+ * 		  The time values are in implementation specific units,
+ * 		  given by the timerPeriod field of the file header.
+ */
+typedef struct
+{
+	uint64_t activationTime; /**< The job release time. */
+	uint64_t startTime; /**< The time when the task began to run the job. */
+	uint64_t completeTime; /**< The time when the job was completed. */
+	uint32_t ceilingPeriod; /**< Number of periods spent by the job. Bigger than 1 means a missed deadline. */
+	uint32_t pubMessageSize; /**< The size of the message sent in the job, or 0. */
+	uint32_t subMessageSize; /**< The size of the message received in the job, or 0. */
+	uint16_t step; /**< The test step number, filled by the Tracer. */
+	uint16_t taskID;
+}traceRecord_t;
+
+/**
+ * @brief The header at the beginning of a trace file, followed by the records.
+ */
+typedef struct
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t recordSize;
+	uint64_t timerPeriod; /**< Number of time units in one second. */
+	uint64_t recordCount; /**< Number of records in the file. */
+}traceFileHeader_t;
+
+/*CLASSES*/
+/*=======================================================================================*/
+
+/**
+ * @brief Single producer and single consumer ring of trace records.
+ *
+ * 		  The producer is the synthetic task and the consumer is the Tracer drain task.
+ * 		  Pushing a record doesn't lock, allocate or call the system. When the ring is
+ * 		  full the record is discarded and counted as dropped. The records memory is
+ * 		  taken by TraceRing::Init, and while it isn't the records are discarded.
+ */
+class TraceRing
+{
+public:
+	static const uint32_t capacity = 4096; /**< Number of records. Must be a power of 2. */
+private:
+	traceRecord_t *records;
+	volatile uint32_t head; /**< Written only by the producer. */
+	volatile uint32_t tail; /**< Written only by the consumer. */
+	volatile uint32_t dropped;
+public:
+	TraceRing(void);
+	int Init(void);
+	bool Pop(traceRecord_t *record);
+	uint32_t GetDropped(void);
+	void ClearDropped(void);
+
+	/**
+	 * @brief Put a record in the ring.
+	 *
+	 * @param record - The record to be copied.
+	 */
+	inline void Push(const traceRecord_t& record)
+	{
+		uint32_t actualHead = this->head;
+
+		if(this->records == NULL)
+		{
+			return;
+		}
+
+		if((actualHead - this->tail) >= TraceRing::capacity)
+		{
+			this->dropped++;
+			return;
+		}
+
+		this->records[actualHead & (TraceRing::capacity - 1)] = record;
+
+		// The record must be visible before the consumer sees the new head.
+		__sync_synchronize();
+		this->head = actualHead + 1;
+	}
+};
+
+/**
+ * @brief Moves the records of the registered rings to a binary file
+ * 		  mapped in memory, by means of a low priority task.
+ */
+class Tracer
+{
+public:
+	static const size_t ringsInitialSize = 16; /**< The rings table is doubled when it is full. */
+	static const uint8_t drainPriority = RealTime::Task::minPriority; /**< Below all the synthetic tasks. */
+	static const uint32_t drainStackSize = 1200;
+	static const size_t fileGrowSize = 1048576; /**< The file is enlarged in steps of this size in bytes. */
+private:
+	TraceRing **rings;
+	size_t ringsNumber;
+	size_t ringsSize;
+	int fd;
+	uint8_t *map;
+	size_t mapSize;
+	size_t fileLength; /**< Number of bytes written in the file. */
+	uint64_t recordCount;
+	uint16_t step;
+	volatile uint8_t stop;
+	bool isEnabled; /**< Set by Tracer::Open. Otherwise the rings are not allocated and no task drains them. */
+	bool isStarted; /**< The drain task is created in the first test step. */
+	const char *fileName;
+	RealTime::Task drainTask;
+	RealTime::Semaphore release; /**< Posted by Tracer::Start to wake the parked drain task. */
+	RealTime::Semaphore parked; /**< Posted by the drain task when it moves all the records of a test step. */
+public:
+	Tracer(void);
+	int Open(const char *fileName);
+	int Register(TraceRing *ring);
+	void Start(uint16_t step);
+	void Stop(void);
+	uint64_t GetRecordCount(void);
+	const char* GetFileName(void);
+	bool IsEnabled(void);
+
+private:
+	friend taskFUNCTION(DrainCode, arg);
+	void Drain(void);
+	void Write(const void *data, size_t size);
+	void Sync(void);
+};
+
+#endif // TRACE_MACRO_HPP
+/***************************************************************************************
+ * END: Module - trace.hpp
+ ***************************************************************************************/
@@ -0,0 +1,451 @@
+/**
+ * @file	workload.cpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the synthetic workloads executed by the synthetic tasks.
+ * Each kind of workload stresses a different part of the processor and has its
+ * own work unit, so its speed is measured in units per second, like the
+ * Whetstone raw speed in KWIPS.
+ */
+
+#include "workload.hpp"
+#include "whetstone.h"
+#include "rtheap.hpp"
+#include "stdout.hpp"
+#include <iostream> //for use of new(pointer)
+#include <stdlib.h>
+
+/*WORKLOAD METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief Workload class constructor.
+ *
+ * @param kind - The workload kind.
+ */
+Workload::Workload(size_t kind):
+		kind(kind)
+{
+
+}
+
+/**
+ * @brief Create a workload.
+ *
+ * @param kind - One of the Workload kinds.
+ * @param workingSet - The memory in bytes walked by the memory workloads.
+ *
+ * @return The workload instance.
+ */
+Workload* Workload::Create(size_t kind, size_t workingSet)
+{
+	static WhetstoneWorkload whetstoneInstance;
+	void *p;
+
+	if(workingSet < Workload::minWorkingSet)
+	{
+		workingSet = Workload::minWorkingSet;
+	}
+
+	switch(kind)
+	{
+	case Workload::whetstone:
+		return &whetstoneInstance;
+	case Workload::memStream:
+		p = Workload::AllocSet(sizeof(StreamWorkload));
+		return new(p) StreamWorkload(workingSet);
+	case Workload::pointerChase:
+		p = Workload::AllocSet(sizeof(PointerChaseWorkload));
+		return new(p) PointerChaseWorkload(workingSet);
+	case Workload::integer:
+		p = Workload::AllocSet(sizeof(IntegerWorkload));
+		return new(p) IntegerWorkload();
+	case Workload::matrix:
+		p = Workload::AllocSet(sizeof(MatrixWorkload));
+		return new(p) MatrixWorkload();
+	default:
+		RealTime::Stdout::Print("Unknown workload kind %d.\n", kind);
+		exit(1);
+	}
+}
+
+/**
+ * @brief Get the workload kind.
+ *
+ * @return The workload kind.
+ */
+size_t Workload::GetKind(void)
+{
+	return this->kind;
+}
+
+/**
+ * @brief Measure the workload speed.
+ *
+ * 		  The workload is executed in batches until the sum of their execution
+ * 		  times reaches the interval, as done for the processor raw speed.
+ *
+ * @param interval - The measurement interval in implementation specific unit.
+ * @param batch - The number of units executed in each iteration.
+ *
+ * @return The workload speed in units per second.
+ */
+uint64_t Workload::Calibrate(RealTime::timeCount_t interval, uint32_t batch)
+{
+	RealTime::timeCount_t startTime, periodReached = 0;
+	uint64_t executed = 0;
+
+	while(periodReached < interval)
+	{
+		startTime = RealTime::Timer::GetTime();
+
+		this->Execute(batch);
+
+		periodReached += RealTime::Timer::GetTime() - startTime;
+		executed += batch;
+	}
+
+	return (uint64_t)(((double)executed)*((double)RealTime::Timer::GetPeriod())/((double)periodReached));
+}
+
+/**
+ * @brief Allocates the memory of a workload, finishing the
+ * 		  executable if it is not available.
+ *
+ * @param size - The memory size in bytes.
+ *
+ * @return A pointer to the memory.
+ */
+void* Workload::AllocSet(size_t size)
+{
+	void *p = RealTime::Heap::Alloc(size);
+
+	if(p == NULL)
+	{
+		RealTime::Stdout::Print("Impossible allocate the workload memory.\n");
+		exit(1);
+	}
+
+	return p;
+}
+
+/*WHETSTONE WORKLOAD METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief WhetstoneWorkload class constructor.
+ */
+WhetstoneWorkload::WhetstoneWorkload(void):
+		Workload(Workload::whetstone)
+{
+
+}
+
+/**
+ * @brief Execute the Whetstone modules.
+ *
+ * @param units - The number of KWI.
+ */
+void WhetstoneWorkload::Execute(uint32_t units)
+{
+	WHETSTONE_EXECUTE(units);
+}
+
+const char* WhetstoneWorkload::GetName(void)
+{
+	return "Whetstone";
+}
+
+const char* WhetstoneWorkload::GetUnitName(void)
+{
+	return "KWI";
+}
+
+/*STREAM WORKLOAD METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief StreamWorkload class constructor.
+ *
+ * @param workingSet - The size in bytes of the three arrays together.
+ */
+StreamWorkload::StreamWorkload(size_t workingSet):
+		Workload(Workload::memStream),
+		position(0)
+{
+	this->length = (workingSet/(3*sizeof(double)*StreamWorkload::unitElements))*StreamWorkload::unitElements;
+
+	if(this->length == 0)
+	{
+		this->length = StreamWorkload::unitElements;
+	}
+
+	this->a = (double *)Workload::AllocSet(this->length*sizeof(double));
+	this->b = (double *)Workload::AllocSet(this->length*sizeof(double));
+	this->c = (double *)Workload::AllocSet(this->length*sizeof(double));
+
+	for(size_t i = 0; i < this->length; ++i)
+	{
+		this->b[i] = 1.0;
+		this->c[i] = 2.0;
+	}
+}
+
+/**
+ * @brief Execute the streaming triad, continuing where the last call stopped.
+ *
+ * @param units - The number of KiB processed in each array.
+ */
+void StreamWorkload::Execute(uint32_t units)
+{
+	const double scalar = 3.0;
+	double *a = this->a, *b = this->b, *c = this->c;
+	size_t i = this->position;
+
+	for(uint32_t u = 0; u < units; ++u)
+	{
+		for(size_t end = i + StreamWorkload::unitElements; i < end; ++i)
+		{
+			a[i] = b[i] + scalar*c[i];
+		}
+
+		if(i == this->length)
+		{
+			i = 0;
+		}
+	}
+
+	this->position = i;
+}
+
+const char* StreamWorkload::GetName(void)
+{
+	return "Memory stream";
+}
+
+const char* StreamWorkload::GetUnitName(void)
+{
+	return "KiB";
+}
+
+/*POINTER CHASE WORKLOAD METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief PointerChaseWorkload class constructor.
+ *
+ * 		  The nodes are linked in a single random cycle by the Sattolo
+ * 		  algorithm, so the hardware prefetcher can't predict the next load.
+ *
+ * @param workingSet - The size in bytes of the walked memory.
+ */
+PointerChaseWorkload::PointerChaseWorkload(size_t workingSet):
+		Workload(Workload::pointerChase),
+		position(0)
+{
+	const size_t stride = PointerChaseWorkload::lineSize/sizeof(size_t);
+	size_t nodesNumber = workingSet/PointerChaseWorkload::lineSize;
+	size_t j, next;
+	uint32_t seed = 2463534242u;
+
+	this->nodes = (size_t *)Workload::AllocSet(nodesNumber*PointerChaseWorkload::lineSize);
+
+	for(size_t i = 0; i < nodesNumber; ++i)
+	{
+		this->nodes[i*stride] = i*stride;
+	}
+
+	for(size_t i = nodesNumber - 1; i > 0; --i)
+	{
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		j = seed % i;
+
+		next = this->nodes[i*stride];
+		this->nodes[i*stride] = this->nodes[j*stride];
+		this->nodes[j*stride] = next;
+	}
+}
+
+/**
+ * @brief Walk the cycle, continuing where the last call stopped.
+ *
+ * @param units - The number of 1024 loads.
+ */
+void PointerChaseWorkload::Execute(uint32_t units)
+{
+	size_t *nodes = this->nodes;
+	size_t p = this->position;
+
+	for(uint32_t u = 0; u < units; ++u)
+	{
+		for(uint32_t i = 0; i < PointerChaseWorkload::unitLoads; ++i)
+		{
+			p = nodes[p];
+		}
+	}
+
+	this->position = p;
+}
+
+const char* PointerChaseWorkload::GetName(void)
+{
+	return "Pointer chasing";
+}
+
+const char* PointerChaseWorkload::GetUnitName(void)
+{
+	return "KLoad";
+}
+
+/*INTEGER WORKLOAD METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief IntegerWorkload class constructor.
+ */
+IntegerWorkload::IntegerWorkload(void):
+		Workload(Workload::integer),
+		state(2463534242u),
+		result(0)
+{
+
+}
+
+/**
+ * @brief Execute the integer kernel.
+ *
+ * @param units - The number of 1024 iterations.
+ */
+void IntegerWorkload::Execute(uint32_t units)
+{
+	uint32_t x = this->state, acc = this->result;
+
+	for(uint32_t u = 0; u < units; ++u)
+	{
+		for(uint32_t i = 0; i < IntegerWorkload::unitIterations; ++i)
+		{
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+
+			if(x & 1)
+			{
+				acc += x >> 3;
+			}
+			else
+			{
+				acc -= x;
+			}
+
+			switch((x >> 8) & 3)
+			{
+			case 0:
+				acc += 7;
+				break;
+			case 1:
+				acc *= 3;
+				break;
+			case 2:
+				acc ^= x;
+				break;
+			default:
+				acc >>= 1;
+			}
+		}
+	}
+
+	this->state = x;
+	this->result = acc;
+}
+
+const char* IntegerWorkload::GetName(void)
+{
+	return "Integer";
+}
+
+const char* IntegerWorkload::GetUnitName(void)
+{
+	return "KIter";
+}
+
+/*MATRIX WORKLOAD METHODS*/
+/*=======================================================================================*/
+
+/**
+ * @brief MatrixWorkload class constructor.
+ */
+MatrixWorkload::MatrixWorkload(void):
+		Workload(Workload::matrix)
+{
+	const size_t n = MatrixWorkload::order;
+
+	this->a = (double *)Workload::AllocSet(n*n*sizeof(double));
+	this->b = (double *)Workload::AllocSet(n*n*sizeof(double));
+	this->c = (double *)Workload::AllocSet(n*n*sizeof(double));
+
+	for(size_t i = 0; i < n*n; ++i)
+	{
+		this->a[i] = 1.0/(double)(i + 1);
+		this->b[i] = 1.0 - this->a[i];
+	}
+}
+
+/**
+ * @brief Execute the matrix product C = A*B.
+ *
+ * @param units - The number of products.
+ */
+void MatrixWorkload::Execute(uint32_t units)
+{
+	const size_t n = MatrixWorkload::order;
+	double *a = this->a, *b = this->b, *c = this->c;
+	double sum;
+
+	for(uint32_t u = 0; u < units; ++u)
+	{
+		for(size_t i = 0; i < n; ++i)
+		{
+			for(size_t j = 0; j < n; ++j)
+			{
+				sum = 0;
+				for(size_t k = 0; k < n; ++k)
+				{
+					sum += a[i*n + k]*b[k*n + j];
+				}
+				c[i*n + j] = sum;
+			}
+		}
+	}
+}
+
+const char* MatrixWorkload::GetName(void)
+{
+	return "Dense matrix";
+}
+
+const char* MatrixWorkload::GetUnitName(void)
+{
+	return "Product";
+}
+
+/***************************************************************************************
+ * END: Module - workload.cpp
+ ***************************************************************************************/
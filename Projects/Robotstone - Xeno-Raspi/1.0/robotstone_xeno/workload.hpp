@@ -0,0 +1,176 @@
+/**
+ * @file	workload.hpp
+ * @author  Matheus Leitzke Pinto <matheus.pinto@ifsc.edu.br>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * This module contains the synthetic workloads executed by the synthetic tasks.
+ * Each kind of workload stresses a different part of the processor and has its
+ * own work unit, so its speed is measured in units per second, like the
+ * Whetstone raw speed in KWIPS.
+ */
+
+#ifndef WORKLOAD_MACRO_HPP
+#define WORKLOAD_MACRO_HPP
+
+/*MODULE INCLUDES*/
+/*=======================================================================================*/
+#include <stdint.h>
+#include <stddef.h>
+#include "timer.hpp"
+
+/*CLASSES*/
+/*=======================================================================================*/
+
+/**
+ * @brief The interface of all the synthetic workloads.
+ *
+ * 		  The memory used by a workload is taken when it is created,
+ * 		  so Workload::Execute doesn't allocate or call the system.
+ */
+class Workload
+{
+public:
+	static const size_t whetstone = 0; /**< Floating point Whetstone loops. Unit: 1 KWI. */
+	static const size_t memStream = 1; /**< Streaming triad over the working set. Unit: 1 KiB of each array. */
+	static const size_t pointerChase = 2; /**< Dependent loads over the working set. Unit: 1024 loads. */
+	static const size_t integer = 3; /**< Integer arithmetic with data dependent branches. Unit: 1024 iterations. */
+	static const size_t matrix = 4; /**< Dense matrix multiplication. Unit: one 16x16 product. */
+	static const size_t kindsNumber = 5;
+	static const size_t minWorkingSet = 4096; /**< The smallest working set in bytes. */
+
+	static Workload* Create(size_t kind, size_t workingSet);
+
+	/**
+	 * @brief Execute the workload.
+	 *
+	 * @param units - The number of work units.
+	 */
+	virtual void Execute(uint32_t units) = 0;
+
+	/**
+	 * @brief Get the workload kind name.
+	 */
+	virtual const char* GetName(void) = 0;
+
+	/**
+	 * @brief Get the name of the work unit.
+	 */
+	virtual const char* GetUnitName(void) = 0;
+
+	size_t GetKind(void);
+	uint64_t Calibrate(RealTime::timeCount_t interval, uint32_t batch);
+
+protected:
+	size_t kind;
+
+	Workload(size_t kind);
+	virtual ~Workload(void) {}
+	static void* AllocSet(size_t size);
+};
+
+/**
+ * @brief The original Robotstone workload, executing the Whetstone modules.
+ *
+ * 		  It has no state, so all the tasks share a single instance.
+ */
+class WhetstoneWorkload: public Workload
+{
+public:
+	WhetstoneWorkload(void);
+	void Execute(uint32_t units);
+	const char* GetName(void);
+	const char* GetUnitName(void);
+};
+
+/**
+ * @brief Streaming kernel (a = b + s*c) limited by the memory bandwidth
+ * 		  when the working set is bigger than the caches.
+ */
+class StreamWorkload: public Workload
+{
+public:
+	static const size_t unitElements = 1024/sizeof(double);
+private:
+	double *a, *b, *c;
+	size_t length; /**< Number of elements in each array. */
+	size_t position; /**< Where the next unit begins. */
+public:
+	StreamWorkload(size_t workingSet);
+	void Execute(uint32_t units);
+	const char* GetName(void);
+	const char* GetUnitName(void);
+};
+
+/**
+ * @brief Walks a random cycle over the cache lines of the working set, so each
+ * 		  load depends on the previous one and the memory latency is exposed.
+ */
+class PointerChaseWorkload: public Workload
+{
+public:
+	static const size_t lineSize = 64; /**< One node per cache line. */
+	static const uint32_t unitLoads = 1024;
+private:
+	size_t *nodes;
+	size_t position; /**< The node where the walk stopped. */
+public:
+	PointerChaseWorkload(size_t workingSet);
+	void Execute(uint32_t units);
+	const char* GetName(void);
+	const char* GetUnitName(void);
+};
+
+/**
+ * @brief Integer kernel with branches that depend on pseudo random data,
+ * 		  which stresses the integer units and the branch predictor.
+ */
+class IntegerWorkload: public Workload
+{
+public:
+	static const uint32_t unitIterations = 1024;
+private:
+	uint32_t state; /**< The pseudo random generator state, kept between calls. */
+	volatile uint32_t result; /**< Keeps the compiler from removing the kernel. */
+public:
+	IntegerWorkload(void);
+	void Execute(uint32_t units);
+	const char* GetName(void);
+	const char* GetUnitName(void);
+};
+
+/**
+ * @brief Dense matrix multiplication kernel (C = A*B), limited by the
+ * 		  floating point throughput since the matrices fit in the L1 cache.
+ */
+class MatrixWorkload: public Workload
+{
+public:
+	static const size_t order = 16;
+private:
+	double *a, *b, *c;
+public:
+	MatrixWorkload(void);
+	void Execute(uint32_t units);
+	const char* GetName(void);
+	const char* GetUnitName(void);
+};
+
+#endif // WORKLOAD_MACRO_HPP
+/***************************************************************************************
+ * END: Module - workload.hpp
+ ***************************************************************************************/